@@ -83,6 +83,7 @@ void c_dd_sincosh(const double *a, double *s, double *c);
 
 void c_dd_read(const char *s, double *a);
 void c_dd_swrite(const double *a, int precision, char *s, int len);
+void c_dd_swrite_hex(const double *a, char *s, int len);
 void c_dd_write(const double *a);
 void c_dd_neg(const double *a, double *b);
 void c_dd_rand(double *a);
@@ -35,6 +35,10 @@
 #include <limits>
 #include <qd/qd_config.h>
 #include <qd/fpu.h>
+#if QD_HAVE_CXX17
+#include <charconv>
+#include <string_view>
+#endif
 
 // Some compilers define isnan, isfinite, and isinf as macros, even for
 // C++ codes, which cause havoc when overloading these functions.  We undef
@@ -62,9 +66,9 @@
 struct QD_API dd_real {
   double x[2];
 
-  dd_real(double hi, double lo) { x[0] = hi; x[1] = lo; }
-  dd_real() {x[0] = 0.0; x[1] = 0.0; }
-  dd_real(double h) { x[0] = h; x[1] = 0.0; }
+  constexpr dd_real(double hi, double lo) : x{hi, lo} {}
+  constexpr dd_real() : x{0.0, 0.0} {}
+  constexpr dd_real(double h) : x{h, 0.0} {}
   dd_real(int h) {
     x[0] = (static_cast<double>(h));
     x[1] = 0.0;
@@ -145,10 +149,15 @@ struct QD_API dd_real {
   void to_digits(char *s, int &expn, int precision = _ndigits) const;
   void write(char *s, int len, int precision = _ndigits, 
       bool showpos = false, bool uppercase = false) const;
+  /* With fmt == std::hexfloat the limbs are written exactly in
+     hexadecimal, and read parses them back bit for bit. */
   std::string to_string(int precision = _ndigits, int width = 0, 
       std::ios_base::fmtflags fmt = static_cast<std::ios_base::fmtflags>(0), 
       bool showpos = false, bool uppercase = false, char fill = ' ') const;
   int read(const char *s, dd_real &a);
+#if QD_HAVE_CXX17
+  static const char *parse(std::string_view s, dd_real &a);
+#endif
 
   /* Debugging Methods */
   void dump(const std::string &name = "", std::ostream &os = std::cerr) const;
@@ -158,6 +167,39 @@ struct QD_API dd_real {
   static dd_real debug_rand();
 };
 
+#if QD_HAVE_CXX17
+inline constexpr dd_real dd_real::_2pi = dd_real(6.283185307179586232e+00,
+                                                 2.449293598294706414e-16);
+inline constexpr dd_real dd_real::_pi = dd_real(3.141592653589793116e+00,
+                                                1.224646799147353207e-16);
+inline constexpr dd_real dd_real::_pi2 = dd_real(1.570796326794896558e+00,
+                                                 6.123233995736766036e-17);
+inline constexpr dd_real dd_real::_pi4 = dd_real(7.853981633974482790e-01,
+                                                 3.061616997868383018e-17);
+inline constexpr dd_real dd_real::_3pi4 = dd_real(2.356194490192344837e+00,
+                                                  9.1848509936051484375e-17);
+inline constexpr dd_real dd_real::_e = dd_real(2.718281828459045091e+00,
+                                               1.445646891729250158e-16);
+inline constexpr dd_real dd_real::_log2 = dd_real(6.931471805599452862e-01,
+                                                  2.319046813846299558e-17);
+inline constexpr dd_real dd_real::_log10 = dd_real(2.302585092994045901e+00,
+                                                   -2.170756223382249351e-16);
+inline constexpr dd_real dd_real::_nan = 
+    dd_real(std::numeric_limits<double>::quiet_NaN(),
+            std::numeric_limits<double>::quiet_NaN());
+inline constexpr dd_real dd_real::_inf = 
+    dd_real(std::numeric_limits<double>::infinity(),
+            std::numeric_limits<double>::infinity());
+
+inline constexpr double dd_real::_eps = 4.93038065763132e-32;  // 2^-104
+inline constexpr double dd_real::_min_normalized = 2.0041683600089728e-292;  // = 2^(-1022 + 53)
+inline constexpr dd_real dd_real::_max = 
+    dd_real(1.79769313486231570815e+308, 9.97920154767359795037e+291);
+inline constexpr dd_real dd_real::_safe_max = 
+    dd_real(1.7976931080746007281e+308, 9.97920154767359795037e+291);
+inline constexpr int dd_real::_ndigits = 31;
+#endif
+
 
 namespace std {
   template <>
@@ -255,6 +297,17 @@ QD_API dd_real ldexp(const dd_real &a, int exp);
 QD_API dd_real log(const dd_real &a);
 QD_API dd_real log10(const dd_real &a);
 
+/* Precision-tunable versions of exp, log, sin and cos.  exp returns a
+   result with relative error about 2^-bits; log, sin and cos return a
+   result with absolute error about 2^-bits * max(1, |result|).  Requests
+   of at most 50 bits are answered in double precision after reducing
+   the argument.  There is no cheaper level in between: every larger
+   request runs the full precision table-driven kernel.                */
+QD_API dd_real exp(const dd_real &a, int bits);
+QD_API dd_real log(const dd_real &a, int bits);
+QD_API dd_real sin(const dd_real &a, int bits);
+QD_API dd_real cos(const dd_real &a, int bits);
+
 QD_API dd_real sin(const dd_real &a);
 QD_API dd_real cos(const dd_real &a);
 QD_API dd_real tan(const dd_real &a);
@@ -265,6 +318,13 @@ QD_API dd_real acos(const dd_real &a);
 QD_API dd_real atan(const dd_real &a);
 QD_API dd_real atan2(const dd_real &y, const dd_real &x);
 
+/* Error function, complementary error function, gamma function and
+   log |Gamma|. */
+QD_API dd_real erf(const dd_real &a);
+QD_API dd_real erfc(const dd_real &a);
+QD_API dd_real tgamma(const dd_real &a);
+QD_API dd_real lgamma(const dd_real &a);
+
 QD_API dd_real sinh(const dd_real &a);
 QD_API dd_real cosh(const dd_real &a);
 QD_API dd_real tanh(const dd_real &a);
@@ -282,6 +342,25 @@ QD_API dd_real fmod(const dd_real &a, const dd_real &b);
 
 QD_API std::ostream& operator<<(std::ostream &s, const dd_real &a);
 QD_API std::istream& operator>>(std::istream &s, dd_real &a);
+
+#if QD_HAVE_CXX17
+/* Writes a to [first, last) in the manner of std::to_chars, without
+   allocating; ties are rounded away from zero.  Without a precision,
+   as few significant digits are written as are needed for
+   dd_real::parse to read back a to within dd_real::_eps ("shortest
+   within eps"); this is not an exact round trip, since the value
+   read back may differ from a in its last bits.
+   std::chars_format::hex writes the limbs exactly, as hexadecimal
+   floating-point numbers joined by their signs (0x1.8p+0-0x1p-60);
+   precision is ignored for it.                                    */
+QD_API std::to_chars_result to_chars(char *first, char *last, 
+                                     const dd_real &a);
+QD_API std::to_chars_result to_chars(char *first, char *last, 
+                                     const dd_real &a, std::chars_format fmt);
+QD_API std::to_chars_result to_chars(char *first, char *last, 
+                                     const dd_real &a, std::chars_format fmt,
+                                     int precision);
+#endif
 #ifdef QD_INLINE
 #include <qd/dd_inline.h>
 #endif
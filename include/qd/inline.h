@@ -50,8 +50,8 @@
 namespace qd {
 
 #if !QD_GPU
-static const QDT _d_nan = std::numeric_limits<QDT>::quiet_NaN();
-static const QDT _d_inf = std::numeric_limits<QDT>::infinity();
+static constexpr QDT _d_nan = std::numeric_limits<QDT>::quiet_NaN();
+static constexpr QDT _d_inf = std::numeric_limits<QDT>::infinity();
 #else
 #endif
     
@@ -90,7 +90,7 @@ inline QDT two_diff(QDT a, QDT b, QD_ASQ QDT &err) {
   return s;
 }
 
-#if QD_GPU
+#ifdef __METAL_VERSION__
 #ifndef QD_FMS
 #error QD_FMS should be defined when using metal
 #endif
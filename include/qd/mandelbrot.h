@@ -0,0 +1,373 @@
+/*
+ * include/mandelbrot.h
+ *
+ * Deep zoom rendering of the Mandelbrot set by perturbation.
+ *
+ * A single reference orbit Z(n+1) = Z(n)^2 + C is computed in qd_real
+ * at the center C of the view.  Each pixel c = C + dc then iterates
+ * only its difference dz(n) = z(n) - Z(n) from the reference,
+ *
+ *   dz(n+1) = (2 Z(n) + dz(n)) dz(n) + dc,
+ *
+ * in double precision, with Z(n) rounded to double.  This is accurate
+ * as long as |dz| stays small compared to |Z|, and costs about as much
+ * as iterating in double, at any depth where the pixel size is a
+ * normal double.  Rows of pixels are spread over a thread pool.
+ *
+ * Before that, a series approximation skips the first iterations,
+ * during which all pixels move alike: dz(n) is expanded as a
+ * polynomial in dc,
+ *
+ *   dz(n) = a(1,n) dc + a(2,n) dc^2 + ... + a(K,n) dc^K,
+ *
+ *   a(k,n+1) = 2 Z(n) a(k,n) + sum(i+j=k) a(i,n) a(j,n) + [k == 1],
+ *
+ * and the coefficients are iterated in dd_real until the truncation
+ * error reaches a tolerance.  Every pixel then starts from the
+ * polynomial at the last valid step.
+ *
+ * Where |z| becomes much smaller than |Z| the delta loses its
+ * precision and the pixel is "glitched".  Such pixels are detected in
+ * the loop, following Pauldelbrot, by |z(n)| < tolerance |Z(n)|, and
+ * also when they outlive the reference.  A new reference is then
+ * taken among the glitched pixels and only they are rendered again,
+ * until none remain.
+ *
+ * The image is cut into square tiles, which the threads of a
+ * work-stealing pool take in turn, so that expensive regions near the
+ * set do not leave threads idle.  It can be rendered coarse to fine:
+ * with P passes, the first iterates every 2^(P-1)-th pixel in each
+ * direction, each later pass halves the spacing, and the pixels not
+ * yet iterated are interpolated in between.  qd_mandel_renderer runs
+ * this in the background and restarts when the view changes.
+ *
+ * Along with z each pixel tracks dz/dc, which gives the distance
+ * estimate 2 |z| log|z| / |dz/dc| to the set for escaping pixels.  It
+ * also scales an optional periodicity check: when z comes back within
+ * tolerance pixels' worth of |dz/dc| of an earlier value, and one
+ * period later has come closer still, the pixel is on an attracting
+ * cycle and stops instead of running to max_iter.  Pixels near the
+ * boundary by the estimate can be supersampled.  dz/dc is iterated
+ * only when one of these needs it.
+ *
+ * The reference orbit is a long serial computation in qd_real.  Across
+ * the frames of an animation a qd_mandel_orbit_cache keeps orbits and
+ * reuses one whose C is close enough to the new center, since
+ * perturbation works from any reference near the view.  The best
+ * reference is a nucleus, whose orbit is periodic and never escapes;
+ * qd_mandel_find_nucleus locates one of a given period by Newton's
+ * method, and qd_mandel_orbit_cache::add makes it the reference of the
+ * views around it.
+ */
+#ifndef _QD_MANDELBROT_H
+#define _QD_MANDELBROT_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <qd/qd_config.h>
+#include <qd/qd_real.h>
+
+/* The region to render: width x height pixels centered on re + i im,
+   with 2 radius / width between pixel centers.  Row 0 is the top.  */
+struct qd_mandel_view {
+  qd_real re, im;
+  double radius;
+  int width, height;
+  int max_iter;
+
+  explicit qd_mandel_view(const qd_real &re = 0.0, const qd_real &im = 0.0,
+                          double radius = 2.0, int width = 640,
+                          int height = 480, int max_iter = 1000)
+    : re(re), im(im), radius(radius), width(width), height(height),
+      max_iter(max_iter) {}
+};
+
+/* How each pixel is iterated. */
+enum qd_mandel_kernel {
+  qd_mandel_perturbation,  /* double deltas against qd_real references */
+  qd_mandel_direct_dd,     /* z itself in dd_real */
+  qd_mandel_direct_qd      /* z itself in qd_real */
+};
+
+class qd_mandel_orbit_cache;
+
+/* Options of qd_mandel_render. */
+struct qd_mandel_options {
+  double bailout;          /* escape radius */
+  int nthreads;            /* <= 0 means all hardware threads */
+  int series_terms;        /* terms of the series; 0 disables it */
+  double series_tolerance; /* relative truncation error allowed */
+  double glitch_tolerance; /* |z| / |Z| below which a pixel glitches;
+                              0 disables the detection              */
+  int max_references;      /* reference orbits per pass, >= 1 */
+  qd_mandel_kernel kernel;
+  int passes;              /* coarse to fine passes, 1 to 16 */
+  int tile_size;           /* side of the tiles in pixels */
+  qd_mandel_orbit_cache *orbit_cache;  /* source of the first reference,
+                                          or null to compute it       */
+  double periodicity_tolerance;  /* in pixels, e.g. 1e-8; 0 (the
+                                    default) disables the check    */
+  int antialias;           /* points per pixel and axis near the
+                              boundary, 1 to 16; 1 disables it      */
+  double antialias_distance;  /* "near", in pixels */
+
+  explicit qd_mandel_options(double bailout = 256.0, int nthreads = 0,
+                             int series_terms = 8,
+                             double series_tolerance = 1e-12,
+                             double glitch_tolerance = 1e-2,
+                             int max_references = 64,
+                             qd_mandel_kernel kernel = qd_mandel_perturbation,
+                             int passes = 1, int tile_size = 32,
+                             qd_mandel_orbit_cache *orbit_cache = 0,
+                             double periodicity_tolerance = 0.0,
+                             int antialias = 1,
+                             double antialias_distance = 1.0)
+    : bailout(bailout), nthreads(nthreads), series_terms(series_terms),
+      series_tolerance(series_tolerance),
+      glitch_tolerance(glitch_tolerance), max_references(max_references),
+      kernel(kernel), passes(passes), tile_size(tile_size),
+      orbit_cache(orbit_cache), periodicity_tolerance(periodicity_tolerance),
+      antialias(antialias), antialias_distance(antialias_distance) {}
+};
+
+/* Timing and work counts of a render. */
+struct qd_mandel_stats {
+  double seconds;              /* total wall time */
+  double reference_seconds;    /* of which computing reference orbits */
+  double iterations;           /* per-pixel iterations performed */
+  int reference_length;        /* iterations of the first reference */
+  int series_skip;             /* iterations skipped by the series */
+  int references;              /* reference orbits computed */
+  int glitched;                /* pixels glitched with the first one */
+  bool reference_cached;       /* the first one came from the cache */
+  int periodic;                /* pixels found interior before max_iter */
+  int supersampled;            /* pixels antialiased */
+
+  qd_mandel_stats()
+    : seconds(0.0), reference_seconds(0.0), iterations(0.0),
+      reference_length(0), series_skip(0), references(0), glitched(0),
+      reference_cached(false), periodic(0), supersampled(0) {}
+
+  double iterations_per_second() const {
+    return (seconds > 0.0) ? iterations / seconds : 0.0;
+  }
+};
+
+/* A reference orbit: Z(0) = 0, ..., Z(size()-1) as double-doubles
+   split into arrays of their leading and trailing limbs; the pixels
+   only read the leading ones.  The orbit stops after max_iter
+   iterations or at the first Z(n) with |Z(n)| > bailout, which is
+   then its last element.                                          */
+struct QD_API qd_mandel_orbit {
+  qd_real re, im;              /* C */
+  int max_iter;
+  double bailout;
+  std::vector<double> zr, zi;  /* leading limbs */
+  std::vector<double> zr_lo, zi_lo;
+
+  qd_mandel_orbit() : max_iter(0), bailout(0.0) {}
+
+  /* Iterates from C = re + i im in qd_real. */
+  void compute(const qd_real &re, const qd_real &im, int max_iter,
+               double bailout);
+
+  int size() const { return static_cast<int>(zr.size()); }
+
+  /* Bytes held by the arrays. */
+  size_t bytes() const { return 4 * zr.size() * sizeof(double); }
+};
+
+/* Series approximation of the deltas of an orbit, for |dc| <= radius.
+   The coefficients are kept scaled as b(k) = a(k) radius^k, so that
+   they stay within the range of double at any depth, and dz(skip) is
+   the polynomial sum b(k) u^k in u = dc / radius.                  */
+struct QD_API qd_mandel_series {
+  int skip;                    /* step the polynomial is valid at */
+  double radius;
+  std::vector<double> br, bi;  /* b(1), ..., b(K) */
+
+  qd_mandel_series() : skip(0), radius(0.0) {}
+
+  /* Iterates terms coefficients along orbit while the truncation error,
+     estimated by the last coefficient and checked against directly
+     iterated deltas at four points of |dc| = radius, stays below
+     tolerance times |dz|, and no further than step limit if limit is
+     not negative.  Returns skip.                                     */
+  int compute(const qd_mandel_orbit &orbit, double radius, int terms,
+              double tolerance, int limit = -1);
+
+  /* dz(skip) for dc = radius * (ur + i ui). */
+  void evaluate(double ur, double ui, double &dzr, double &dzi) const;
+
+  /* d dz(skip) / d dc at the same point. */
+  void derivative(double ur, double ui, double &dr, double &di) const;
+};
+
+/* Value of the pixels that did not escape within max_iter iterations. */
+const float qd_mandel_interior = -1.0f;
+
+/* Renders v into counts, which is resized to width * height values in
+   row-major order.  Escaping pixels get the smooth iteration count
+   n + 1 - log2(log|z(n)| / log(bailout)), the others
+   qd_mandel_interior.  If stats is not null it receives the timings.
+   Returns 0 on success and -1 if the view or the options are invalid,
+   with errno set to EINVAL.                                        */
+QD_API int qd_mandel_render(const qd_mandel_view &v, std::vector<float> &counts,
+                            const qd_mandel_options &opt = qd_mandel_options(),
+                            qd_mandel_stats *stats = 0);
+
+/* Same as above, also setting distance to the distance estimate of
+   each pixel to the set, in pixels, or 0 for interior pixels.      */
+QD_API int qd_mandel_render(const qd_mandel_view &v, std::vector<float> &counts,
+                            std::vector<float> &distance,
+                            const qd_mandel_options &opt = qd_mandel_options(),
+                            qd_mandel_stats *stats = 0);
+
+/* A nucleus: the center of a hyperbolic component (a disc, or the
+   cardioid of a miniature set), where the orbit of 0 is periodic and
+   z(period) = 0.  Its atom domain is the region around it where
+   |z(period)| is smaller than every earlier |z(q)|; size estimates its
+   radius as |z(q)| / |dz(q)/dc| at the nucleus, for the q < period
+   with the smallest |z(q)|, and is infinite for period 1.          */
+struct qd_mandel_nucleus {
+  qd_real re, im;
+  int period;                  /* least period */
+  double size;                 /* atom domain size */
+  int steps;                   /* Newton steps taken */
+
+  qd_mandel_nucleus() : period(0), size(0.0), steps(0) {}
+};
+
+/* Finds the nucleus of period period nearest to re + i im by Newton's
+   method on z(period) = 0, iterating z and dz/dc in dd_real while the
+   steps are large and in qd_real for the last ones.  The nucleus found
+   may have a least period dividing period.  Returns 0 on success, or
+   -1 with errno set to EINVAL if period or max_steps is below 1, or to
+   EDOM if the method does not converge within max_steps steps.     */
+QD_API int qd_mandel_find_nucleus(const qd_real &re, const qd_real &im,
+                                  int period, qd_mandel_nucleus &nucleus,
+                                  int max_steps = 64);
+
+/* Reference orbits kept for the following views, least recently used
+   first out.  An orbit serves a view with center c, escape radius
+   bailout and max_iter iterations if it was computed with the same
+   bailout, covers max_iter iterations and its C lies within
+   reuse_radius * v.radius of c.  Orbits beyond memory_limit bytes
+   are written with qd_write_array, as dd_real arrays in the structure
+   of arrays layout, to files in spill_dir and mapped back when
+   needed, or dropped if spill_dir is null.  The files are removed
+   with the cache.  It may be shared between threads.               */
+class QD_API qd_mandel_orbit_cache {
+public:
+  explicit qd_mandel_orbit_cache(size_t memory_limit = 256 << 20,
+                                 const char *spill_dir = 0,
+                                 double reuse_radius = 2.0);
+  ~qd_mandel_orbit_cache();
+
+  /* An orbit for v, from the cache or computed and added to it.
+     hit, if not null, is set to whether it came from the cache.   */
+  std::shared_ptr<const qd_mandel_orbit> get(const qd_mandel_view &v,
+                                             double bailout, bool *hit = 0);
+
+  /* Computes the orbit of C = re + i im, for max_iter iterations and
+     escape radius bailout, and keeps it for the views near it.  This
+     lets a nucleus found by qd_mandel_find_nucleus, whose orbit never
+     escapes, serve as the reference of the views around it.        */
+  std::shared_ptr<const qd_mandel_orbit> add(const qd_real &re,
+                                             const qd_real &im, int max_iter,
+                                             double bailout);
+
+  /* Removes all orbits and their files. */
+  void clear();
+
+  size_t size() const;         /* orbits kept, in memory or on disk */
+  size_t memory() const;       /* bytes of the orbits in memory */
+  size_t spilled() const;      /* orbits on disk only */
+
+private:
+  qd_mandel_orbit_cache(const qd_mandel_orbit_cache &);
+  qd_mandel_orbit_cache &operator=(const qd_mandel_orbit_cache &);
+
+  struct entry {
+    qd_real re, im;
+    int max_iter;
+    double bailout;
+    int length;                                     /* size() - 1 */
+    std::shared_ptr<const qd_mandel_orbit> orbit;  /* null if on disk */
+    std::string path;                               /* empty if none */
+    unsigned long long used;
+  };
+
+  std::shared_ptr<const qd_mandel_orbit> find(const qd_mandel_view &v,
+                                              double bailout);
+  std::shared_ptr<const qd_mandel_orbit>
+  insert(const std::shared_ptr<qd_mandel_orbit> &orbit);
+  int load(entry &e);
+  void evict(const entry *keep);
+  void remove(entry &e);
+
+  size_t memory_limit;
+  std::string spill_dir;
+  double reuse_radius;
+  mutable std::mutex m;
+  std::vector<entry> entries;
+  unsigned long long clock;
+  size_t in_memory;
+  unsigned files;
+};
+
+namespace qd_cpu { class thread_pool; }
+
+/* Renders one view at a time on a thread of its own, pass by pass
+   (see opt.passes).  Starting a view cancels the one in progress.  */
+class QD_API qd_mandel_renderer {
+public:
+  /* Called on the rendering thread after each pass, with its number. */
+  typedef std::function<void(int)> callback;
+
+  explicit qd_mandel_renderer(const qd_mandel_options &opt = qd_mandel_options(),
+                              const callback &on_pass = callback());
+  ~qd_mandel_renderer();
+
+  /* Cancels the current view and starts v.  Returns 0, or -1 with
+     errno set to EINVAL if v or the options are invalid.           */
+  int start(const qd_mandel_view &v);
+
+  /* Stops the current view at its next pixel. */
+  void cancel();
+
+  /* Waits for the current view; returns true if it was completed. */
+  bool wait();
+
+  /* Copies the image as of the last finished pass into counts and
+     returns the number of that pass, 0 if none has finished.       */
+  int snapshot(std::vector<float> &counts) const;
+
+  /* Statistics of the last completed view. */
+  qd_mandel_stats stats() const;
+
+private:
+  qd_mandel_renderer(const qd_mandel_renderer &);
+  qd_mandel_renderer &operator=(const qd_mandel_renderer &);
+  void run();
+
+  qd_mandel_options opt;
+  callback on_pass;
+  std::unique_ptr<qd_cpu::thread_pool> pool;
+  std::thread thread;
+  std::atomic<bool> cancelled;
+
+  mutable std::mutex m;        /* guards the members below */
+  qd_mandel_view view;
+  std::vector<float> image;
+  int passes_done;
+  bool completed;
+  qd_mandel_stats last_stats;
+};
+
+#endif /* _QD_MANDELBROT_H */
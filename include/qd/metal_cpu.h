@@ -0,0 +1,301 @@
+//
+//  metal_cpu.h
+//
+//  Runs Metal-style compute kernels written against metal_qd.h on the
+//  CPU, so that the same qd_real kernel code can be tested and timed
+//  on machines without a Metal GPU.
+//
+//  A kernel is a functor called once per thread with a thread_info,
+//  which holds the values Metal passes through the attributes
+//  [[thread_position_in_grid]], [[threadgroup_position_in_grid]],
+//  [[thread_position_in_threadgroup]], [[threads_per_threadgroup]]
+//  and [[threads_per_grid]]:
+//
+//      qd_cpu::thread_pool pool;
+//      qd_cpu::dispatch_threads(pool, qd_cpu::uint3(w, h), qd_cpu::uint3(16, 16),
+//          [&](const qd_cpu::thread_info &t) {
+//              out[t.thread_position_in_grid.y * w +
+//                  t.thread_position_in_grid.x] = ...;
+//          });
+//
+//  Each threadgroup runs on one worker, its threads one after another
+//  in the order x, y, z, and threadgroups are distributed over the
+//  pool.  threadgroup_barrier() has no equivalent; kernels that need
+//  one can be dispatched with dispatch_threadgroups, whose functor is
+//  called once per threadgroup and loops over the threads itself,
+//  once for each phase between barriers.
+//
+
+#ifndef metal_cpu_h
+#define metal_cpu_h
+
+#ifndef __METAL_VERSION__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace qd_cpu {
+
+struct uint3 {
+    unsigned x, y, z;
+
+    uint3(unsigned x = 1, unsigned y = 1, unsigned z = 1) : x(x), y(y), z(z) {}
+};
+
+struct thread_info {
+    uint3 thread_position_in_grid;
+    uint3 threadgroup_position_in_grid;
+    uint3 thread_position_in_threadgroup;
+    uint3 threads_per_threadgroup;     // of this group; smaller at the edges
+    uint3 threads_per_grid;
+    unsigned thread_index_in_threadgroup;
+    void *threadgroup_memory;          // shared by the threads of the group
+};
+
+// A pool of worker threads with one task deque each.  Workers take
+// ranges from the back of their own deque and, when it is empty,
+// steal from the front of the others'; a range is halved before it is
+// run, and the upper half left for thieves, until it is at most
+// the grain size.
+class thread_pool {
+public:
+    // Uses nthreads threads including the caller of parallel_for
+    // (all hardware threads if nthreads == 0).
+    explicit thread_pool(unsigned nthreads = 0) : stop(false), active(false) {
+        if (nthreads == 0)
+            nthreads = std::max(1u, std::thread::hardware_concurrency());
+        queues = std::vector<queue>(nthreads);
+        workers.reserve(nthreads - 1);
+        // if a thread cannot be started, join those that were before
+        // passing on the exception; destroying them joinable would
+        // call std::terminate
+        try {
+            for (unsigned i = 1; i < nthreads; i++)
+                workers.emplace_back(&thread_pool::worker, this, i);
+        } catch (...) {
+            join_all();
+            throw;
+        }
+    }
+
+    ~thread_pool() { join_all(); }
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Runs f(i) for i = 0, ..., n-1 and returns when all calls have
+    // finished.  Calls from several threads are run one at a time;
+    // f must not call parallel_for on the same pool.
+    template <class F>
+    void parallel_for(size_t n, const F &f, size_t grain = 1) {
+        if (n == 0)
+            return;
+        std::lock_guard<std::mutex> job_lock(job);
+
+        body = &invoke<F>;
+        context = &f;
+        this->grain = std::max<size_t>(grain, 1);
+        remaining.store(n);
+
+        // one contiguous range per worker to start with
+        size_t nq = queues.size();
+        for (size_t k = 0; k < nq; k++) {
+            size_t b = n * k / nq, e = n * (k + 1) / nq;
+            if (b < e) {
+                std::lock_guard<std::mutex> lock(queues[k].m);
+                queues[k].q.push_back(range(b, e));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            active = true;
+        }
+        wake.notify_all();
+
+        work(0);
+
+        std::unique_lock<std::mutex> lock(m);
+        done.wait(lock, [this] { return remaining.load() == 0; });
+        active = false;
+    }
+
+private:
+    typedef std::pair<size_t, size_t> range;
+
+    struct queue {
+        std::mutex m;
+        std::deque<range> q;
+    };
+
+    template <class F>
+    static void invoke(const void *f, size_t i) {
+        (*static_cast<const F *>(f))(i);
+    }
+
+    bool pop(unsigned self, range &r) {
+        queue &own = queues[self];
+        std::lock_guard<std::mutex> lock(own.m);
+        if (own.q.empty())
+            return false;
+        r = own.q.back();
+        own.q.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned self, range &r) {
+        size_t nq = queues.size();
+        for (size_t k = 1; k < nq; k++) {
+            queue &other = queues[(self + k) % nq];
+            std::lock_guard<std::mutex> lock(other.m);
+            if (!other.q.empty()) {
+                r = other.q.front();
+                other.q.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(unsigned self, range r) {
+        while (r.second - r.first > grain) {
+            size_t mid = r.first + (r.second - r.first) / 2;
+            {
+                std::lock_guard<std::mutex> lock(queues[self].m);
+                queues[self].q.push_back(range(mid, r.second));
+            }
+            r.second = mid;
+        }
+        for (size_t i = r.first; i < r.second; i++)
+            body(context, i);
+        if (remaining.fetch_sub(r.second - r.first) == r.second - r.first) {
+            std::lock_guard<std::mutex> lock(m);
+            done.notify_all();
+        }
+    }
+
+    // Runs and steals ranges until the current job has no work left.
+    void work(unsigned self) {
+        range r;
+        while (remaining.load() != 0) {
+            if (pop(self, r) || steal(self, r))
+                run(self, r);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    void join_all() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    void worker(unsigned self) {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake.wait(lock, [this] {
+                    return stop || (active && remaining.load() != 0);
+                });
+                if (stop)
+                    return;
+            }
+            work(self);
+        }
+    }
+
+    thread_pool(const thread_pool &);
+    thread_pool &operator=(const thread_pool &);
+
+    std::vector<queue> queues;
+    std::vector<std::thread> workers;
+    std::mutex job;                     // one parallel_for at a time
+    std::mutex m;
+    std::condition_variable wake, done;
+    bool stop, active;
+
+    void (*body)(const void *, size_t);
+    const void *context;
+    size_t grain;
+    std::atomic<size_t> remaining;
+};
+
+inline unsigned groups_along(unsigned threads, unsigned per_group) {
+    return (threads + per_group - 1) / per_group;
+}
+
+// Calls group(info) once for each threadgroup covering a grid of
+// grid threads, with info describing the first thread of the group.
+// Returns the elapsed time in seconds.
+template <class G>
+double dispatch_threadgroups(thread_pool &pool, uint3 grid, uint3 group_size,
+                             const G &group, size_t threadgroup_memory_length = 0) {
+    unsigned gx = groups_along(grid.x, group_size.x);
+    unsigned gy = groups_along(grid.y, group_size.y);
+    unsigned gz = groups_along(grid.z, group_size.z);
+    size_t ngroups = static_cast<size_t>(gx) * gy * gz;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    pool.parallel_for(ngroups, [&](size_t g) {
+        thread_local std::vector<unsigned char> memory;
+        if (memory.size() < threadgroup_memory_length)
+            memory.resize(threadgroup_memory_length);
+
+        thread_info t;
+        uint3 &tg = t.threadgroup_position_in_grid;
+        tg.x = static_cast<unsigned>(g % gx);
+        tg.y = static_cast<unsigned>(g / gx % gy);
+        tg.z = static_cast<unsigned>(g / gx / gy);
+        t.thread_position_in_grid = uint3(tg.x * group_size.x, tg.y * group_size.y,
+                                          tg.z * group_size.z);
+        t.thread_position_in_threadgroup = uint3(0, 0, 0);
+        t.threads_per_threadgroup = uint3(
+            std::min(group_size.x, grid.x - t.thread_position_in_grid.x),
+            std::min(group_size.y, grid.y - t.thread_position_in_grid.y),
+            std::min(group_size.z, grid.z - t.thread_position_in_grid.z));
+        t.threads_per_grid = grid;
+        t.thread_index_in_threadgroup = 0;
+        t.threadgroup_memory = memory.empty() ? 0 : &memory[0];
+        group(t);
+    });
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Calls kernel(info) once for each of the grid threads, in threadgroups
+// of group_size threads (smaller at the edges of the grid, like
+// dispatchThreads:threadsPerThreadgroup:).  Returns the elapsed time
+// in seconds.
+template <class K>
+double dispatch_threads(thread_pool &pool, uint3 grid, uint3 group_size,
+                        const K &kernel, size_t threadgroup_memory_length = 0) {
+    return dispatch_threadgroups(pool, grid, group_size, [&](const thread_info &g) {
+        thread_info t = g;
+        const uint3 &n = g.threads_per_threadgroup;
+        for (unsigned z = 0; z < n.z; z++)
+            for (unsigned y = 0; y < n.y; y++)
+                for (unsigned x = 0; x < n.x; x++) {
+                    t.thread_position_in_threadgroup = uint3(x, y, z);
+                    t.thread_position_in_grid = uint3(g.thread_position_in_grid.x + x,
+                                                      g.thread_position_in_grid.y + y,
+                                                      g.thread_position_in_grid.z + z);
+                    kernel(t);
+                    t.thread_index_in_threadgroup++;
+                }
+    }, threadgroup_memory_length);
+}
+
+} // namespace qd_cpu
+
+#endif /* __METAL_VERSION__ */
+
+#endif /* metal_cpu_h */
@@ -0,0 +1,459 @@
+//
+//  metal_df.h
+//
+//  df_real: double-float numbers, the unevaluated sum of two floats,
+//  with about 48 bits of precision.  This is the float-limb analogue
+//  of dd_real for code that does not need the 96 bits of the
+//  quad-float qd_real; it is built on the same qd:: primitives, so it
+//  follows the configuration of metal_qd.h (QD_ASQ, and QD_FMS for
+//  the error of products), and runs in Metal kernels and on the CPU.
+//
+//  On the CPU the df_add, df_mul, ... functions at the end apply an
+//  operation to arrays stored as separate high and low limbs.  The
+//  loops have no branches or calls and vectorize, 8 lanes per AVX2 or
+//  16 per AVX-512 instruction, when built with -O3 (or -O2
+//  -ftree-vectorize) and FMA enabled, e.g. -march=native.  df_sqrt
+//  also needs -fno-math-errno, since sqrtf may set errno, and with GCC
+//  -fno-trapping-math; neither changes the results.
+//
+
+#ifndef metal_df_h
+#define metal_df_h
+
+#include "metal_qd.h"
+
+#ifndef __METAL_VERSION__
+#include <cstddef>
+#endif
+
+struct df_real {
+    QDT x[2];    /* The Components. */
+
+    df_real() : x{0.0f, 0.0f} {}
+    constexpr df_real(QDT hi, QDT lo) : x{hi, lo} {}
+    df_real(QDT h) : x{h, 0.0f} {}
+    df_real(int h) : x{static_cast<QDT>(h), 0.0f} {}
+    explicit df_real(const QD_ASQ qd_real &a) : x{a[0], a[1]} {}
+#ifndef __METAL_VERSION__
+    df_real(double d) {
+        x[0] = static_cast<QDT>(d);
+        x[1] = static_cast<QDT>(d - x[0]);
+    }
+#endif
+#if QD_HAVE_SIMD
+    df_real(simd::float4 v) : x{v.x, v.y} {}
+#endif
+
+    QDT _hi() const { return x[0]; }
+    QDT _lo() const { return x[1]; }
+    QDT operator[](int i) const { return x[i]; }
+
+    static df_real add(QDT a, QDT b);
+    static df_real sqr(QDT a);
+    static df_real sloppy_div(const QD_ASQ df_real &a, const QD_ASQ df_real &b);
+    static df_real accurate_div(const QD_ASQ df_real &a, const QD_ASQ df_real &b);
+
+    QD_ASQ df_real &operator+=(QDT a);
+    QD_ASQ df_real &operator+=(const QD_ASQ df_real &a);
+    QD_ASQ df_real &operator-=(QDT a);
+    QD_ASQ df_real &operator-=(const QD_ASQ df_real &a);
+    QD_ASQ df_real &operator*=(QDT a);
+    QD_ASQ df_real &operator*=(const QD_ASQ df_real &a);
+    QD_ASQ df_real &operator/=(QDT a);
+    QD_ASQ df_real &operator/=(const QD_ASQ df_real &a);
+
+    df_real operator-() const { return df_real(-x[0], -x[1]); }
+
+    bool is_zero() const { return x[0] == 0.0f; }
+    bool is_one() const { return x[0] == 1.0f && x[1] == 0.0f; }
+    bool is_positive() const { return x[0] > 0.0f; }
+    bool is_negative() const { return x[0] < 0.0f; }
+};
+
+/*********** Additions ************/
+/* float + float */
+inline df_real df_real::add(QDT a, QDT b) {
+    QDT s, e;
+    s = qd::two_sum(a, b, e);
+    return df_real(s, e);
+}
+
+/* double-float + float */
+inline df_real operator+(const QD_ASQ df_real &a, QDT b) {
+    QDT s1, s2;
+    s1 = qd::two_sum(a.x[0], b, s2);
+    s2 += a.x[1];
+    s1 = qd::quick_two_sum(s1, s2, s2);
+    return df_real(s1, s2);
+}
+
+/* double-float + double-float */
+inline df_real operator+(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+#ifndef QD_IEEE_ADD
+    QDT s, e;
+    s = qd::two_sum(a.x[0], b.x[0], e);
+    e += (a.x[1] + b.x[1]);
+    s = qd::quick_two_sum(s, e, e);
+    return df_real(s, e);
+#else
+    QDT s1, s2, t1, t2;
+    s1 = qd::two_sum(a.x[0], b.x[0], s2);
+    t1 = qd::two_sum(a.x[1], b.x[1], t2);
+    s2 += t1;
+    s1 = qd::quick_two_sum(s1, s2, s2);
+    s2 += t2;
+    s1 = qd::quick_two_sum(s1, s2, s2);
+    return df_real(s1, s2);
+#endif
+}
+
+inline df_real operator+(QDT a, const QD_ASQ df_real &b) {
+    return (b + a);
+}
+
+/*********** Subtractions ************/
+inline df_real operator-(const QD_ASQ df_real &a, QDT b) {
+    QDT s1, s2;
+    s1 = qd::two_diff(a.x[0], b, s2);
+    s2 += a.x[1];
+    s1 = qd::quick_two_sum(s1, s2, s2);
+    return df_real(s1, s2);
+}
+
+inline df_real operator-(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+#ifndef QD_IEEE_ADD
+    QDT s, e;
+    s = qd::two_diff(a.x[0], b.x[0], e);
+    e += a.x[1];
+    e -= b.x[1];
+    s = qd::quick_two_sum(s, e, e);
+    return df_real(s, e);
+#else
+    QDT s1, s2, t1, t2;
+    s1 = qd::two_diff(a.x[0], b.x[0], s2);
+    t1 = qd::two_diff(a.x[1], b.x[1], t2);
+    s2 += t1;
+    s1 = qd::quick_two_sum(s1, s2, s2);
+    s2 += t2;
+    s1 = qd::quick_two_sum(s1, s2, s2);
+    return df_real(s1, s2);
+#endif
+}
+
+inline df_real operator-(QDT a, const QD_ASQ df_real &b) {
+    QDT s1, s2;
+    s1 = qd::two_diff(a, b.x[0], s2);
+    s2 -= b.x[1];
+    s1 = qd::quick_two_sum(s1, s2, s2);
+    return df_real(s1, s2);
+}
+
+/*********** Multiplications ************/
+/* float * float */
+inline df_real df_real::sqr(QDT a) {
+    QDT p, e;
+    p = qd::two_sqr(a, e);
+    return df_real(p, e);
+}
+
+/* double-float * float */
+inline df_real operator*(const QD_ASQ df_real &a, QDT b) {
+    QDT p1, p2;
+    p1 = qd::two_prod(a.x[0], b, p2);
+    p2 += (a.x[1] * b);
+    p1 = qd::quick_two_sum(p1, p2, p2);
+    return df_real(p1, p2);
+}
+
+/* double-float * double-float */
+inline df_real operator*(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    QDT p1, p2;
+    p1 = qd::two_prod(a.x[0], b.x[0], p2);
+    p2 += (a.x[0] * b.x[1] + a.x[1] * b.x[0]);
+    p1 = qd::quick_two_sum(p1, p2, p2);
+    return df_real(p1, p2);
+}
+
+inline df_real operator*(QDT a, const QD_ASQ df_real &b) {
+    return (b * a);
+}
+
+/* double-float * (2.0 ^ exp) */
+inline df_real mul_pwr2(const QD_ASQ df_real &a, QDT b) {
+    return df_real(a.x[0] * b, a.x[1] * b);
+}
+
+inline df_real sqr(const QD_ASQ df_real &a) {
+    QDT p1, p2;
+    QDT s1, s2;
+    p1 = qd::two_sqr(a.x[0], p2);
+    p2 += 2.0f * a.x[0] * a.x[1];
+    p2 += a.x[1] * a.x[1];
+    s1 = qd::quick_two_sum(p1, p2, s2);
+    return df_real(s1, s2);
+}
+
+/*********** Divisions ************/
+inline df_real operator/(const QD_ASQ df_real &a, QDT b) {
+    QDT q1, q2;
+    QDT p1, p2;
+    QDT s, e;
+    df_real r;
+
+    q1 = a.x[0] / b;   /* approximate quotient. */
+
+    /* Compute  this - q1 * d */
+    p1 = qd::two_prod(q1, b, p2);
+    s = qd::two_diff(a.x[0], p1, e);
+    e += a.x[1];
+    e -= p2;
+
+    /* get next approximation. */
+    q2 = (s + e) / b;
+
+    /* renormalize */
+    r.x[0] = qd::quick_two_sum(q1, q2, r.x[1]);
+    return r;
+}
+
+inline df_real df_real::sloppy_div(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    QDT s1, s2;
+    QDT q1, q2;
+    df_real r;
+
+    q1 = a.x[0] / b.x[0];  /* approximate quotient */
+
+    /* compute  this - q1 * dd */
+    r = b * q1;
+    s1 = qd::two_diff(a.x[0], r.x[0], s2);
+    s2 -= r.x[1];
+    s2 += a.x[1];
+
+    /* get next approximation */
+    q2 = (s1 + s2) / b.x[0];
+
+    /* renormalize */
+    r.x[0] = qd::quick_two_sum(q1, q2, r.x[1]);
+    return r;
+}
+
+inline df_real df_real::accurate_div(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    QDT q1, q2, q3;
+    df_real r;
+
+    q1 = a.x[0] / b.x[0];  /* approximate quotient */
+
+    r = a - q1 * b;
+
+    q2 = r.x[0] / b.x[0];
+    r -= (q2 * b);
+
+    q3 = r.x[0] / b.x[0];
+
+    q1 = qd::quick_two_sum(q1, q2, q2);
+    r = df_real(q1, q2) + q3;
+    return r;
+}
+
+inline df_real operator/(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+#ifdef QD_SLOPPY_DIV
+    return df_real::sloppy_div(a, b);
+#else
+    return df_real::accurate_div(a, b);
+#endif
+}
+
+inline df_real operator/(QDT a, const QD_ASQ df_real &b) {
+    return df_real(a) / b;
+}
+
+/* Karp's trick: if x approximates 1/sqrt(a), then
+   sqrt(a) = a*x + [a - (a*x)^2] * x / 2  to twice the accuracy of x.
+   Zero and negative arguments are handled by selects rather than
+   branches, so that loops calling this can vectorize; see the top
+   of the file for the flags that needs.                           */
+inline df_real sqrt(const QD_ASQ df_real &a) {
+    QDT x = 1.0f / std::sqrt(a.x[0]);
+    QDT ax = a.x[0] * x;
+    df_real r = df_real::add(ax, (a - df_real::sqr(ax)).x[0] * (x * 0.5f));
+    QDT z = (a.x[0] == 0.0f) ? 0.0f : NAN;
+    r.x[0] = (a.x[0] > 0.0f) ? r.x[0] : z;
+    r.x[1] = (a.x[0] > 0.0f) ? r.x[1] : z;
+    return r;
+}
+
+/*********** Self-Operations ************/
+inline QD_ASQ df_real &df_real::operator+=(QDT a) {
+    *this = *this + a;
+    return *this;
+}
+
+inline QD_ASQ df_real &df_real::operator+=(const QD_ASQ df_real &a) {
+    *this = *this + a;
+    return *this;
+}
+
+inline QD_ASQ df_real &df_real::operator-=(QDT a) {
+    *this = *this - a;
+    return *this;
+}
+
+inline QD_ASQ df_real &df_real::operator-=(const QD_ASQ df_real &a) {
+    *this = *this - a;
+    return *this;
+}
+
+inline QD_ASQ df_real &df_real::operator*=(QDT a) {
+    *this = *this * a;
+    return *this;
+}
+
+inline QD_ASQ df_real &df_real::operator*=(const QD_ASQ df_real &a) {
+    *this = *this * a;
+    return *this;
+}
+
+inline QD_ASQ df_real &df_real::operator/=(QDT a) {
+    *this = *this / a;
+    return *this;
+}
+
+inline QD_ASQ df_real &df_real::operator/=(const QD_ASQ df_real &a) {
+    *this = *this / a;
+    return *this;
+}
+
+/*********** Miscellaneous ************/
+inline df_real abs(const QD_ASQ df_real &a) {
+    return (a.x[0] < 0.0f) ? -a : a;
+}
+
+inline df_real fabs(const QD_ASQ df_real &a) {
+    return abs(a);
+}
+
+/*********** Comparisons ************/
+inline bool operator==(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    return (a.x[0] == b.x[0] && a.x[1] == b.x[1]);
+}
+
+inline bool operator!=(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    return (a.x[0] != b.x[0] || a.x[1] != b.x[1]);
+}
+
+inline bool operator<(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    return (a.x[0] < b.x[0] || (a.x[0] == b.x[0] && a.x[1] < b.x[1]));
+}
+
+inline bool operator>(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    return (a.x[0] > b.x[0] || (a.x[0] == b.x[0] && a.x[1] > b.x[1]));
+}
+
+inline bool operator<=(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    return !(a > b);
+}
+
+inline bool operator>=(const QD_ASQ df_real &a, const QD_ASQ df_real &b) {
+    return !(a < b);
+}
+
+/*********** Conversions ************/
+inline QDT to_double(const QD_ASQ df_real &a) {
+    return a.x[0];
+}
+
+inline qd_real to_qd_real(const QD_ASQ df_real &a) {
+    return qd_real(a.x[0], a.x[1], 0.0f, 0.0f);
+}
+
+#if QD_HAVE_SIMD
+/* The limbs of a qd_real, so that either type reads it. */
+inline simd::float4 to_float4(const QD_ASQ df_real &a) {
+    simd::float4 t = {a.x[0], a.x[1], 0.0f, 0.0f};
+    return t;
+}
+#endif
+
+#ifndef __METAL_VERSION__
+
+/*********** Arrays of separate limbs (CPU) ************/
+// c[i] = op(a[i], b[i]) for i < n, where a[i] = (a_hi[i], a_lo[i]) and
+// so on.  The output may be one of the inputs.
+
+#if defined(__clang__)
+#define QD_DF_LOOP _Pragma("clang loop vectorize(enable)")
+#elif defined(__GNUC__)
+#define QD_DF_LOOP _Pragma("GCC ivdep")
+#else
+#define QD_DF_LOOP
+#endif
+
+namespace qd_cpu {
+
+template <class F>
+inline void df_map(std::size_t n, const float *a_hi, const float *a_lo,
+                   const float *b_hi, const float *b_lo,
+                   float *c_hi, float *c_lo, F f) {
+    QD_DF_LOOP
+    for (std::size_t i = 0; i < n; i++) {
+        df_real c = f(df_real(a_hi[i], a_lo[i]), df_real(b_hi[i], b_lo[i]));
+        c_hi[i] = c.x[0];
+        c_lo[i] = c.x[1];
+    }
+}
+
+inline void df_add(std::size_t n, const float *a_hi, const float *a_lo,
+                   const float *b_hi, const float *b_lo, float *c_hi, float *c_lo) {
+    df_map(n, a_hi, a_lo, b_hi, b_lo, c_hi, c_lo,
+           [](const df_real &a, const df_real &b) { return a + b; });
+}
+
+inline void df_sub(std::size_t n, const float *a_hi, const float *a_lo,
+                   const float *b_hi, const float *b_lo, float *c_hi, float *c_lo) {
+    df_map(n, a_hi, a_lo, b_hi, b_lo, c_hi, c_lo,
+           [](const df_real &a, const df_real &b) { return a - b; });
+}
+
+inline void df_mul(std::size_t n, const float *a_hi, const float *a_lo,
+                   const float *b_hi, const float *b_lo, float *c_hi, float *c_lo) {
+    df_map(n, a_hi, a_lo, b_hi, b_lo, c_hi, c_lo,
+           [](const df_real &a, const df_real &b) { return a * b; });
+}
+
+inline void df_div(std::size_t n, const float *a_hi, const float *a_lo,
+                   const float *b_hi, const float *b_lo, float *c_hi, float *c_lo) {
+    df_map(n, a_hi, a_lo, b_hi, b_lo, c_hi, c_lo,
+           [](const df_real &a, const df_real &b) { return a / b; });
+}
+
+/* c[i] = a[i]^2 and c[i] = sqrt(a[i]). */
+inline void df_sqr(std::size_t n, const float *a_hi, const float *a_lo,
+                   float *c_hi, float *c_lo) {
+    df_map(n, a_hi, a_lo, a_hi, a_lo, c_hi, c_lo,
+           [](const df_real &a, const df_real &) { return sqr(a); });
+}
+
+inline void df_sqrt(std::size_t n, const float *a_hi, const float *a_lo,
+                    float *c_hi, float *c_lo) {
+    df_map(n, a_hi, a_lo, a_hi, a_lo, c_hi, c_lo,
+           [](const df_real &a, const df_real &) { return sqrt(a); });
+}
+
+/* d[i] = a[i] * b[i] + c[i] */
+inline void df_mul_add(std::size_t n, const float *a_hi, const float *a_lo,
+                       const float *b_hi, const float *b_lo,
+                       const float *c_hi, const float *c_lo, float *d_hi, float *d_lo) {
+    QD_DF_LOOP
+    for (std::size_t i = 0; i < n; i++) {
+        df_real d = df_real(a_hi[i], a_lo[i]) * df_real(b_hi[i], b_lo[i]) +
+                    df_real(c_hi[i], c_lo[i]);
+        d_hi[i] = d.x[0];
+        d_lo[i] = d.x[1];
+    }
+}
+
+} // namespace qd_cpu
+
+#endif /* __METAL_VERSION__ */
+
+#endif /* metal_df_h */
@@ -26,24 +26,45 @@
 #ifdef __METAL_VERSION__
 namespace std = metal;       /* fixes various uses of std::math_function */
 #else
-#import <cmath>
+#include <cmath>
 #endif
 
+// Without hardware fma on the CPU, fma() is a slow library call that
+// also stops loops from vectorizing; two_prod then splits instead.
 #ifdef __METAL_VERSION__
 #define QD_FMS(x,y,z) precise::fma(x,y,-z)
-#else
+#elif defined(__FMA__) || defined(__ARM_FEATURE_FMA) || defined(FP_FAST_FMAF)
 #define QD_FMS(x,y,z) fma(x,y,-z)
 #endif
 
 // #define inline /* */ /* to disable inline for dubugging and analysis */
 
-// enable float4 conversions if SIMD available
-#if defined(SIMD_LIBRARY_VERSION)||defined(__METAL_VERSION__)||defined(matrix_add)
-    #define QD_HAVE_SIMD 1
+// use Apple's simd library on the CPU where it exists
+#if !defined(__METAL_VERSION__) && !defined(SIMD_LIBRARY_VERSION) && defined(__has_include)
+#if __has_include(<simd/simd.h>)
+#include <simd/simd.h>
+#endif
+#endif
+
+// elsewhere provide a minimal simd::float4 with the same layout and
+// member names, so that code passing float4 values builds everywhere
+#if !defined(SIMD_LIBRARY_VERSION)&&!defined(__METAL_VERSION__)&&!defined(matrix_add)
+#define QD_SIMD_SHIM 1
+namespace simd {
+struct alignas(16) float4 {
+    float x, y, z, w;
+
+    float operator[](int i) const { return (&x)[i]; }
+    float &operator[](int i) { return (&x)[i]; }
+};
+}
 #else
-    #define QD_HAVE_SIMD 0
+#define QD_SIMD_SHIM 0
 #endif
 
+// enable float4 conversions
+#define QD_HAVE_SIMD 1
+
 
 #include "qd_real.h"
 
@@ -75,4 +96,8 @@ inline simd::float4 to_float4(const QD_ASQ qd_real &a) {
 #endif
 
 
+// division, sqrt, exp, log, sin and cos for float limbs
+#include "metal_qd_math.h"
+
+
 #endif /* metal_qd_h */
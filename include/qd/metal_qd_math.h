@@ -0,0 +1,358 @@
+//
+//  metal_qd_math.h
+//
+//  Division, square root, exp, log, sin and cos for the quad-float
+//  qd_real of metal_qd.h.  The library versions in qd_real.cpp are
+//  written for double limbs (argument reduction by 2^16, exp cutoffs
+//  at +-709, tables of 53-bit limbs); these use tables of float limbs
+//  and reductions and thresholds sized for the 96-bit, 8-bit-exponent
+//  type.  Everything is inline so the same code runs in Metal kernels
+//  and on the CPU.  Included by metal_qd.h.
+//
+//  log and sqrt first scale their argument by a power of two, so the
+//  relative error stays below about 2^-90 up to FLT_MAX; the tests
+//  check that bound.  Since each limb is a float, precision is lost
+//  once the lowest limb drops below 2^-126, that is for results
+//  smaller than about 2^-54 in magnitude.  There is no error reporting
+//  on the GPU; arguments outside the domain give NaN.
+//
+
+#ifndef metal_qd_math_h
+#define metal_qd_math_h
+
+#if QDT_float
+
+#ifdef __METAL_VERSION__
+#define QD_CONSTANT constant    /* address space of the tables */
+#else
+#define QD_CONSTANT const
+#endif
+
+namespace qd_float_detail {
+
+// Constants split into four float limbs.
+QD_CONSTANT float _2pi[4] = {
+    6.283185482e+00f, -1.748455531e-07f, -6.860498040e-15f, 4.225199593e-23f};
+QD_CONSTANT float _pi2[4] = {
+    1.570796371e+00f, -4.371138829e-08f, -1.715124510e-15f, 1.056299898e-23f};
+QD_CONSTANT float _pi64[4] = {
+    4.908738658e-02f, -1.365980884e-09f, -5.359764094e-17f, 3.300937182e-25f};
+QD_CONSTANT float _log2[4] = {
+    6.931471825e-01f, -1.904654212e-09f, -8.783183739e-17f, 3.061840739e-24f};
+
+// 1/3!, ..., 1/13!
+const int n_inv_fact = 11;
+QD_CONSTANT float inv_fact[n_inv_fact][4] = {
+    {1.666666716e-01f, -4.967053879e-09f, 1.480297410e-16f, -4.411630065e-24f},
+    {4.166666791e-02f, -1.241763470e-09f, 3.700743526e-17f, -1.102907516e-24f},
+    {8.333333768e-03f, -4.346172033e-10f, 1.850371804e-18f, -9.650440521e-26f},
+    {1.388888923e-03f, -3.363109444e-11f, 1.464877618e-18f, -1.608406805e-26f},
+    {1.984127011e-04f, -2.725596875e-12f, 5.438220743e-20f, -3.220916572e-27f},
+    {2.480158764e-05f, -3.406996094e-13f, 6.797775929e-21f, -4.026145715e-28f},
+    {2.755731884e-06f, 3.793571224e-14f, 1.508226522e-21f, 4.501988838e-29f},
+    {2.755731998e-07f, -7.575112209e-15f, -1.879905267e-22f, 4.501988763e-30f},
+    {2.505210794e-08f, 4.417623045e-16f, 1.178607575e-23f, -2.101605371e-32f},
+    {2.087675588e-09f, 1.108283915e-16f, 3.187987880e-24f, 6.398707108e-32f},
+    {1.605904437e-10f, -5.352526512e-18f, -1.683604693e-25f, 4.922082476e-33f}
+};
+
+// sin(k * pi/64) and cos(k * pi/64) for k = 1, ..., 16.
+QD_CONSTANT float sin_table[16][4] = {
+    {4.906767607e-02f, -1.739934308e-09f, 2.707596568e-17f, -4.351394717e-25f},
+    {9.801714122e-02f, -8.933931928e-10f, -1.634582406e-18f, 4.383746581e-26f},
+    {1.467304677e-01f, 6.778245520e-09f, -1.628065087e-16f, 2.179127671e-24f},
+    {1.950903237e-01f, -1.670471428e-09f, -3.574665318e-17f, -1.499219698e-24f},
+    {2.429801822e-01f, -2.267604104e-09f, 7.451529493e-17f, 3.847484669e-25f},
+    {2.902846634e-01f, 1.381566506e-08f, 3.141389239e-16f, 4.820027694e-24f},
+    {3.368898630e-01f, -9.622000974e-09f, -1.669534629e-16f, -1.725048241e-25f},
+    {3.826834261e-01f, 6.223350724e-09f, 1.564826799e-16f, 1.141649757e-24f},
+    {4.275550842e-01f, 9.201766460e-09f, 9.411189517e-18f, 2.996162743e-25f},
+    {4.713967443e-01f, -7.425253745e-09f, 1.730501281e-16f, 3.686588402e-24f},
+    {5.141027570e-01f, -1.278385930e-08f, -2.677573055e-16f, -6.956416065e-24f},
+    {5.555702448e-01f, -1.176952136e-08f, 4.709410873e-17f, 6.718412785e-25f},
+    {5.956993103e-01f, -5.810301129e-09f, 9.758366153e-17f, -1.007246989e-24f},
+    {6.343932748e-01f, 9.379557575e-09f, -2.116237042e-16f, 1.162998207e-24f},
+    {6.715589762e-01f, -2.132638244e-08f, -4.048903846e-17f, 7.060183814e-25f},
+    {7.071067691e-01f, 1.210161749e-08f, -3.814033719e-16f, -2.036605946e-24f}
+};
+
+QD_CONSTANT float cos_table[16][4] = {
+    {9.987954497e-01f, 6.471438052e-09f, 2.097529128e-16f, -1.192774255e-24f},
+    {9.951847196e-01f, 7.109666189e-09f, 1.795576970e-16f, -5.741824678e-24f},
+    {9.891765118e-01f, -1.799745353e-09f, -4.098730890e-17f, -1.041787264e-24f},
+    {9.807852507e-01f, 2.973947311e-08f, 1.854693947e-17f, 5.279181916e-25f},
+    {9.700312614e-01f, -8.249547712e-09f, -9.265700027e-17f, -1.839489919e-24f},
+    {9.569403529e-01f, -1.718450804e-08f, -6.255799419e-16f, -3.009851255e-24f},
+    {9.415440559e-01f, 9.244300436e-09f, -3.609632758e-16f, -1.117436776e-23f},
+    {9.238795042e-01f, 2.830748969e-08f, 6.837788875e-16f, -2.563551029e-23f},
+    {9.039893150e-01f, -2.190951598e-08f, 3.264571652e-16f, -1.227418817e-23f},
+    {8.819212914e-01f, -2.700296342e-08f, 9.117905351e-17f, 5.435338412e-25f},
+    {8.577286005e-01f, 9.498258180e-09f, -2.702280477e-16f, -5.201555538e-24f},
+    {8.314695954e-01f, 1.687026341e-08f, 3.344743056e-16f, -1.248294916e-23f},
+    {8.032075167e-01f, 1.481041778e-08f, 7.796169332e-17f, -6.660833335e-25f},
+    {7.730104327e-01f, 2.064255256e-08f, 7.845639365e-17f, 1.776660895e-24f},
+    {7.409511209e-01f, 4.501535145e-09f, -1.257309237e-16f, 4.297655047e-24f},
+    {7.071067691e-01f, 1.210161749e-08f, -3.814033719e-16f, -2.036605946e-24f}
+};
+
+inline qd_real load(QD_CONSTANT float *p) {
+    return qd_real(p[0], p[1], p[2], p[3]);
+}
+
+inline qd_real nan() {
+    return qd_real(NAN, NAN, NAN, NAN);
+}
+
+// sin(a) and cos(a) by their Taylor series, for |a| <= pi/128.  The
+// first omitted terms, a^15/15! and a^14/14!, are below 2^-110.
+inline void sincos_taylor(const QD_ASQ qd_real &a,
+                          QD_ASQ qd_real &sin_a, QD_ASQ qd_real &cos_a) {
+    qd_real x = -sqr(a);
+    qd_real s = load(inv_fact[10]);     // 1/13!
+    for (int i = 8; i >= 0; i -= 2)     // 1/11!, ..., 1/3!
+        s = s * x + load(inv_fact[i]);
+    qd_real c = load(inv_fact[9]);      // 1/12!
+    for (int i = 7; i >= 1; i -= 2)     // 1/10!, ..., 1/4!
+        c = c * x + load(inv_fact[i]);
+    c = c * x + 0.5f;
+    sin_a = a * (s * x + 1.0f);
+    cos_a = c * x + 1.0f;
+}
+
+} // namespace qd_float_detail
+
+/* quad-float / float */
+inline qd_real operator/(const QD_ASQ qd_real &a, QDT b) {
+    QDT t0, t1;
+    QDT q0, q1, q2, q3;
+    qd_real r;
+
+    q0 = a[0] / b;
+    t0 = qd::two_prod(q0, b, t1);
+    r = a - qd_real(t0, t1, 0.0f, 0.0f);
+
+    q1 = r[0] / b;
+    t0 = qd::two_prod(q1, b, t1);
+    r -= qd_real(t0, t1, 0.0f, 0.0f);
+
+    q2 = r[0] / b;
+    t0 = qd::two_prod(q2, b, t1);
+    r -= qd_real(t0, t1, 0.0f, 0.0f);
+
+    q3 = r[0] / b;
+
+    qd::renorm(q0, q1, q2, q3);
+    return qd_real(q0, q1, q2, q3);
+}
+
+/* quad-float / quad-float */
+inline qd_real qd_real::sloppy_div(const QD_ASQ qd_real &a, const QD_ASQ qd_real &b) {
+    QDT q0, q1, q2, q3;
+    qd_real r;
+
+    q0 = a[0] / b[0];
+    r = a - (b * q0);
+
+    q1 = r[0] / b[0];
+    r -= (b * q1);
+
+    q2 = r[0] / b[0];
+    r -= (b * q2);
+
+    q3 = r[0] / b[0];
+
+    qd::renorm(q0, q1, q2, q3);
+    return qd_real(q0, q1, q2, q3);
+}
+
+inline qd_real qd_real::accurate_div(const QD_ASQ qd_real &a, const QD_ASQ qd_real &b) {
+    QDT q0, q1, q2, q3, q4;
+    qd_real r;
+
+    q0 = a[0] / b[0];
+    r = a - (b * q0);
+
+    q1 = r[0] / b[0];
+    r -= (b * q1);
+
+    q2 = r[0] / b[0];
+    r -= (b * q2);
+
+    q3 = r[0] / b[0];
+    r -= (b * q3);
+
+    q4 = r[0] / b[0];
+
+    qd::renorm(q0, q1, q2, q3, q4);
+    return qd_real(q0, q1, q2, q3);
+}
+
+/* Newton iteration  x' = x + (1 - a * x^2) * x / 2  for 1/sqrt(a),
+   starting from the float approximation; three iterations take the
+   24 correct bits past the 93 of the type.  a is first scaled by an
+   even power of two into [1, 4), since the lower limbs of 1/sqrt(a)
+   would underflow for large a.                                    */
+inline qd_real sqrt(const QD_ASQ qd_real &a) {
+    if (a.is_zero())
+        return 0.0f;
+
+    if (a.is_negative())
+        return qd_float_detail::nan();
+
+    if (!std::isfinite(a[0]))
+        return a;
+
+    int k = std::ilogb(a[0]) >> 1;
+    qd_real b = ldexp(a, -2 * k);
+    qd_real r = 1.0f / std::sqrt(b[0]);
+    qd_real h = mul_pwr2(b, 0.5f);
+
+    r += ((0.5f - h * sqr(r)) * r);
+    r += ((0.5f - h * sqr(r)) * r);
+    r += ((0.5f - h * sqr(r)) * r);
+
+    r *= b;
+    return ldexp(r, k);
+}
+
+/* exp(kr + m * log(2)) = 2^m * exp(r)^k  with k = 2^10, so that
+   |r| <= log(2) / 2^11.  The Taylor series of exp(r) - 1 is cut
+   after r^7/7!, which leaves an error below 2^-107 / k.  Results
+   below 2^-126 (float underflow) are flushed to zero.           */
+inline qd_real exp(const QD_ASQ qd_real &a) {
+    using namespace qd_float_detail;
+    const int log2_k = 10;
+
+    if (std::isnan(a[0]))
+        return nan();
+
+    if (a[0] <= -88.0f)
+        return 0.0f;
+
+    if (a[0] >= 88.7f)
+        return qd_real(INFINITY, 0.0f, 0.0f, 0.0f);
+
+    if (a.is_zero())
+        return 1.0f;
+
+    qd_real log2 = load(_log2);
+    QDT m = std::floor(a[0] / log2[0] + 0.5f);
+    qd_real r = ldexp(a - log2 * m, -log2_k);
+
+    qd_real p = load(inv_fact[4]);
+    for (int i = 3; i >= 0; i--)
+        p = p * r + load(inv_fact[i]);
+    p = p * r + 0.5f;
+    qd_real s = r + sqr(r) * p;
+
+    for (int i = 0; i < log2_k; i++)
+        s = mul_pwr2(s, 2.0f) + sqr(s);
+    s += 1.0f;
+    return ldexp(s, static_cast<int>(m));
+}
+
+/* Newton iteration on  f(x) = exp(x) - a,  x' = x + a * exp(-x) - 1,
+   from the float approximation; like sqrt, three iterations.  Outside
+   [1/2, 2) a is first scaled to b in [1, 2), log a = k log 2 + log b,
+   since exp(-x) would lose its lower limbs for large a.  The scaling
+   is done in line rather than by recursion, which Metal lacks.      */
+inline qd_real log(const QD_ASQ qd_real &a) {
+    if (a.is_one())
+        return 0.0f;
+
+    if (a[0] == 0.0f)
+        return qd_real(-INFINITY, 0.0f, 0.0f, 0.0f);
+
+    if (a[0] < 0.0f)
+        return qd_float_detail::nan();
+
+    if (!std::isfinite(a[0]))
+        return a;
+
+    int k = std::ilogb(a[0]);
+    if (k == -1)
+        k = 0;      /* log a is small near 1; do not cancel k log 2 */
+    qd_real b = ldexp(a, -k);
+    qd_real x = std::log(b[0]);
+
+    x = x + b * exp(-x) - 1.0f;
+    x = x + b * exp(-x) - 1.0f;
+    x = x + b * exp(-x) - 1.0f;
+    return x + qd_float_detail::load(qd_float_detail::_log2) * (QDT) k;
+}
+
+/* Reduces a = t + 2pi z + j pi/2 + k pi/64 with |t| <= pi/128, and
+   combines the Taylor series of t with the tables of sin and cos of
+   k pi/64.                                                         */
+inline void sincos(const QD_ASQ qd_real &a, QD_ASQ qd_real &sin_a, QD_ASQ qd_real &cos_a) {
+    using namespace qd_float_detail;
+
+    if (a.is_zero()) {
+        sin_a = 0.0f;
+        cos_a = 1.0f;
+        return;
+    }
+
+    if (!std::isfinite(a[0])) {
+        sin_a = cos_a = nan();
+        return;
+    }
+
+    qd_real _2pi_ = load(_2pi), _pi2_ = load(_pi2), _pi64_ = load(_pi64);
+    qd_real z = quick_nint(a / _2pi_);
+    qd_real t = a - _2pi_ * z;
+
+    QDT q = std::floor(t[0] / _pi2_[0] + 0.5f);
+    t -= _pi2_ * q;
+    int j = static_cast<int>(q);
+    q = std::floor(t[0] / _pi64_[0] + 0.5f);
+    t -= _pi64_ * q;
+    int k = static_cast<int>(q);
+    int abs_k = k < 0 ? -k : k;
+
+    if (j < -2 || j > 2 || abs_k > 16) {
+        sin_a = cos_a = nan();
+        return;
+    }
+
+    qd_real s, c;
+    sincos_taylor(t, s, c);
+
+    if (k != 0) {
+        qd_real u = load(cos_table[abs_k - 1]);
+        qd_real v = load(sin_table[abs_k - 1]);
+        qd_real s1 = (k > 0) ? u * s + v * c : u * s - v * c;
+        c = (k > 0) ? u * c - v * s : u * c + v * s;
+        s = s1;
+    }
+
+    if (j == 0) {
+        sin_a = s;
+        cos_a = c;
+    } else if (j == 1) {
+        sin_a = c;
+        cos_a = -s;
+    } else if (j == -1) {
+        sin_a = -c;
+        cos_a = s;
+    } else {
+        sin_a = -s;
+        cos_a = -c;
+    }
+}
+
+inline qd_real sin(const QD_ASQ qd_real &a) {
+    qd_real s, c;
+    sincos(a, s, c);
+    return s;
+}
+
+inline qd_real cos(const QD_ASQ qd_real &a) {
+    qd_real s, c;
+    sincos(a, s, c);
+    return c;
+}
+
+#endif /* QDT_float */
+
+#endif /* metal_qd_math_h */
@@ -0,0 +1,198 @@
+//
+//  metal_qdx.h
+//
+//  qdx_real: a quad-float qd_real mantissa with a separate int
+//  exponent, m * 2^e, for computations whose magnitudes leave the
+//  range of float.  With float limbs all four limbs share float's
+//  exponent range, so the lower limbs of a qd_real underflow once the
+//  value drops below about 2^-54, and the whole number at 2^-126;
+//  qdx_real keeps the 96 bits of precision down to 2^-(2^31).
+//
+//  The arithmetic is that of qd_real on the mantissa, so it runs in
+//  Metal kernels and on the CPU alike.  The exponent is renormalized
+//  lazily: m is rescaled only when its leading limb leaves
+//  [2^-16, 2^16), which keeps the lowest limb well above float's
+//  underflow and lets products of two mantissas stay finite.
+//
+
+#ifndef metal_qdx_h
+#define metal_qdx_h
+
+#include "metal_qd.h"
+
+struct qdx_real {
+    qd_real m;   /* The mantissa. */
+    int e;       /* The exponent: the value is m * 2^e. */
+
+    qdx_real() : m(0.0f), e(0) {}
+    qdx_real(const QD_ASQ qd_real &mm, int ee = 0) : m(mm), e(ee) { normalize(); }
+    qdx_real(QDT d) : m(d), e(0) { normalize(); }
+#ifndef __METAL_VERSION__
+    qdx_real(double d);
+#endif
+
+    /* Rescales m to [1, 2) in magnitude if it left [2^-16, 2^16). */
+    void normalize() {
+        int k = std::ilogb(m[0]);
+        if (k >= 16 || k < -16)
+            rescale();
+    }
+
+    /* Rescales m to [1, 2) in magnitude, or sets e = 0 if m is zero. */
+    void rescale() {
+        if (m.is_zero() || !std::isfinite(m[0])) {
+            e = 0;
+            return;
+        }
+        int k = std::ilogb(m[0]);
+        m = ldexp(m, -k);
+        e += k;
+    }
+
+    qdx_real operator-() const { return qdx_real(-m, e); }
+
+    bool is_zero() const { return m.is_zero(); }
+    bool is_negative() const { return m.is_negative(); }
+    bool is_positive() const { return m.is_positive(); }
+
+    QD_ASQ qdx_real &operator+=(const QD_ASQ qdx_real &a);
+    QD_ASQ qdx_real &operator-=(const QD_ASQ qdx_real &a);
+    QD_ASQ qdx_real &operator*=(const QD_ASQ qdx_real &a);
+    QD_ASQ qdx_real &operator/=(const QD_ASQ qdx_real &a);
+};
+
+#ifndef __METAL_VERSION__
+inline qdx_real::qdx_real(double d) {
+    int k;
+    double f = std::frexp(d, &k);
+    m = qd_real(f);
+    e = k;
+    normalize();
+}
+#endif
+
+/*********** Arithmetic ************/
+/* Aligns the operand with the smaller exponent to the other.  Beyond
+   a difference of 160 (96 bits plus the two mantissa windows) the
+   smaller one does not reach the last limb of the larger.            */
+inline qdx_real operator+(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    if (b.is_zero())
+        return a;
+    if (a.is_zero())
+        return b;
+    int d = a.e - b.e;
+    if (d > 160)
+        return a;
+    if (d < -160)
+        return b;
+    if (d >= 0)
+        return qdx_real(a.m + ldexp(b.m, -d), a.e);
+    return qdx_real(ldexp(a.m, d) + b.m, b.e);
+}
+
+inline qdx_real operator-(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return a + (-b);
+}
+
+inline qdx_real operator*(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return qdx_real(a.m * b.m, a.e + b.e);
+}
+
+inline qdx_real operator*(const QD_ASQ qdx_real &a, QDT b) {
+    return qdx_real(a.m * b, a.e);
+}
+
+inline qdx_real operator/(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return qdx_real(a.m / b.m, a.e - b.e);
+}
+
+inline qdx_real operator/(const QD_ASQ qdx_real &a, QDT b) {
+    return qdx_real(a.m / b, a.e);
+}
+
+inline qdx_real sqr(const QD_ASQ qdx_real &a) {
+    return qdx_real(sqr(a.m), 2 * a.e);
+}
+
+inline qdx_real sqrt(const QD_ASQ qdx_real &a) {
+    qd_real m = (a.e & 1) ? mul_pwr2(a.m, 2.0f) : a.m;
+    return qdx_real(sqrt(m), (a.e - (a.e & 1)) / 2);
+}
+
+/* a * 2^n; only the exponent changes. */
+inline qdx_real ldexp(const QD_ASQ qdx_real &a, int n) {
+    qdx_real r = a;
+    if (!r.is_zero())
+        r.e += n;
+    return r;
+}
+
+inline qdx_real abs(const QD_ASQ qdx_real &a) {
+    return a.is_negative() ? -a : a;
+}
+
+inline QD_ASQ qdx_real &qdx_real::operator+=(const QD_ASQ qdx_real &a) {
+    *this = *this + a;
+    return *this;
+}
+
+inline QD_ASQ qdx_real &qdx_real::operator-=(const QD_ASQ qdx_real &a) {
+    *this = *this - a;
+    return *this;
+}
+
+inline QD_ASQ qdx_real &qdx_real::operator*=(const QD_ASQ qdx_real &a) {
+    *this = *this * a;
+    return *this;
+}
+
+inline QD_ASQ qdx_real &qdx_real::operator/=(const QD_ASQ qdx_real &a) {
+    *this = *this / a;
+    return *this;
+}
+
+/*********** Comparisons ************/
+/* Sign of a - b. */
+inline int compare(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    qdx_real d = a - b;
+    return d.is_zero() ? 0 : (d.is_negative() ? -1 : 1);
+}
+
+inline bool operator==(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return compare(a, b) == 0;
+}
+
+inline bool operator!=(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return compare(a, b) != 0;
+}
+
+inline bool operator<(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return compare(a, b) < 0;
+}
+
+inline bool operator>(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return compare(a, b) > 0;
+}
+
+inline bool operator<=(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return compare(a, b) <= 0;
+}
+
+inline bool operator>=(const QD_ASQ qdx_real &a, const QD_ASQ qdx_real &b) {
+    return compare(a, b) >= 0;
+}
+
+/*********** Conversions ************/
+/* m * 2^e as a qd_real; limbs outside float's range are lost. */
+inline qd_real to_qd_real(const QD_ASQ qdx_real &a) {
+    return ldexp(a.m, a.e);
+}
+
+#ifndef __METAL_VERSION__
+/* The leading two limbs in double, which holds magnitudes to 1e-308. */
+inline double to_double(const qdx_real &a) {
+    return std::ldexp(static_cast<double>(a.m[0]) + a.m[1], a.e);
+}
+#endif
+
+#endif /* metal_qdx_h */
@@ -84,5 +84,18 @@
 #define QD_ISNAN(x) std::isnan(x)
 #endif
 
+/* Set the following to 1 if the compiler supports C++17.  The
+   mathematical constants of dd_real and qd_real are then also defined
+   constexpr in the headers, so they can be folded into inlined code.
+   The library defines them in src/dd_const.cpp and src/qd_const.cpp
+   regardless, so it links with clients compiled for any standard. */
+#ifndef QD_HAVE_CXX17
+#if defined(__cplusplus) && __cplusplus >= 201703L
+#define QD_HAVE_CXX17 1
+#else
+#define QD_HAVE_CXX17 0
+#endif
+#endif
+
 
 #endif /* _QD_QD_CONFIG_H */
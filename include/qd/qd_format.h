@@ -0,0 +1,220 @@
+/*
+ * include/qd_format.h
+ *
+ * Formatters for dd_real and qd_real for std::format (C++20) and for
+ * the fmt library.  For fmt, include <fmt/format.h> before this file.
+ *
+ * The format specification is that of double,
+ *
+ *   [[fill]align][sign][0][width][.precision][type]
+ *
+ * with the types e, E (scientific), f, F (fixed), g, G (general) and
+ * a, A (hexadecimal, exact).  Without a type the number is written as
+ * by to_string: in scientific notation with _ndigits digits after
+ * the point unless a precision is given.  Digits are generated by
+ * to_chars into a buffer on the stack and copied to the output.
+ */
+#ifndef _QD_QD_FORMAT_H
+#define _QD_QD_FORMAT_H
+
+#include <qd/qd_config.h>
+#include <qd/dd_real.h>
+#include <qd/qd_real.h>
+
+#if QD_HAVE_CXX17 && defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if QD_HAVE_CXX17 && (defined(__cpp_lib_format) || defined(FMT_VERSION))
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <vector>
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
+
+namespace qd_format_detail {
+
+/* A parsed format specification. */
+struct spec {
+  char fill = ' ';
+  char align = 0;      /* '<', '>', '^' or 0 for the default */
+  char sign = '-';     /* '-', '+' or ' ' */
+  bool zero = false;
+  int width = 0;
+  int precision = -1;
+  char type = 0;
+
+  /* Parses [p, end) up to the closing brace, leaving p at the brace
+     (or end).  Returns false if the specification is invalid.     */
+  template <class It>
+  constexpr bool parse(It &p, It end) {
+    auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+    if (p == end || *p == '}')
+      return true;
+
+    if (p + 1 != end && is_align(p[1]) && *p != '{' && *p != '}') {
+      fill = *p;
+      align = p[1];
+      p += 2;
+    } else if (is_align(*p)) {
+      align = *p++;
+    }
+    if (p != end && (*p == '+' || *p == '-' || *p == ' '))
+      sign = *p++;
+    if (p != end && *p == '0') {
+      zero = true;
+      ++p;
+    }
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+      width = width * 10 + (*p - '0');
+    if (p != end && *p == '.') {
+      ++p;
+      if (p == end || *p < '0' || *p > '9')
+        return false;
+      precision = 0;
+      for (; p != end && *p >= '0' && *p <= '9'; ++p)
+        precision = precision * 10 + (*p - '0');
+    }
+    if (p != end && *p != '}') {
+      char c = *p++;
+      switch (c) {
+        case 'e': case 'E': case 'f': case 'F':
+        case 'g': case 'G': case 'a': case 'A':
+          type = c;
+          break;
+        default:
+          return false;
+      }
+    }
+    if (p != end && *p != '}')
+      return false;
+    return true;
+  }
+
+  /* Writes a to out and returns the new output position. */
+  template <class T, class Out>
+  Out format(const T &a, Out out) const {
+    char buf[512];
+    std::vector<char> big;
+    char *first = buf, *last = buf + sizeof(buf);
+    std::to_chars_result r;
+
+    for (;;) {
+      switch (type) {
+        case 'f': case 'F':
+          r = (precision < 0) ?
+            to_chars(first, last, a, std::chars_format::fixed) :
+            to_chars(first, last, a, std::chars_format::fixed, precision);
+          break;
+        case 'g': case 'G':
+          r = (precision < 0) ?
+            to_chars(first, last, a, std::chars_format::general) :
+            to_chars(first, last, a, std::chars_format::general, precision);
+          break;
+        case 'a': case 'A':
+          r = to_chars(first, last, a, std::chars_format::hex);
+          break;
+        default:
+          r = to_chars(first, last, a, std::chars_format::scientific,
+                       (precision < 0) ? T::_ndigits : precision);
+          break;
+      }
+      if (r.ec != std::errc::value_too_large || !big.empty())
+        break;
+      /* Fixed notation of a large number with many digits. */
+      big.resize(std::max(precision, 0) + 400);
+      first = &big[0];
+      last = &big[0] + big.size();
+    }
+    char *p = first, *q = r.ptr;
+
+    if (type >= 'A' && type <= 'Z')
+      for (char *s = p; s != q; ++s)
+        if (*s >= 'a' && *s <= 'z') *s = static_cast<char>(*s - 'a' + 'A');
+
+    /* The sign is written before any zero padding. */
+    char sgn = 0;
+    if (*p == '-') {
+      sgn = *p++;
+    } else if (sign != '-') {
+      sgn = sign;
+    }
+    bool finite = std::isfinite(to_double(a));
+
+    int len = static_cast<int>(q - p) + (sgn != 0);
+    int pad = std::max(width - len, 0);
+    if (zero && align == 0 && finite) {
+      if (sgn) *out++ = sgn;
+      out = std::fill_n(out, pad, '0');
+      return std::copy(p, q, out);
+    }
+
+    int before = (align == '<') ? 0 : (align == '^') ? pad / 2 : pad;
+    out = std::fill_n(out, before, fill);
+    if (sgn) *out++ = sgn;
+    out = std::copy(p, q, out);
+    return std::fill_n(out, pad - before, fill);
+  }
+};
+
+}  /* namespace qd_format_detail */
+
+#if defined(__cpp_lib_format)
+template <class T>
+struct qd_std_formatter {
+  qd_format_detail::spec s;
+
+  constexpr auto parse(std::format_parse_context &ctx) {
+    auto p = ctx.begin();
+    if (!s.parse(p, ctx.end()))
+      throw std::format_error("invalid format specification for a "
+                              "dd_real or qd_real");
+    return p;
+  }
+
+  template <class Context>
+  auto format(const T &a, Context &ctx) const {
+    return s.format(a, ctx.out());
+  }
+};
+
+template <>
+struct std::formatter<dd_real, char> : qd_std_formatter<dd_real> {};
+template <>
+struct std::formatter<qd_real, char> : qd_std_formatter<qd_real> {};
+#endif
+
+#if defined(FMT_VERSION)
+template <class T>
+struct qd_fmt_formatter {
+  qd_format_detail::spec s;
+
+  FMT_CONSTEXPR auto parse(fmt::format_parse_context &ctx)
+      -> decltype(ctx.begin()) {
+    auto p = ctx.begin();
+    if (!s.parse(p, ctx.end()))
+      throw fmt::format_error("invalid format specification for a "
+                              "dd_real or qd_real");
+    return p;
+  }
+
+  template <class Context>
+  auto format(const T &a, Context &ctx) const -> decltype(ctx.out()) {
+    return s.format(a, ctx.out());
+  }
+};
+
+template <>
+struct fmt::formatter<dd_real, char> : qd_fmt_formatter<dd_real> {};
+template <>
+struct fmt::formatter<qd_real, char> : qd_fmt_formatter<qd_real> {};
+#endif
+
+#endif /* QD_HAVE_CXX17 && (__cpp_lib_format || FMT_VERSION) */
+
+#endif /* _QD_QD_FORMAT_H */
@@ -25,13 +25,6 @@
 #endif
 
 /********** Constructors **********/
-inline qd_real::qd_real(QDT x0, QDT x1, QDT x2, QDT x3) {
-  x[0] = x0;
-  x[1] = x1;
-  x[2] = x2;
-  x[3] = x3;
-}
-
 inline qd_real::qd_real(const QD_ASQ QDT *xx) {
   x[0] = xx[0];
   x[1] = xx[1];
@@ -0,0 +1,187 @@
+/*
+ * include/qd_io.h
+ *
+ * Bulk input and output of dd_real and qd_real arrays.
+ *
+ * Binary array files consist of a 64 byte header followed by the raw
+ * limbs.  In the default layout (array of structures) the limbs of
+ * each number are stored together, exactly as in memory, so a file in
+ * the native byte order can be mapped and used in place.  In the
+ * structure of arrays layout all leading limbs are stored first, then
+ * all second limbs, and so on, which suits vectorized processing.
+ *
+ * Text files hold decimal numbers separated by whitespace, in any
+ * format accepted by qd_real::read.  They are read and written in
+ * parallel.
+ */
+#ifndef _QD_QD_IO_H
+#define _QD_QD_IO_H
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+#include <stdint.h>
+#include <qd/qd_config.h>
+#include <qd/dd_real.h>
+#include <qd/qd_real.h>
+
+/* Layouts of the limb data. */
+enum qd_array_layout {
+  qd_array_aos = 0,   /* x[0].x[0], x[0].x[1], ..., x[1].x[0], ... */
+  qd_array_soa = 1    /* x[0].x[0], x[1].x[0], ..., x[0].x[1], ... */
+};
+
+/* File header.  All fields are written in the byte order of the
+   writer; endian reads as qd_array_endian_tag on a machine of the
+   same byte order.                                                */
+struct qd_array_header {
+  char magic[8];        /* "QDARRAY" */
+  uint32_t version;     /* qd_array_version */
+  uint32_t endian;      /* qd_array_endian_tag */
+  uint32_t limb_size;   /* bytes per limb: 8 (double) or 4 (float) */
+  uint32_t limbs;       /* limbs per number: 2 (dd) or 4 (qd) */
+  uint32_t layout;      /* qd_array_layout */
+  uint32_t reserved;
+  uint64_t count;       /* number of elements */
+  uint64_t data_offset; /* offset of the limb data from the start */
+  char pad[16];
+};
+
+const uint32_t qd_array_version = 1;
+const uint32_t qd_array_endian_tag = 0x01020304;
+
+/* Writes the n numbers in a to the file path.  Returns 0 on success
+   and -1 on failure, with errno describing the error.             */
+QD_API int qd_write_array(const char *path, const dd_real *a, size_t n,
+                          qd_array_layout layout = qd_array_aos);
+QD_API int qd_write_array(const char *path, const qd_real *a, size_t n,
+                          qd_array_layout layout = qd_array_aos);
+
+/* Read-only view of a binary array file.  The file is mapped into
+   memory; when it holds numbers of the requested type in the native
+   byte order and array of structures layout, dd_data() / qd_data()
+   point directly into the mapping.  Otherwise load() converts the
+   data into a caller supplied array.                              */
+class QD_API qd_mapped_array {
+public:
+  qd_mapped_array();
+  ~qd_mapped_array();
+
+  /* Maps the file path.  Returns 0 on success and -1 if the file
+     cannot be mapped or is not a valid array file.               */
+  int open(const char *path);
+  void close();
+
+  bool is_open() const { return base != 0; }
+  const qd_array_header &header() const { return hdr; }
+  size_t size() const { return static_cast<size_t>(hdr.count); }
+
+  /* In-place views; null unless the file matches as described above. */
+  const dd_real *dd_data() const;
+  const qd_real *qd_data() const;
+
+  /* Limb k of element 0 for a native double file in the structure of
+     arrays layout; limb k of element i is limb(k)[i].  Null otherwise. */
+  const double *limb(int k) const;
+
+  /* Copies the numbers into a, which must hold size() elements,
+     converting the layout, byte order and limb type as needed.
+     Numbers with more limbs than the destination keep only their
+     leading limbs; missing limbs are zero.  Returns 0 on success
+     and -1 if no file is open.                                    */
+  int load(dd_real *a) const;
+  int load(qd_real *a) const;
+
+private:
+  qd_mapped_array(const qd_mapped_array &);
+  qd_mapped_array &operator=(const qd_mapped_array &);
+
+  bool native() const;
+  int load_limbs(double *a, int nlimbs) const;
+
+  qd_array_header hdr;
+  const char *base;   /* start of the mapping */
+  size_t length;      /* length of the mapping */
+  bool swapped;       /* file has the opposite byte order */
+};
+
+/* A number that qd_read_text could not parse. */
+struct qd_text_error {
+  size_t index;   /* position in the output array */
+  size_t line;    /* line number, starting at 1 */
+  size_t column;  /* column of the first character, starting at 1 */
+};
+
+/* Reads all whitespace separated numbers in the file path into a,
+   splitting the work over nthreads threads (all hardware threads if
+   nthreads <= 0).  Numbers that cannot be parsed are stored as NaN
+   and, if errors is not null, appended to errors in file order.
+   Returns 0 on success and -1 if the file cannot be read or contains
+   invalid numbers, with errno describing the error.               */
+QD_API int qd_read_text(const char *path, std::vector<dd_real> &a,
+                        std::vector<qd_text_error> *errors = 0,
+                        int nthreads = 0);
+QD_API int qd_read_text(const char *path, std::vector<qd_real> &a,
+                        std::vector<qd_text_error> *errors = 0,
+                        int nthreads = 0);
+
+/* Same as qd_read_text, for the len characters at s. */
+QD_API int qd_parse_text(const char *s, size_t len, std::vector<dd_real> &a,
+                         std::vector<qd_text_error> *errors = 0,
+                         int nthreads = 0);
+QD_API int qd_parse_text(const char *s, size_t len, std::vector<qd_real> &a,
+                         std::vector<qd_text_error> *errors = 0,
+                         int nthreads = 0);
+
+/* Notations for qd_write_text. */
+enum qd_text_notation {
+  qd_text_auto = 0,        /* shorter of fixed and scientific */
+  qd_text_scientific = 1,
+  qd_text_fixed = 2,
+  qd_text_general = 3      /* as printf's %g */
+};
+
+/* Options of qd_write_text.  With a negative precision numbers are
+   written with the fewest digits that read back to within _eps of
+   their value, which is not always the same value; otherwise
+   precision is the number of digits after the point (the number of
+   significant digits for qd_text_general), and qd_text_auto is the
+   same as qd_text_scientific.                                     */
+struct qd_text_format {
+  int precision;
+  qd_text_notation notation;
+  char separator;          /* between columns, e.g. ' ' or ',' */
+  int nthreads;            /* <= 0 means all hardware threads */
+
+  explicit qd_text_format(int precision = -1,
+                          qd_text_notation notation = qd_text_auto,
+                          char separator = ' ', int nthreads = 0)
+    : precision(precision), notation(notation), separator(separator),
+      nthreads(nthreads) {}
+};
+
+/* Writes the n numbers in a to the file path, one per line.  The
+   numbers are formatted in blocks on several threads and written in
+   order.  Returns 0 on success and -1 on failure, with errno
+   describing the error.                                           */
+QD_API int qd_write_text(const char *path, const dd_real *a, size_t n,
+                         const qd_text_format &f = qd_text_format());
+QD_API int qd_write_text(const char *path, const qd_real *a, size_t n,
+                         const qd_text_format &f = qd_text_format());
+
+/* Writes n rows of ncols columns, where element i of column j is
+   columns[j][i], separated by f.separator.                         */
+QD_API int qd_write_text(const char *path, const dd_real *const *columns,
+                         size_t ncols, size_t n,
+                         const qd_text_format &f = qd_text_format());
+QD_API int qd_write_text(const char *path, const qd_real *const *columns,
+                         size_t ncols, size_t n,
+                         const qd_text_format &f = qd_text_format());
+QD_API int qd_write_text(std::FILE *file, const dd_real *const *columns,
+                         size_t ncols, size_t n,
+                         const qd_text_format &f = qd_text_format());
+QD_API int qd_write_text(std::FILE *file, const qd_real *const *columns,
+                         size_t ncols, size_t n,
+                         const qd_text_format &f = qd_text_format());
+
+#endif /* _QD_QD_IO_H */
@@ -39,6 +39,10 @@
 #include <string>
 #include <limits>
 #include <qd/qd_config.h>
+#if QD_HAVE_CXX17
+#include <charconv>
+#include <string_view>
+#endif
 #include <qd/dd_real.h>
 #else
 #include "qd_config.h"
@@ -58,7 +62,7 @@ struct QD_API qd_real {
   void quick_accum(QDT d, QD_ASQ QDT &e);
   void quick_prod_accum(QDT a, QDT b, QD_ASQ QDT &e);
 
-  qd_real(QDT x0, QDT x1, QDT x2, QDT x3);
+  constexpr qd_real(QDT x0, QDT x1, QDT x2, QDT x3) : x{x0, x1, x2, x3} {}
   explicit qd_real(const QD_ASQ QDT *xx);
 
 #if !QD_GPU
@@ -172,10 +176,15 @@ struct QD_API qd_real {
   void to_digits(char *s, int &expn, int precision = _ndigits) const;
   void write(char *s, int len, int precision = _ndigits, 
       bool showpos = false, bool uppercase = false) const;
+  /* With fmt == std::hexfloat the limbs are written exactly in
+     hexadecimal, and read parses them back bit for bit. */
   std::string to_string(int precision = _ndigits, int width = 0, 
       std::ios_base::fmtflags fmt = static_cast<std::ios_base::fmtflags>(0), 
       bool showpos = false, bool uppercase = false, char fill = ' ') const;
   static int read(const char *s, qd_real &a);
+#if QD_HAVE_CXX17
+  static const char *parse(std::string_view s, qd_real &a);
+#endif
 
   /* Debugging methods */
   void dump(const std::string &name = "", std::ostream &os = std::cerr) const;
@@ -187,6 +196,62 @@ struct QD_API qd_real {
 
 };
 
+#if !QD_GPU && QD_HAVE_CXX17
+/* Some useful constants. */
+inline constexpr qd_real qd_real::_2pi = qd_real(6.283185307179586232e+00,
+                                                 2.449293598294706414e-16,
+                                                 -5.989539619436679332e-33,
+                                                 2.224908441726730563e-49);
+inline constexpr qd_real qd_real::_pi = qd_real(3.141592653589793116e+00,
+                                                1.224646799147353207e-16,
+                                                -2.994769809718339666e-33,
+                                                1.112454220863365282e-49);
+inline constexpr qd_real qd_real::_pi2 = qd_real(1.570796326794896558e+00,
+                                                 6.123233995736766036e-17,
+                                                 -1.497384904859169833e-33,
+                                                 5.562271104316826408e-50);
+inline constexpr qd_real qd_real::_pi4 = qd_real(7.853981633974482790e-01,
+                                                 3.061616997868383018e-17,
+                                                 -7.486924524295849165e-34,
+                                                 2.781135552158413204e-50);
+inline constexpr qd_real qd_real::_3pi4 = qd_real(2.356194490192344837e+00,
+                                                  9.1848509936051484375e-17,
+                                                  3.9168984647504003225e-33,
+                                                  -2.5867981632704860386e-49);
+inline constexpr qd_real qd_real::_e = qd_real(2.718281828459045091e+00,
+                                               1.445646891729250158e-16,
+                                               -2.127717108038176765e-33,
+                                               1.515630159841218954e-49);
+inline constexpr qd_real qd_real::_log2 = qd_real(6.931471805599452862e-01,
+                                                  2.319046813846299558e-17,
+                                                  5.707708438416212066e-34,
+                                                  -3.582432210601811423e-50);
+inline constexpr qd_real qd_real::_log10 = qd_real(2.302585092994045901e+00,
+                                                   -2.170756223382249351e-16,
+                                                   -9.984262454465776570e-33,
+                                                   -4.023357454450206379e-49);
+inline constexpr qd_real qd_real::_nan = 
+    qd_real(std::numeric_limits<QDT>::quiet_NaN(),
+            std::numeric_limits<QDT>::quiet_NaN(),
+            std::numeric_limits<QDT>::quiet_NaN(),
+            std::numeric_limits<QDT>::quiet_NaN());
+inline constexpr qd_real qd_real::_inf = 
+    qd_real(std::numeric_limits<QDT>::infinity(),
+            std::numeric_limits<QDT>::infinity(),
+            std::numeric_limits<QDT>::infinity(),
+            std::numeric_limits<QDT>::infinity());
+
+inline constexpr QDT qd_real::_eps = 1.21543267145725e-63; // = 2^-209
+inline constexpr QDT qd_real::_min_normalized = 1.6259745436952323e-260; // = 2^(-1022 + 3*53)
+inline constexpr qd_real qd_real::_max = qd_real(
+    1.79769313486231570815e+308, 9.97920154767359795037e+291, 
+    5.53956966280111259858e+275, 3.07507889307840487279e+259);
+inline constexpr qd_real qd_real::_safe_max = qd_real(
+    1.7976931080746007281e+308,  9.97920154767359795037e+291, 
+    5.53956966280111259858e+275, 3.07507889307840487279e+259);
+inline constexpr int qd_real::_ndigits = 62;
+#endif
+
 #if !QD_GPU
 namespace std {
   template <>
@@ -255,6 +320,7 @@ QD_API qd_real sqr(const QD_ASQ qd_real &a);
 QD_API qd_real sqrt(const QD_ASQ qd_real &a);
 QD_API qd_real pow(const QD_ASQ qd_real &a, int n);
 QD_API qd_real pow(const QD_ASQ qd_real &a, const QD_ASQ qd_real &b);
+QD_API qd_real pow(const QD_ASQ qd_real &a, QDT b);
 QD_API qd_real npwr(const QD_ASQ qd_real &a, int n);
 
 QD_API qd_real nroot(const QD_ASQ qd_real &a, int n);
@@ -346,6 +412,25 @@ QD_API qd_real exp(const QD_ASQ qd_real &a);
 QD_API qd_real log(const QD_ASQ qd_real &a);
 QD_API qd_real log10(const QD_ASQ QD_ASQ qd_real &a);
 
+/* Precision-tunable versions of exp, log, sin and cos.  These stop the
+   Taylor series and Newton iterations once about `bits' bits are
+   correct, so the cost drops with the requested accuracy.  exp returns
+   a result with relative error about 2^-bits; log, sin and cos return
+   a result with absolute error about 2^-bits * max(1, |result|).
+   Requests of numeric_limits<qd_real>::digits bits or more give the
+   full precision result.                                             */
+QD_API qd_real exp(const QD_ASQ qd_real &a, int bits);
+QD_API qd_real log(const QD_ASQ qd_real &a, int bits);
+QD_API qd_real sin(const QD_ASQ qd_real &a, int bits);
+QD_API qd_real cos(const QD_ASQ qd_real &a, int bits);
+
+/* Error function, complementary error function, gamma function and
+   log |Gamma|. */
+QD_API qd_real erf(const QD_ASQ qd_real &a);
+QD_API qd_real erfc(const QD_ASQ qd_real &a);
+QD_API qd_real tgamma(const QD_ASQ qd_real &a);
+QD_API qd_real lgamma(const QD_ASQ qd_real &a);
+
 QD_API qd_real sinh(const QD_ASQ qd_real &a);
 QD_API qd_real cosh(const QD_ASQ qd_real &a);
 QD_API qd_real tanh(const QD_ASQ qd_real &a);
@@ -367,6 +452,25 @@ QD_API qd_real fmod(const QD_ASQ qd_real &a, const QD_ASQ qd_real &b);
 #if !QD_GPU
 QD_API std::ostream &operator<<(std::ostream &s, const qd_real &a);
 QD_API std::istream &operator>>(std::istream &s, qd_real &a);
+
+#if QD_HAVE_CXX17
+/* Writes a to [first, last) in the manner of std::to_chars, without
+   allocating; ties are rounded away from zero.  Without a precision,
+   as few significant digits are written as are needed for
+   qd_real::parse to read back a to within qd_real::_eps ("shortest
+   within eps"); this is not an exact round trip, since the value
+   read back may differ from a in its last bits.
+   std::chars_format::hex writes the limbs exactly, as hexadecimal
+   floating-point numbers joined by their signs (0x1.8p+0-0x1p-60);
+   precision is ignored for it.                                    */
+QD_API std::to_chars_result to_chars(char *first, char *last, 
+                                     const qd_real &a);
+QD_API std::to_chars_result to_chars(char *first, char *last, 
+                                     const qd_real &a, std::chars_format fmt);
+QD_API std::to_chars_result to_chars(char *first, char *last, 
+                                     const qd_real &a, std::chars_format fmt,
+                                     int precision);
+#endif
 #endif
 #ifdef QD_INLINE
 #if !QD_GPU
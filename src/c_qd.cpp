@@ -396,6 +396,15 @@ void c_qd_swrite(const double *a, int precision, char *s, int len) {
   qd_real(a).write(s, len, precision);
 }
 
+/* Writes the exact limbs of a in hexadecimal; c_qd_read reads them
+   back bit for bit. */
+void c_qd_swrite_hex(const double *a, char *s, int len) {
+  std::string str = qd_real(a).to_string(0, 0, std::ios_base::fixed |
+                                          std::ios_base::scientific);
+  std::strncpy(s, str.c_str(), len - 1);
+  s[len - 1] = 0;
+}
+
 void c_qd_write(const double *a) {
   std::cout << qd_real(a).to_string(qd_real::_ndigits) << std::endl;
 }
@@ -10,6 +10,11 @@
 #include "config.h"
 #include <qd/dd_real.h>
 
+/* With C++17 these are inline constexpr variables in dd_real.h, which
+   are only emitted where they are odr-used.  The table below uses them
+   all, so that the library defines them for clients compiled for C++11
+   or C++14 too, whatever standard it is built with. */
+#if !QD_HAVE_CXX17
 const dd_real dd_real::_2pi = dd_real(6.283185307179586232e+00,
                                       2.449293598294706414e-16);
 const dd_real dd_real::_pi = dd_real(3.141592653589793116e+00,
@@ -36,5 +41,12 @@ const dd_real dd_real::_max =
 const dd_real dd_real::_safe_max = 
     dd_real(1.7976931080746007281e+308, 9.97920154767359795037e+291);
 const int dd_real::_ndigits = 31;
-
+#else
+extern const void *const qd_dd_constants[] = {
+    &dd_real::_2pi, &dd_real::_pi, &dd_real::_pi2, &dd_real::_pi4,
+    &dd_real::_3pi4, &dd_real::_e, &dd_real::_log2, &dd_real::_log10,
+    &dd_real::_nan, &dd_real::_inf, &dd_real::_eps,
+    &dd_real::_min_normalized, &dd_real::_max, &dd_real::_safe_max,
+    &dd_real::_ndigits};
+#endif
 
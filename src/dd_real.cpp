@@ -166,8 +166,8 @@ dd_real pow(const dd_real &a, const dd_real &b) {
   return exp(b * log(a));
 }
 
-static const int n_inv_fact = 15;
-static const double inv_fact[n_inv_fact][2] = {
+static constexpr int n_inv_fact = 15;
+static constexpr double inv_fact[n_inv_fact][2] = {
   { 1.66666666666666657e-01,  9.25185853854297066e-18},
   { 4.16666666666666644e-02,  2.31296463463574266e-18},
   { 8.33333333333333322e-03,  1.15648231731787138e-19},
@@ -185,19 +185,290 @@ static const double inv_fact[n_inv_fact][2] = {
   { 2.81145725434552060e-15,  1.65088427308614326e-31}
 };
 
+/* Requests of at most this many bits are answered by the double
+   precision library functions. */
+static const int max_double_bits = 50;
+
+/* Table of 2^(j/256), j = 0, ..., 255. */
+static constexpr double exp2_table[256][2] = {
+  { 1.00000000000000000e+00,  0.00000000000000000e+00},
+  { 1.00271127505020252e+00, -3.63661592869226394e-17},
+  { 1.00542990111280273e+00,  9.49918653545503176e-17},
+  { 1.00815589811841755e+00, -3.25205875608430806e-17},
+  { 1.01088928605170048e+00, -1.52347786033685772e-17},
+  { 1.01363008495148943e+00,  9.28359976818356759e-18},
+  { 1.01637831491095310e+00, -5.77217007319966003e-17},
+  { 1.01913399607773791e+00,  3.60190498225966172e-17},
+  { 1.02189714865411663e+00,  5.10922502897344389e-17},
+  { 1.02466779289713572e+00, -7.56160786848777944e-17},
+  { 1.02744594911876375e+00, -4.95607417464537044e-17},
+  { 1.03023163768604098e+00,  3.31983004108081294e-17},
+  { 1.03302487902122841e+00,  7.60083887402708849e-18},
+  { 1.03582569360195720e+00, -7.80678239133763617e-17},
+  { 1.03863410196137873e+00,  5.99627378885251062e-17},
+  { 1.04145012468831610e+00,  3.78483048028757621e-17},
+  { 1.04427378242741375e+00,  8.55188970553796489e-17},
+  { 1.04710509587928979e+00,  7.27707724310431475e-17},
+  { 1.04994408580068721e+00,  5.59293784812700259e-17},
+  { 1.05279077300462642e+00, -9.62948289902693574e-17},
+  { 1.05564517836055716e+00,  1.75932573877209198e-18},
+  { 1.05850732279451276e+00, -7.15265185663778074e-17},
+  { 1.06137722728926209e+00, -1.19735370853656576e-17},
+  { 1.06425491288446450e+00,  5.07875419861123039e-17},
+  { 1.06714040067682370e+00, -7.89985396684158212e-17},
+  { 1.07003371182024187e+00, -9.93716271128891938e-17},
+  { 1.07293486752597556e+00, -3.83966884335882381e-18},
+  { 1.07584388906279105e+00, -1.00027161511441361e-17},
+  { 1.07876079775711986e+00, -6.65666043605659260e-17},
+  { 1.08168561499321525e+00, -4.78262390299708627e-17},
+  { 1.08461836221330921e+00,  3.16615284581634612e-17},
+  { 1.08755906091776966e+00,  5.40934930782029076e-18},
+  { 1.09050773266525769e+00, -3.04678207981247115e-17},
+  { 1.09346439907288584e+00,  1.44139581472692093e-17},
+  { 1.09642908181637688e+00, -5.91993348444931582e-17},
+  { 1.09940180263022191e+00,  7.17045959970192322e-17},
+  { 1.10238258330784089e+00,  5.26603687157069439e-17},
+  { 1.10537144570174117e+00,  8.23928876050021359e-17},
+  { 1.10836841172367873e+00, -8.78681384518052662e-17},
+  { 1.11137350334481755e+00,  5.56394502666969764e-17},
+  { 1.11438674259589243e+00,  1.04102784568455710e-16},
+  { 1.11740815156736928e+00, -7.97680590262822046e-17},
+  { 1.12043775240960675e+00, -6.20108590655417875e-17},
+  { 1.12347556733301990e+00, -9.69973758898704300e-17},
+  { 1.12652161860824185e+00,  5.16585675879545674e-17},
+  { 1.12957592856628808e+00,  6.71280585872625659e-17},
+  { 1.13263851959871920e+00,  3.23735616673800026e-17},
+  { 1.13570941415780546e+00,  5.06659992612615586e-17},
+  { 1.13878863475669156e+00,  8.91281267602540778e-17},
+  { 1.14187620396956158e+00,  4.65109117753141239e-17},
+  { 1.14497214443180417e+00,  4.64128989217001066e-17},
+  { 1.14807647884017894e+00,  6.89774023662719177e-17},
+  { 1.15118922995298267e+00,  3.25071021886382721e-17},
+  { 1.15431042059021594e+00,  1.04171289462732662e-16},
+  { 1.15744007363375112e+00, -9.12387123113440029e-17},
+  { 1.16057821202749878e+00, -3.26104020541739372e-17},
+  { 1.16372485877757748e+00,  3.82920483692409350e-17},
+  { 1.16688003695248166e+00, -8.79187957999916974e-17},
+  { 1.17004376968325019e+00, -1.84774420179000469e-18},
+  { 1.17321608016363732e+00, -7.28756258658499448e-17},
+  { 1.17639699165028122e+00,  5.55420325421807896e-17},
+  { 1.17958652746287584e+00,  1.00923127751003904e-16},
+  { 1.18278471098434101e+00,  1.54297543007907606e-17},
+  { 1.18599156566099384e+00, -9.20950683529310590e-18},
+  { 1.18920711500272103e+00,  3.98201523146564611e-17},
+  { 1.19243138258315118e+00,  4.39755141560972144e-17},
+  { 1.19566439203982733e+00,  4.61660367048148140e-17},
+  { 1.19890616707438058e+00, -9.80919335600842312e-17},
+  { 1.20215673145270308e+00,  6.64498149925230124e-17},
+  { 1.20541610900512386e+00, -3.35727219326752963e-17},
+  { 1.20868432362658162e+00, -4.74672594522898410e-17},
+  { 1.21196139927680124e+00, -4.89061107752111836e-17},
+  { 1.21524735998046896e+00, -7.71263069268148813e-17},
+  { 1.21854222982740845e+00, -9.00672695836383767e-17},
+  { 1.22184603297275762e+00, -1.06110212114026912e-16},
+  { 1.22515879363714553e+00, -8.90353381426998343e-17},
+  { 1.22848053610687002e+00, -1.89878163130252995e-17},
+  { 1.23181128473407586e+00,  7.38938247161005025e-17},
+  { 1.23515106393693341e+00, -1.07552443443078414e-16},
+  { 1.23849989819981654e+00,  2.76770205557396743e-17},
+  { 1.24185781207348400e+00,  4.65802759183693679e-17},
+  { 1.24522483017525798e+00, -4.67724044984672750e-17},
+  { 1.24860097718920482e+00, -8.26181099902196355e-17},
+  { 1.25198627786631622e+00,  4.83416715246989760e-17},
+  { 1.25538075702469110e+00, -6.71138982129687842e-18},
+  { 1.25878443954971653e+00, -8.42178258773059936e-17},
+  { 1.26219735039425074e+00, -3.08446488747384647e-17},
+  { 1.26561951457880628e+00,  4.25057700345086864e-17},
+  { 1.26905095719173322e+00,  2.66793213134218610e-18},
+  { 1.27249170338940276e+00, -1.05779162672124210e-17},
+  { 1.27594177839639200e+00,  9.91543024421429033e-17},
+  { 1.27940120750566932e+00, -9.75909500835606221e-17},
+  { 1.28287001607877826e+00,  1.71359491824356097e-17},
+  { 1.28634822954602557e+00, -3.41695570693618198e-17},
+  { 1.28983587340666572e+00,  8.94925753089759172e-17},
+  { 1.29333297322908947e+00, -2.97459044313275165e-17},
+  { 1.29683955465100964e+00,  2.53825027948883150e-17},
+  { 1.30035564337965059e+00,  5.67872810280221742e-17},
+  { 1.30388126519193581e+00,  8.64767559826787118e-17},
+  { 1.30741644593467732e+00, -7.33664565287886889e-17},
+  { 1.31096121152476441e+00, -7.18153613551945386e-17},
+  { 1.31451558794935464e+00,  2.26754331510458565e-17},
+  { 1.31807960126606405e+00, -5.45795582714915350e-17},
+  { 1.32165327760315754e+00, -2.48063824591302174e-17},
+  { 1.32523664315974132e+00, -2.85873121003886137e-17},
+  { 1.32882972420595435e+00,  4.08908622391016005e-17},
+  { 1.33243254708316150e+00, -5.10158663091674396e-17},
+  { 1.33604513820414583e+00, -5.89186635638880135e-17},
+  { 1.33966752405330292e+00,  8.92728259483173198e-17},
+  { 1.34329973118683532e+00, -5.80258089020143775e-17},
+  { 1.34694178623294580e+00,  3.22406510125467917e-17},
+  { 1.35059371589203447e+00, -8.28711038146241653e-17},
+  { 1.35425554693689265e+00,  7.70094837980298946e-17},
+  { 1.35792730621290114e+00, -9.52963574482518887e-17},
+  { 1.36160902063822475e+00,  1.53378766127066805e-18},
+  { 1.36530071720401192e+00, -1.00053631259747652e-16},
+  { 1.36900242297459052e+00,  9.59379791911884877e-17},
+  { 1.37271416508766841e+00, -4.49596059523484126e-17},
+  { 1.37643597075453017e+00, -6.89858893587180104e-17},
+  { 1.38016786726023799e+00,  1.05103145799699839e-16},
+  { 1.38390988196383202e+00, -6.77051165879478629e-17},
+  { 1.38766204229852907e+00,  8.42298427487541532e-17},
+  { 1.39142437577192624e+00, -4.90617486528898932e-17},
+  { 1.39519690996620027e+00, -9.32933622422549655e-17},
+  { 1.39897967253831124e+00, -9.61421320905132307e-17},
+  { 1.40277269122020476e+00, -5.29578324940798922e-17},
+  { 1.40657599381901544e+00,  7.03491481213642219e-18},
+  { 1.41038960821727066e+00,  4.16654872843506226e-17},
+  { 1.41421356237309515e+00, -9.66729331345291345e-17},
+  { 1.41804788432041518e+00,  2.27443854218552945e-17},
+  { 1.42189260216916558e+00, -1.60778289158902441e-17},
+  { 1.42574774410549421e+00,  9.88069075850060728e-17},
+  { 1.42961333839197002e+00, -1.20316424890536552e-17},
+  { 1.43348941336778890e+00, -5.80245424392682610e-17},
+  { 1.43737599744898237e+00, -4.20403401646755661e-17},
+  { 1.44127311912862566e+00,  5.60250365087898568e-18},
+  { 1.44518080697704665e+00, -3.02375813499398732e-17},
+  { 1.44909908964203504e+00, -6.25940500081930925e-17},
+  { 1.45302799584905262e+00, -5.77994860939610610e-17},
+  { 1.45696755440144377e+00,  5.64867945387699814e-17},
+  { 1.46091779418064704e+00, -5.60037718607521580e-17},
+  { 1.46487874414640573e+00,  9.53076754358715732e-17},
+  { 1.46885043333698184e+00,  8.46588275653362761e-17},
+  { 1.47283289086936753e+00,  6.69177408194058937e-17},
+  { 1.47682614593949935e+00, -3.48399455689279580e-17},
+  { 1.48083022782247187e+00, -9.68695210263061858e-17},
+  { 1.48484516587275239e+00,  1.07800867644074808e-16},
+  { 1.48887098952439700e+00,  6.15536715774287133e-17},
+  { 1.49290772829126484e+00,  1.41929201542840358e-17},
+  { 1.49695541176723546e+00, -2.86166325389915821e-17},
+  { 1.50101406962642558e+00, -6.41376727579023504e-17},
+  { 1.50508373162340647e+00,  7.07471061358284636e-17},
+  { 1.50916442759342284e+00, -1.01645532775429504e-16},
+  { 1.51325618745260981e+00,  8.88449785133871209e-17},
+  { 1.51735904119821474e+00, -4.30869947204334080e-17},
+  { 1.52147301890881459e+00, -5.99638767594568342e-18},
+  { 1.52559815074453842e+00, -1.10249417123425609e-16},
+  { 1.52973446694728699e+00,  3.78579211515721965e-17},
+  { 1.53388199784095591e+00,  8.87522684443844614e-17},
+  { 1.53804077383165683e+00,  1.01746723511613593e-16},
+  { 1.54221082540794074e+00,  7.94983480969762086e-17},
+  { 1.54639218314102145e+00,  1.06839600056572198e-16},
+  { 1.55058487768499997e+00, -1.46007065906893852e-17},
+  { 1.55478893977708865e+00, -8.00316135011603564e-17},
+  { 1.55900440023783693e+00,  3.78120705335752750e-17},
+  { 1.56323128997135763e+00,  7.48477764559073439e-17},
+  { 1.56746963996555300e+00, -1.03520617688497220e-16},
+  { 1.57171948129234140e+00, -3.34298400468720007e-17},
+  { 1.57598084510788650e+00, -1.01369164712783040e-17},
+  { 1.58025376265282458e+00, -5.16340292955446806e-17},
+  { 1.58453826525249375e+00, -1.93377170345857029e-17},
+  { 1.58883438431716395e+00, -5.99495011882447940e-18},
+  { 1.59314215134226700e+00, -1.00944065423119637e-16},
+  { 1.59746159790862707e+00,  2.48683927962209992e-17},
+  { 1.60179275568269341e+00, -6.05491745352778434e-17},
+  { 1.60613565641677103e+00, -1.03545452880599953e-16},
+  { 1.61049033194925428e+00,  2.47071925697978879e-17},
+  { 1.61485681420486071e+00, -7.31666339912512326e-17},
+  { 1.61923513519486373e+00,  2.09413341542290924e-17},
+  { 1.62362532701732887e+00, -3.58451285141447471e-17},
+  { 1.62802742185734783e+00, -6.71295508470708409e-17},
+  { 1.63244145198727497e+00,  9.85281923042999296e-17},
+  { 1.63686744976696441e+00,  7.69832507131987557e-17},
+  { 1.64130544764400632e+00, -9.24756873764070551e-17},
+  { 1.64575547815396495e+00, -1.01256799136747726e-16},
+  { 1.65021757392061774e+00,  9.13327958872990419e-18},
+  { 1.65469176765619430e+00,  9.64329430319602866e-17},
+  { 1.65917809216161616e+00, -7.27554555082305065e-17},
+  { 1.66367658032673638e+00,  5.89099269671309967e-17},
+  { 1.66818726513058246e+00,  4.26917801957061509e-17},
+  { 1.67271017964159663e+00, -5.47671596459956308e-17},
+  { 1.67724535701787847e+00,  8.30394950995073279e-17},
+  { 1.68179283050742900e+00,  8.19901002058149652e-17},
+  { 1.68635263344839337e+00, -7.18146327835801067e-17},
+  { 1.69092479926930528e+00, -9.66967147439488017e-17},
+  { 1.69550936148933262e+00,  7.23841687284516664e-17},
+  { 1.70010635371852348e+00, -8.02371937039770025e-18},
+  { 1.70471580965805125e+00, -2.72888328479728156e-17},
+  { 1.70933776310046293e+00, -9.86877945663293108e-17},
+  { 1.71397224792992597e+00,  6.47397510775336706e-17},
+  { 1.71861929812247793e+00, -1.85138041826311099e-17},
+  { 1.72327894774627399e+00, -9.52212380039379996e-17},
+  { 1.72795123096183767e+00, -1.07509818612046424e-16},
+  { 1.73263618202231107e+00, -1.69805107431541549e-18},
+  { 1.73733383527370622e+00,  3.16438929929295695e-17},
+  { 1.74204422515515644e+00, -1.52595911895078879e-18},
+  { 1.74676738619916905e+00, -1.07522904835075145e-16},
+  { 1.75150335303187821e+00, -5.12445042059672466e-17},
+  { 1.75625216037329945e+00,  2.96014069544887331e-17},
+  { 1.76101384303758390e+00, -7.94325312503922771e-17},
+  { 1.76578843593327273e+00,  9.46131501808326787e-17},
+  { 1.77057597406355471e+00,  5.96179451004055585e-17},
+  { 1.77537649252652119e+00,  6.42973179655657203e-17},
+  { 1.78019002651542446e+00, -5.28462728909161737e-17},
+  { 1.78501661131893496e+00,  1.53304001210313138e-17},
+  { 1.78985628232140104e+00, -4.15435466068335039e-17},
+  { 1.79470907500310717e+00,  1.82274584279120868e-17},
+  { 1.79957502494053512e+00, -2.52688923335889795e-17},
+  { 1.80445416780662393e+00, -5.17722240879331788e-17},
+  { 1.80934653937103196e+00, -9.03264140245002968e-17},
+  { 1.81425217550039886e+00, -9.96953153892034882e-17},
+  { 1.81917111215860849e+00,  7.40267690114583889e-17},
+  { 1.82410338540705341e+00, -1.01596278622770831e-16},
+  { 1.82904903140489727e+00,  6.88919290883569564e-17},
+  { 1.83400808640934243e+00,  3.28310722424562720e-17},
+  { 1.83898058677589371e+00,  6.91896974027251194e-18},
+  { 1.84396656895862598e+00, -5.93974202694996455e-17},
+  { 1.84896606951045084e+00,  9.02758044626108929e-17},
+  { 1.85397912508338547e+00,  9.76188749072759354e-17},
+  { 1.85900577242882048e+00, -9.52870546198994069e-17},
+  { 1.86404604839778898e+00,  6.54091268062057171e-17},
+  { 1.86909998994123860e+00, -9.93850521425506708e-17},
+  { 1.87416763411029996e+00, -6.12276341300414256e-17},
+  { 1.87924901805656019e+00, -1.62263155578358448e-17},
+  { 1.88434417903233453e+00, -8.22659312553371091e-17},
+  { 1.88945315439093919e+00, -9.00516828505912672e-17},
+  { 1.89457598158696561e+00,  3.40340353521652967e-17},
+  { 1.89971269817655530e+00, -3.85973976937851432e-17},
+  { 1.90486334181767414e+00,  6.53385751471827863e-17},
+  { 1.91002795027038985e+00, -5.90968800674406024e-17},
+  { 1.91520656139714740e+00, -1.06199460561959626e-16},
+  { 1.92039921316304740e+00,  7.11668154063031419e-17},
+  { 1.92560594363612503e+00, -9.91496376969374093e-17},
+  { 1.93082679098762711e+00,  6.16714970616910955e-17},
+  { 1.93606179349229435e+00,  1.03323859606763257e-16},
+  { 1.94131098952864045e+00, -6.63802989162148799e-17},
+  { 1.94657441757923322e+00,  6.81102234953387718e-17},
+  { 1.95185211623097832e+00, -2.19901696997935109e-17},
+  { 1.95714412417540018e+00,  8.96076779103666777e-17},
+  { 1.96245048020892732e+00,  1.09768440009135469e-16},
+  { 1.96777122323317588e+00, -1.03149280115311315e-16},
+  { 1.97310639225523432e+00, -7.45161786395603749e-18},
+  { 1.97845602638795093e+00,  4.03887531092781666e-17},
+  { 1.98382016485021939e+00, -2.20345441239106266e-17},
+  { 1.98919884696726634e+00,  8.20513263836919942e-18},
+  { 1.99459211217094023e+00,  1.79097103520026451e-17}
+};
+
+/* log(2)/256 split into three parts; the first two have 34 significant
+   bits, so that their products with the reduction multiple are exact. */
+static const double log2_256_1 = 2.70760617399901093e-03;
+static const double log2_256_2 = 6.32754304150642633e-14;
+static const double log2_256_3 = 1.56292396391199976e-24;
+static const double inv_log2_256 = 3.69329930467574627e+02;  /* 256/log(2) */
+
 /* Exponential.  Computes exp(x) in double-double precision. */
 dd_real exp(const dd_real &a) {
-  /* Strategy:  We first reduce the size of x by noting that
-     
-          exp(kr + m * log(2)) = 2^m * exp(r)^k
+  /* Strategy:  Write  a = (256 m + j) * log(2)/256 + r  with integers
+     m, 0 <= j < 256 and |r| <= log(2)/512, so that
+
+          exp(a) = 2^m * 2^(j/256) * exp(r).
 
-     where m and k are integers.  By choosing m appropriately
-     we can make |kr| <= log(2) / 2 = 0.347.  Then exp(r) is 
-     evaluated using the familiar Taylor series.  Reducing the 
-     argument substantially speeds up the convergence.       */  
+     2^(j/256) is taken from a table and exp(r) - 1 is a degree 9
+     polynomial.  Its terms beyond r^4 are below 2^-54 relative to
+     the result, so they are summed in double precision.           */
 
-  const double k = 512.0;
-  const double inv_k = 1.0 / k;
+  if (a.isnan())
+    return dd_real::_nan;
 
   if (a.x[0] <= -709.0)
     return 0.0;
@@ -211,56 +482,144 @@ dd_real exp(const dd_real &a) {
   if (a.is_one())
     return dd_real::_e;
 
-  double m = std::floor(a.x[0] / dd_real::_log2.x[0] + 0.5);
-  dd_real r = mul_pwr2(a - dd_real::_log2 * m, inv_k);
-  dd_real s, t, p;
+  double n = std::floor(a.x[0] * inv_log2_256 + 0.5);
+  dd_real r = ((a - n * log2_256_1) - n * log2_256_2) - n * log2_256_3;
+  int i = static_cast<int>(n);
+  int j = i & 255;
+  int m = (i - j) / 256;
+
+  double rh = r.x[0];
+  double t = rh * (inv_fact[2][0] + rh * (inv_fact[3][0] +
+             rh * (inv_fact[4][0] + rh * (inv_fact[5][0] +
+             rh * inv_fact[6][0]))));
+  dd_real p = dd_real(inv_fact[1][0], inv_fact[1][1]) + t;
+  p = dd_real(inv_fact[0][0], inv_fact[0][1]) + r * p;
+  p = 0.5 + r * p;
+  p = r + sqr(r) * p;
+
+  dd_real c(exp2_table[j][0], exp2_table[j][1]);
+  return ldexp(c + c * p, m);
+}
 
-  p = sqr(r);
-  s = r + mul_pwr2(p, 0.5);
-  p *= r;
-  t = p * dd_real(inv_fact[0][0], inv_fact[0][1]);
-  int i = 0;
-  do {
-    s += t;
-    p *= r;
-    ++i;
-    t = p * dd_real(inv_fact[i][0], inv_fact[i][1]);
-  } while (std::abs(to_double(t)) > inv_k * dd_real::_eps && i < 5);
+/* Exponential to about `bits' bits. */
+dd_real exp(const dd_real &a, int bits) {
+  if (bits > max_double_bits || a.x[0] <= -709.0 || a.x[0] >= 709.0)
+    return exp(a);
 
-  s += t;
+  return std::exp(a.x[0]) * (1.0 + a.x[1]);
+}
 
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s = mul_pwr2(s, 2.0) + sqr(s);
-  s += 1.0;
+/* Table of log(j/128), j = 91, ..., 181. */
+static constexpr double log_table[91][2] = {
+  {-3.41170757402767144e-01,  1.93667900626028670e-17},
+  {-3.30241686870576867e-01,  1.08283216374838579e-17},
+  {-3.19430770766361227e-01, -1.35425685726481107e-18},
+  {-3.08735481649613286e-01,  1.61991860851481022e-17},
+  {-2.98153372319076349e-01,  1.72069586744586604e-17},
+  {-2.87682072451780901e-01, -2.60716061644256398e-17},
+  {-2.77319285416234351e-01,  7.44528405583512968e-18},
+  {-2.67062785249045254e-01,  7.32891532732016949e-18},
+  {-2.56910413785027214e-01, -2.50284329615250405e-17},
+  {-2.46860077931525784e-01, -1.36174337174836802e-17},
+  {-2.36909747078357713e-01, -1.96824029783981637e-18},
+  {-2.27057450635346075e-01, -9.55141576273848843e-18},
+  {-2.17301275689981394e-01, -1.61684524537630154e-18},
+  {-2.07639364778244490e-01, -1.20532432166861289e-17},
+  {-1.98069913762093791e-01, -3.74284348246143901e-18},
+  {-1.88591169807550030e-01,  7.43216421919692505e-18},
+  {-1.79201429457711003e-01,  1.07850174548584230e-17},
+  {-1.69899036795397473e-01,  4.86800876443907079e-19},
+  {-1.60682381690473469e-01,  3.65018355304783712e-18},
+  {-1.51549898127200933e-01, -5.16695936846155944e-18},
+  {-1.42500062607283040e-01,  9.92638823422574914e-18},
+  {-1.33531392624522627e-01,  3.66445766366008474e-18},
+  {-1.24642445207276603e-01,  5.80891267894097071e-18},
+  {-1.15831815525121701e-01, -4.33848436980809596e-18},
+  {-1.07098135556367102e-01,  1.73705104015906001e-18},
+  {-9.84400728132525243e-02,  4.43900963367513588e-18},
+  {-8.98563291218610477e-02,  6.27376016368959402e-19},
+  {-8.13456394539524008e-02, -5.07707635593116993e-18},
+  {-7.29067708080877869e-02,  6.30686025753277778e-18},
+  {-6.45385211375711781e-02,  6.47048666169293300e-18},
+  {-5.62397183228760811e-02,  3.28351498056056129e-18},
+  {-4.80092191863606063e-02, -1.43909033472922047e-18},
+  {-3.98459085471996738e-02,  3.12954768031520809e-18},
+  {-3.17486983145802981e-02, -3.03822630846808579e-18},
+  {-2.37165266173160437e-02,  1.57742434886682145e-18},
+  {-1.57483569681391676e-02, -1.00215786305289737e-18},
+  {-7.84317746102589260e-03, -2.76470815412490379e-19},
+  { 0.00000000000000000e+00,  0.00000000000000000e+00},
+  { 7.78214044205494896e-03, -1.28191791233438450e-20},
+  { 1.55041865359652545e-02, -3.27832102289242913e-19},
+  { 2.31670592815343794e-02, -1.17695449320633050e-18},
+  { 3.07716586667536873e-02,  1.04317320290059678e-18},
+  { 3.83188643021366016e-02, -2.35799615735128612e-18},
+  { 4.58095360312942013e-02,  1.90295986647425706e-18},
+  { 5.32445145188122845e-02, -1.66557581697366292e-18},
+  { 6.06246218164348399e-02,  2.64240259387269342e-18},
+  { 6.79506619085077507e-02, -1.28021412406117326e-18},
+  { 7.52234212375875316e-02, -5.93060419629324072e-18},
+  { 8.24436692110745856e-02,  5.70043777381398719e-18},
+  { 8.96121586896871380e-02, -5.42681293366471353e-18},
+  { 9.67296264585511129e-02, -5.59739748628996477e-19},
+  { 1.03796793681643559e-01,  5.47772415726659013e-18},
+  { 1.10814366340290113e-01,  1.18374834282564891e-18},
+  { 1.17783035656383456e-01, -1.19716857475936773e-18},
+  { 1.24703478500957241e-01, -4.65226096364966240e-18},
+  { 1.31576357788719261e-01,  1.11230008797295880e-17},
+  { 1.38402322859119131e-01,  4.44777730135752685e-18},
+  { 1.45182009844497889e-01,  8.24241878302247539e-18},
+  { 1.51916042025841969e-01,  6.48386312440221939e-18},
+  { 1.58605030176638573e-01,  1.12570038721825922e-17},
+  { 1.65249572895307173e-01, -1.00949356223226275e-17},
+  { 1.71850256926659228e-01, -6.02245382101137048e-18},
+  { 1.78407657472818310e-01, -1.24325537887011311e-17},
+  { 1.84922338494011990e-01,  3.02366141535740643e-18},
+  { 1.91394852999629467e-01, -1.21294969057928841e-17},
+  { 1.97825743329919868e-01,  1.28211943729801419e-17},
+  { 2.04215541428690889e-01,  2.73382810187227727e-18},
+  { 2.10564769107349642e-01, -4.24940531472989533e-18},
+  { 2.16873938300614355e-01,  4.55102619323428319e-18},
+  { 2.23143551314209765e-01, -9.09127059732479905e-18},
+  { 2.29374101064845820e-01,  9.92767182397802549e-18},
+  { 2.35566071312766911e-01, -2.39433714951873546e-18},
+  { 2.41719936887145159e-01,  8.90099002216664258e-18},
+  { 2.47836163904581269e-01, -1.24322095787025232e-17},
+  { 2.53915209980963452e-01, -8.04809739442420131e-18},
+  { 2.59957524436926046e-01,  2.06980693897893503e-17},
+  { 2.65963548497137936e-01,  5.33938027613143145e-18},
+  { 2.71933715483641758e-01,  7.83319637697442012e-19},
+  { 2.77868451003456307e-01, -9.16018294909263084e-19},
+  { 2.83768173130644619e-01, -2.03266558112665612e-17},
+  { 2.89633292583042656e-01,  2.05359532198581741e-17},
+  { 2.95464212893835898e-01, -2.16461086040598997e-17},
+  { 3.01261330578161790e-01, -9.04851114404856361e-18},
+  { 3.07025035294911874e-01, -1.23199162001019643e-17},
+  { 3.12755710003896903e-01, -1.45180835309895110e-17},
+  { 3.18453731118534589e-01,  2.71147793673262360e-17},
+  { 3.24119468654211984e-01, -7.95821438189381257e-18},
+  { 3.29753286372467980e-01,  2.12202061619694602e-18},
+  { 3.35355541921137812e-01,  1.83456443705947297e-17},
+  { 3.40926586970593193e-01,  1.74671364435447471e-17},
+  { 3.46466767346208571e-01,  1.02858358549626507e-17}
+};
 
-  return ldexp(s, static_cast<int>(m));
-}
+static constexpr dd_real _2_3 = dd_real(6.66666666666666630e-01,
+                                        3.70074341541718826e-17);
+static constexpr dd_real _2_5 = dd_real(4.00000000000000022e-01,
+                                        -2.22044604925031320e-17);
 
 /* Logarithm.  Computes log(x) in double-double precision.
    This is a natural logarithm (i.e., base e).            */
 dd_real log(const dd_real &a) {
-  /* Strategy.  The Taylor series for log converges much more
-     slowly than that of exp, due to the lack of the factorial
-     term in the denominator.  Hence this routine instead tries
-     to determine the root of the function
-
-         f(x) = exp(x) - a
+  /* Strategy.  Write a = 2^e * f with sqrt(1/2) <= f < sqrt(2), and
+     let c = j/128 be the table point nearest to f.  Then
 
-     using Newton iteration.  The iteration is given by
+         log(a) = e log(2) + log(c) + 2 atanh(u),
 
-         x' = x - f(x)/f'(x) 
-            = x - (1 - a * exp(-x))
-            = x + a * exp(-x) - 1.
-           
-     Only one iteration is needed, since Newton's iteration
-     approximately doubles the number of digits per iteration. */
+     where u = (f - c) / (f + c) satisfies |u| < 2^-8.  The atanh
+     series is truncated after u^13; its terms beyond u^5 are summed
+     in double precision.  No Newton iteration on exp is needed.    */
 
   if (a.is_one()) {
     return 0.0;
@@ -271,178 +630,302 @@ dd_real log(const dd_real &a) {
     return dd_real::_nan;
   }
 
-  dd_real x = std::log(a.x[0]);   /* Initial approximation */
+  if (a.isnan() || a.isinf()) {
+    dd_real::error("(dd_real::log): Non-finite argument.");
+    return dd_real::_nan;
+  }
 
-  x = x + a * exp(-x) - 1.0;
-  return x;
+  int e = std::ilogb(a.x[0]);
+  dd_real f = ldexp(a, -e);
+  if (f.x[0] >= 1.4142135623730951) {
+    f = mul_pwr2(f, 0.5);
+    e++;
+  }
+
+  int j = static_cast<int>(f.x[0] * 128.0 + 0.5);
+  double c = j / 128.0;
+  dd_real u = (f - c) / (f + c);
+  dd_real v = sqr(u);
+
+  double vh = v.x[0];
+  double t = vh * (2.85714285714285698e-01 + vh * (2.22222222222222210e-01 +
+             vh * (1.81818181818181823e-01 + vh * 1.53846153846153855e-01)));
+  dd_real s = _2_5 + t;
+  s = _2_3 + v * s;
+  s = mul_pwr2(u, 2.0) + u * (v * s);
+
+  return (dd_real::_log2 * static_cast<double>(e) +
+          dd_real(log_table[j - 91][0], log_table[j - 91][1])) + s;
+}
+
+/* Logarithm to about `bits' bits. */
+dd_real log(const dd_real &a, int bits) {
+  if (bits > max_double_bits || a.x[0] <= 0.0)
+    return log(a);
+
+  return std::log(a.x[0]) + a.x[1] / a.x[0];
 }
 
 dd_real log10(const dd_real &a) {
   return log(a) / dd_real::_log10;
 }
 
-static const dd_real _pi16 = dd_real(1.963495408493620697e-01,
-                                     7.654042494670957545e-18);
-
-/* Table of sin(k * pi/16) and cos(k * pi/16). */
-static const double sin_table [4][2] = {
-  {1.950903220161282758e-01, -7.991079068461731263e-18},
-  {3.826834323650897818e-01, -1.005077269646158761e-17},
-  {5.555702330196021776e-01,  4.709410940561676821e-17},
-  {7.071067811865475727e-01, -4.833646656726456726e-17}
+static constexpr dd_real _pi256 = dd_real(1.22718463030851294e-02,
+                                          4.78377655916934847e-19);
+
+/* Table of sin(k * pi/256) and cos(k * pi/256), k = 1, ..., 64. */
+static constexpr double sin_table[64][2] = {
+  { 1.22715382857199254e-02,  6.91979076402831699e-19},
+  { 2.45412285229122881e-02, -9.18684901257787818e-20},
+  { 3.68072229413588317e-02,  6.10600888035298419e-19},
+  { 4.90676743274180149e-02, -6.79610372051828011e-19},
+  { 6.13207363022085783e-02, -5.11811340646381077e-19},
+  { 7.35645635996674263e-02, -2.77849415062735933e-18},
+  { 8.57973123444398938e-02, -3.38818938306840289e-18},
+  { 9.80171403295606036e-02, -1.63458236224425599e-18},
+  { 1.10222207293883059e-01, -5.67895035378232325e-19},
+  { 1.22410675199216196e-01,  2.83545014899653353e-18},
+  { 1.34580708507126195e-01, -9.16703591714806995e-18},
+  { 1.46730474455361748e-01,  3.72694714704656775e-18},
+  { 1.58858143333861446e-01, -4.01632005738590786e-18},
+  { 1.70961888760301217e-01,  9.19199801817590944e-18},
+  { 1.83039887955140951e-01,  7.73499186886373835e-18},
+  { 1.95090322016128276e-01, -7.99107906846173126e-18},
+  { 2.07111376192218560e-01, -1.06133625289713558e-17},
+  { 2.19101240156869798e-01, -3.65138122991507758e-19},
+  { 2.31058108280671110e-01,  1.01297871497618686e-17},
+  { 2.42980179903263899e-01, -8.75143152971966316e-18},
+  { 2.54865659604514572e-01, -1.36022998069014613e-19},
+  { 2.66712757474898365e-01,  2.09412225788266884e-17},
+  { 2.78519689385053115e-01, -1.00302737195435440e-17},
+  { 2.90284677254462387e-01, -1.89279787077742515e-17},
+  { 3.02005949319228084e-01, -1.71676662352624742e-17},
+  { 3.13681740398891462e-01,  1.45604472999689122e-17},
+  { 3.25310292162262926e-01,  7.91712494637658925e-18},
+  { 3.36889853392220051e-01, -4.20009400334750924e-19},
+  { 3.48418680249434565e-01,  3.69744205142049177e-18},
+  { 3.59895036534988166e-01, -1.76016871238392825e-17},
+  { 3.71317193951837543e-01,  3.47492396482382656e-19},
+  { 3.82683432365089782e-01, -1.00507726964615876e-17},
+  { 3.93992040061048099e-01,  9.76492416412393360e-18},
+  { 4.05241314004989861e-01,  9.91114019428998842e-18},
+  { 4.16429560097637208e-01, -2.54755804131317323e-17},
+  { 4.27555093430282085e-01,  9.41118981629547262e-18},
+  { 4.38616238538527659e-01, -2.08833158310750902e-17},
+  { 4.49611329654606595e-01,  4.88319242320352435e-18},
+  { 4.60538710958240005e-01,  1.84887774921778717e-17},
+  { 4.71396736825997642e-01,  6.51667813606901296e-18},
+  { 4.82183772079122774e-01, -2.58615009255204420e-17},
+  { 4.92898192229784038e-01, -1.02578316765621855e-18},
+  { 5.03538383725717575e-01, -1.67313082049674969e-17},
+  { 5.14102744193221772e-01, -4.57127075236156240e-17},
+  { 5.24589682678468949e-01, -4.30688690400823448e-17},
+  { 5.34997619887097264e-01, -5.36831327083581340e-17},
+  { 5.45324988422046464e-01, -4.15178175383842578e-17},
+  { 5.55570233019602178e-01,  4.70941094056167682e-17},
+  { 5.65731810783613231e-01, -3.40960795965904665e-17},
+  { 5.75808191417845339e-01, -3.79094954589427341e-17},
+  { 5.85797857456438864e-01, -3.74855019643112936e-18},
+  { 5.95699304492433357e-01, -1.34386419365794672e-17},
+  { 6.05511041404325545e-01, -3.12026724933056770e-17},
+  { 6.15231590580626819e-01,  2.62314177672669503e-17},
+  { 6.24859488142386343e-01,  3.36718460372439003e-17},
+  { 6.34393284163645488e-01,  1.04209019292800346e-17},
+  { 6.43831542889791497e-01, -3.20847987950468858e-17},
+  { 6.53172842953776756e-01,  8.56956420600262380e-18},
+  { 6.62415777590171784e-01, -2.26155088857645914e-17},
+  { 6.71558954847018441e-01, -4.04890377492966925e-17},
+  { 6.80600997795453022e-01,  2.84732933545220469e-17},
+  { 6.89540544737066941e-01, -1.58893232948067899e-17},
+  { 6.98376249408972805e-01,  4.89882824356677676e-17},
+  { 7.07106781186547573e-01, -4.83364665672645673e-17}
 };
 
-static const double cos_table [4][2] = {
-  {9.807852804032304306e-01, 1.854693999782500573e-17},
-  {9.238795325112867385e-01, 1.764504708433667706e-17},
-  {8.314696123025452357e-01, 1.407385698472802389e-18},
-  {7.071067811865475727e-01, -4.833646656726456726e-17}
+static constexpr double cos_table[64][2] = {
+  { 9.99924701839144503e-01,  3.79310825126680122e-17},
+  { 9.99698818696204250e-01, -2.98514864037997529e-17},
+  { 9.99322384588349544e-01, -4.28585384408456820e-17},
+  { 9.98795456205172405e-01, -1.22916933370754648e-17},
+  { 9.98118112900149179e-01,  2.79354875581138326e-17},
+  { 9.97290456678690207e-01,  9.16476953711017346e-18},
+  { 9.96312612182778001e-01,  1.13364978916247349e-17},
+  { 9.95184726672196929e-01, -4.24869136783044096e-17},
+  { 9.93906970002356061e-01, -1.89648494711237457e-17},
+  { 9.92479534598709967e-01,  3.10930550954289061e-17},
+  { 9.90902635427780010e-01,  1.53945650945667038e-17},
+  { 9.89176509964781014e-01, -4.09873099370471114e-17},
+  { 9.87301418157858435e-01, -5.23322612557156525e-17},
+  { 9.85277642388941222e-01,  2.31556370279002067e-17},
+  { 9.83105487431216285e-01,  4.21700075228886281e-17},
+  { 9.80785280403230431e-01,  1.85469399978250057e-17},
+  { 9.78317370719627655e-01, -2.16230822333448952e-17},
+  { 9.75702130038528570e-01, -2.55725560812596856e-17},
+  { 9.72939952205560177e-01, -3.13112111222817999e-17},
+  { 9.70031253194543974e-01,  1.83653003484288444e-17},
+  { 9.66976471044852071e-01,  3.84962288373378642e-17},
+  { 9.63776065795439840e-01,  2.64639505612200288e-17},
+  { 9.60430519415565787e-01,  2.46539048153171851e-17},
+  { 9.56940335732208824e-01,  4.05538698618757006e-17},
+  { 9.53306040354193862e-01, -2.51907387799199336e-17},
+  { 9.49528180593036675e-01, -7.55441519280432984e-18},
+  { 9.45607325380521280e-01,  4.60191024785237379e-17},
+  { 9.41544065183020806e-01, -2.78963795476983411e-17},
+  { 9.37339011912574960e-01, -3.65709262843627764e-17},
+  { 9.32992798834738846e-01,  4.20414155553843554e-17},
+  { 9.28506080473215589e-01, -2.33066398484859428e-17},
+  { 9.23879532511286738e-01,  1.76450470843366771e-17},
+  { 9.19113851690057770e-01, -2.64964846223447180e-17},
+  { 9.14209755703530691e-01, -3.63161825278144230e-17},
+  { 9.09167983090522380e-01, -3.68785640913598945e-18},
+  { 9.03989293123443338e-01, -6.60975446874843085e-18},
+  { 8.98674465693953817e-01,  2.63169064610330135e-17},
+  { 8.93224301195515324e-01, -4.11612391519089127e-18},
+  { 8.87639620402853935e-01,  1.28050919185879605e-17},
+  { 8.81921264348355050e-01, -1.98432484058905621e-17},
+  { 8.76070094195406601e-01,  5.87290242351476768e-18},
+  { 8.70086991108711461e-01, -4.18885108685499682e-17},
+  { 8.63972856121586696e-01,  4.14863559573616071e-17},
+  { 8.57728610000272118e-01, -4.81834479363366201e-17},
+  { 8.51355193105265196e-01, -5.32798744460162087e-17},
+  { 8.44853565249707117e-01, -4.36313602968796371e-17},
+  { 8.38224705554838079e-01, -3.55600850528550261e-17},
+  { 8.31469612302545236e-01,  1.40738569847280239e-18},
+  { 8.24589302785025291e-01, -2.65123604888682752e-17},
+  { 8.17584813151583711e-01, -1.48831498124267717e-17},
+  { 8.10457198252594768e-01,  2.35203673498404990e-17},
+  { 8.03207531480644943e-01, -3.30606098048149096e-17},
+  { 7.95836904608883566e-01, -3.00627248519107210e-17},
+  { 7.88346427626606228e-01,  3.43969931540597076e-17},
+  { 7.80737228572094488e-01, -9.91987820666788060e-18},
+  { 7.73010453362736993e-01, -3.25659070336497723e-17},
+  { 7.65167265622458959e-01, -3.27072256125345983e-17},
+  { 7.57208846506484567e-01, -1.99090987773355019e-17},
+  { 7.49136394523459370e-01, -4.47290784470118887e-17},
+  { 7.40951125354959106e-01, -1.47086169522973452e-17},
+  { 7.32654271672412816e-01,  1.89186734815735196e-17},
+  { 7.24247082951466892e-01,  2.91984713344030044e-17},
+  { 7.15730825283818706e-01, -5.15810184764102619e-17},
+  { 7.07106781186547573e-01, -4.83364665672645673e-17}
 };
 
-/* Computes sin(a) using Taylor series.
-   Assumes |a| <= pi/32.                           */
+/* Computes sin(a) and cos(a) as fixed-degree polynomials.
+   Assumes |a| <= pi/512.  Terms beyond a^5 (sin) and a^4 (cos)
+   are below 2^-53 relative to the result and are summed in
+   double precision.                                           */
 static dd_real sin_taylor(const dd_real &a) {
-  const double thresh = 0.5 * std::abs(to_double(a)) * dd_real::_eps;
-  dd_real r, s, t, x;
-
-  if (a.is_zero()) {
-    return 0.0;
-  }
-
-  int i = 0;
-  x = -sqr(a);
-  s = a;
-  r = a;
-  do {
-    r *= x;
-    t = r * dd_real(inv_fact[i][0], inv_fact[i][1]);
-    s += t;
-    i += 2;
-  } while (i < n_inv_fact && std::abs(to_double(t)) > thresh);
-
-  return s;
+  dd_real x = sqr(a);
+  double xh = x.x[0];
+  double t = xh * (-inv_fact[4][0] + xh * (inv_fact[6][0] -
+             xh * inv_fact[8][0]));
+  dd_real p = dd_real(inv_fact[2][0], inv_fact[2][1]) + t;
+  p = x * p - dd_real(inv_fact[0][0], inv_fact[0][1]);
+  return a + a * (x * p);
 }
 
 static dd_real cos_taylor(const dd_real &a) {
-  const double thresh = 0.5 * dd_real::_eps;
-  dd_real r, s, t, x;
+  dd_real x = sqr(a);
+  double xh = x.x[0];
+  double t = xh * (-inv_fact[3][0] + xh * (inv_fact[5][0] -
+             xh * inv_fact[7][0]));
+  dd_real p = dd_real(inv_fact[1][0], inv_fact[1][1]) + t;
+  p = x * p - 0.5;
+  return 1.0 + x * p;
+}
 
-  if (a.is_zero()) {
-    return 1.0;
+/* Writes a = q * pi/2 + t with |t| <= pi/4 and computes sin(t) and
+   cos(t) from t = k * pi/256 + s, |s| <= pi/512, using the tables.
+   The quadrant j = q mod 4 is returned in [-1, 2].  Returns false
+   if the argument could not be reduced.                           */
+static bool sincos_reduce(const dd_real &a, int &j,
+                          dd_real &sin_t, dd_real &cos_t) {
+  if (a.isnan() || a.isinf())
+    return false;
+
+  // approximately reduce modulo 2*pi, where a multiple of pi/2 taken
+  // in double would be too coarse.
+  dd_real r = a;
+  if (std::fabs(a.x[0]) > 1024.0) {
+    dd_real z = nint(a / dd_real::_2pi);
+    r = a - dd_real::_2pi * z;
   }
 
-  x = -sqr(a);
-  r = x;
-  s = 1.0 + mul_pwr2(r, 0.5);
-  int i = 1;
-  do {
-    r *= x;
-    t = r * dd_real(inv_fact[i][0], inv_fact[i][1]);
-    s += t;
-    i += 2;
-  } while (i < n_inv_fact && std::abs(to_double(t)) > thresh);
+  // approximately reduce modulo pi/2, keeping the quadrant j
+  // modulo 4 in [-1, 2], and then modulo pi/256.
+  double q = std::floor(r.x[0] / dd_real::_pi2.x[0] + 0.5);
+  dd_real t = r - dd_real::_pi2 * q;
+  j = static_cast<int>(std::fmod(q, 4.0));
+  if (j > 2)
+    j -= 4;
+  else if (j < -1)
+    j += 4;
+  q = std::floor(t.x[0] / _pi256.x[0] + 0.5);
+  t -= _pi256 * q;
+  if (std::fabs(q) > 64.0)
+    return false;
 
-  return s;
-}
+  int k = static_cast<int>(q);
+  int abs_k = std::abs(k);
 
-static void sincos_taylor(const dd_real &a, 
-                          dd_real &sin_a, dd_real &cos_a) {
-  if (a.is_zero()) {
-    sin_a = 0.0;
-    cos_a = 1.0;
-    return;
+  dd_real s = sin_taylor(t);
+  dd_real c = cos_taylor(t);
+  if (k == 0) {
+    sin_t = s;
+    cos_t = c;
+    return true;
   }
 
-  sin_a = sin_taylor(a);
-  cos_a = sqrt(1.0 - sqr(sin_a));
+  dd_real u(cos_table[abs_k-1][0], cos_table[abs_k-1][1]);
+  dd_real v(sin_table[abs_k-1][0], sin_table[abs_k-1][1]);
+  if (k > 0) {
+    sin_t = u * s + v * c;
+    cos_t = u * c - v * s;
+  } else {
+    sin_t = u * s - v * c;
+    cos_t = u * c + v * s;
+  }
+  return true;
 }
 
-
-dd_real sin(const dd_real &a) {  
+dd_real sin(const dd_real &a) {
 
   /* Strategy.  To compute sin(x), we choose integers a, b so that
 
-       x = s + a * (pi/2) + b * (pi/16)
+       x = s + a * (pi/2) + b * (pi/256)
 
-     and |s| <= pi/32.  Using the fact that 
-
-       sin(pi/16) = 0.5 * sqrt(2 - sqrt(2 + sqrt(2)))
-
-     we can compute sin(x) from sin(s), cos(s).  This greatly 
-     increases the convergence of the sine Taylor series. */
+     and |s| <= pi/512.  Using a precomputed table of sin(k pi/256)
+     and cos(k pi/256), we can compute sin(x) from sin(s) and cos(s),
+     which are short fixed-degree polynomials.                     */
 
   if (a.is_zero()) {
     return 0.0;
   }
 
-  // approximately reduce modulo 2*pi
-  dd_real z = nint(a / dd_real::_2pi);
-  dd_real r = a - dd_real::_2pi * z;
-
-  // approximately reduce modulo pi/2 and then modulo pi/16.
-  dd_real t;
-  double q = std::floor(r.x[0] / dd_real::_pi2.x[0] + 0.5);
-  t = r - dd_real::_pi2 * q;
-  int j = static_cast<int>(q);
-  q = std::floor(t.x[0] / _pi16.x[0] + 0.5);
-  t -= _pi16 * q;
-  int k = static_cast<int>(q);
-  int abs_k = std::abs(k);
-
-  if (j < -2 || j > 2) {
-    dd_real::error("(dd_real::sin): Cannot reduce modulo pi/2.");
+  int j;
+  dd_real s, c;
+  if (!sincos_reduce(a, j, s, c)) {
+    dd_real::error("(dd_real::sin): Cannot reduce modulo pi/256.");
     return dd_real::_nan;
   }
 
-  if (abs_k > 4) {
-    dd_real::error("(dd_real::sin): Cannot reduce modulo pi/16.");
-    return dd_real::_nan;
+  switch (j) {
+    case 0:
+      return s;
+    case 1:
+      return c;
+    case -1:
+      return -c;
+    default:
+      return -s;
   }
+}
 
-  if (k == 0) {
-    switch (j) {
-      case 0:
-        return sin_taylor(t);
-      case 1:
-        return cos_taylor(t);
-      case -1:
-        return -cos_taylor(t);
-      default:
-        return -sin_taylor(t);
-    }
-  }
+/* Sine to about `bits' bits. */
+dd_real sin(const dd_real &a, int bits) {
+  if (bits > max_double_bits)
+    return sin(a);
 
-  dd_real u(cos_table[abs_k-1][0], cos_table[abs_k-1][1]);
-  dd_real v(sin_table[abs_k-1][0], sin_table[abs_k-1][1]);
-  dd_real sin_t, cos_t;
-  sincos_taylor(t, sin_t, cos_t);
-  if (j == 0) {
-    if (k > 0) {
-      r = u * sin_t + v * cos_t;
-    } else {
-      r = u * sin_t - v * cos_t;
-    }
-  } else if (j == 1) {
-    if (k > 0) {
-      r = u * cos_t - v * sin_t;
-    } else {
-      r = u * cos_t + v * sin_t;
-    }
-  } else if (j == -1) {
-    if (k > 0) {
-      r = v * sin_t - u * cos_t;
-    } else if (k < 0) {
-      r = -u * cos_t - v * sin_t;
-    }
-  } else {
-    if (k > 0) {
-      r = -u * sin_t - v * cos_t;
-    } else {
-      r = v * cos_t - u * sin_t;
-    }
-  }
-
-  return r;
+  dd_real z = nint(a / dd_real::_2pi);
+  return std::sin(to_double(a - dd_real::_2pi * z));
 }
 
 dd_real cos(const dd_real &a) {
@@ -451,75 +934,32 @@ dd_real cos(const dd_real &a) {
     return 1.0;
   }
 
-  // approximately reduce modulo 2*pi
-  dd_real z = nint(a / dd_real::_2pi);
-  dd_real r = a - z * dd_real::_2pi;
-
-  // approximately reduce modulo pi/2 and then modulo pi/16
-  dd_real t;
-  double q = std::floor(r.x[0] / dd_real::_pi2.x[0] + 0.5);
-  t = r - dd_real::_pi2 * q;
-  int j = static_cast<int>(q);
-  q = std::floor(t.x[0] / _pi16.x[0] + 0.5);
-  t -= _pi16 * q;
-  int k = static_cast<int>(q);
-  int abs_k = std::abs(k);
-
-  if (j < -2 || j > 2) {
-    dd_real::error("(dd_real::cos): Cannot reduce modulo pi/2.");
-    return dd_real::_nan;
-  }
-
-  if (abs_k > 4) {
-    dd_real::error("(dd_real::cos): Cannot reduce modulo pi/16.");
+  int j;
+  dd_real s, c;
+  if (!sincos_reduce(a, j, s, c)) {
+    dd_real::error("(dd_real::cos): Cannot reduce modulo pi/256.");
     return dd_real::_nan;
   }
 
-  if (k == 0) {
-    switch (j) {
-      case 0:
-        return cos_taylor(t);
-      case 1:
-        return -sin_taylor(t);
-      case -1:
-        return sin_taylor(t);
-      default:
-        return -cos_taylor(t);
-    }
+  switch (j) {
+    case 0:
+      return c;
+    case 1:
+      return -s;
+    case -1:
+      return s;
+    default:
+      return -c;
   }
+}
 
-  dd_real sin_t, cos_t;
-  sincos_taylor(t, sin_t, cos_t);
-  dd_real u(cos_table[abs_k-1][0], cos_table[abs_k-1][1]);
-  dd_real v(sin_table[abs_k-1][0], sin_table[abs_k-1][1]);
+/* Cosine to about `bits' bits. */
+dd_real cos(const dd_real &a, int bits) {
+  if (bits > max_double_bits)
+    return cos(a);
 
-  if (j == 0) {
-    if (k > 0) {
-      r = u * cos_t - v * sin_t;
-    } else {
-      r = u * cos_t + v * sin_t;
-    }
-  } else if (j == 1) {
-    if (k > 0) {
-      r = - u * sin_t - v * cos_t;
-    } else {
-      r = v * cos_t - u * sin_t;
-    }
-  } else if (j == -1) {
-    if (k > 0) {
-      r = u * sin_t + v * cos_t;
-    } else {
-      r = u * sin_t - v * cos_t;
-    }
-  } else {
-    if (k > 0) {
-      r = v * sin_t - u * cos_t;
-    } else {
-      r = - u * cos_t - v * sin_t;
-    }
-  }
-
-  return r;
+  dd_real z = nint(a / dd_real::_2pi);
+  return std::cos(to_double(a - dd_real::_2pi * z));
 }
 
 void sincos(const dd_real &a, dd_real &sin_a, dd_real &cos_a) {
@@ -530,55 +970,15 @@ void sincos(const dd_real &a, dd_real &sin_a, dd_real &cos_a) {
     return;
   }
 
-  // approximately reduce modulo 2*pi
-  dd_real z = nint(a / dd_real::_2pi);
-  dd_real r = a - dd_real::_2pi * z;
-
-  // approximately reduce module pi/2 and pi/16
-  dd_real t;
-  double q = std::floor(r.x[0] / dd_real::_pi2.x[0] + 0.5);
-  t = r - dd_real::_pi2 * q;
-  int j = static_cast<int>(q);
-  int abs_j = std::abs(j);
-  q = std::floor(t.x[0] / _pi16.x[0] + 0.5);
-  t -= _pi16 * q;
-  int k = static_cast<int>(q);
-  int abs_k = std::abs(k);
-
-  if (abs_j > 2) {
-    dd_real::error("(dd_real::sincos): Cannot reduce modulo pi/2.");
-    cos_a = sin_a = dd_real::_nan;
-    return;
-  }
-
-  if (abs_k > 4) {
-    dd_real::error("(dd_real::sincos): Cannot reduce modulo pi/16.");
+  int j;
+  dd_real s, c;
+  if (!sincos_reduce(a, j, s, c)) {
+    dd_real::error("(dd_real::sincos): Cannot reduce modulo pi/256.");
     cos_a = sin_a = dd_real::_nan;
     return;
   }
 
-  dd_real sin_t, cos_t;
-  dd_real s, c;
-
-  sincos_taylor(t, sin_t, cos_t);
-
-  if (abs_k == 0) {
-    s = sin_t;
-    c = cos_t;
-  } else {
-    dd_real u(cos_table[abs_k-1][0], cos_table[abs_k-1][1]);
-    dd_real v(sin_table[abs_k-1][0], sin_table[abs_k-1][1]);
-
-    if (k > 0) {
-      s = u * sin_t + v * cos_t;
-      c = u * cos_t - v * sin_t;
-    } else {
-      s = u * sin_t - v * cos_t;
-      c = u * cos_t + v * sin_t;
-    }
-  }
-
-  if (abs_j == 0) {
+  if (j == 0) {
     sin_a = s;
     cos_a = c;
   } else if (j == 1) {
@@ -591,7 +991,6 @@ void sincos(const dd_real &a, dd_real &sin_a, dd_real &cos_a) {
     sin_a = -s;
     cos_a = -c;
   }
-  
 }
 
 dd_real atan(const dd_real &a) {
@@ -784,6 +1183,306 @@ dd_real atanh(const dd_real &a) {
   return mul_pwr2(log((1.0 + a) / (1.0 - a)), 0.5);
 }
 
+/* Coefficients (-1)^n / (n! (2n+1)) of the Maclaurin series
+
+     erf(x) = 2/sqrt(pi) * x * sum c_n x^(2n),
+
+   used for |x| < 1/2.                                         */
+static constexpr int n_erf_coef = 22;
+static constexpr double erf_coef[n_erf_coef][2] = {
+  { 1.00000000000000000e+00,  0.00000000000000000e+00},
+  {-3.33333333333333315e-01, -1.85037170770859413e-17},
+  { 1.00000000000000006e-01, -5.55111512312578301e-18},
+  {-2.38095238095238082e-02, -1.32169407693471009e-18},
+  { 4.62962962962962937e-03,  2.56996070515082518e-19},
+  {-7.57575757575757575e-04, -6.57092225748790565e-22},
+  { 1.06837606837606838e-04,  9.26668523491884131e-23},
+  {-1.32275132275132281e-05,  5.53215592640586407e-22},
+  { 1.45891690009337058e-06,  1.00916343669139804e-22},
+  {-1.45038522231504685e-07, -2.75729942161182996e-24},
+  { 1.31225329638028058e-08, -7.58902608585477723e-25},
+  {-1.08922210371485731e-09, -2.69190200194198817e-26},
+  { 8.35070279514723971e-11, -1.21046505653354370e-27},
+  {-5.94779401363763541e-12,  3.71589825397953809e-28},
+  { 3.95542951645852569e-13,  7.12259060442439502e-30},
+  {-2.46682701026445706e-14,  1.29977179148148958e-30},
+  { 1.44832646435981379e-15, -6.43599210116630327e-32},
+  {-8.03273501241577328e-17, -3.30813202092288827e-33},
+  { 4.22140728880708822e-18,  9.59729713379292999e-36},
+  {-2.10785519144213592e-19,  9.13743697743918310e-36},
+  { 1.00251649349077191e-20,  1.08550314048073388e-37},
+  {-4.55184675892819988e-22, -4.04408070502801905e-38}
+};
+
+/* exp(x0^2) * erfc(x0) at the nodes x0 = j/8, j = 4, ..., 64. */
+static constexpr int n_erfc_node = 61;
+static constexpr double erfc_node[n_erfc_node][2] = {
+  { 6.15690344192925898e-01, -2.31217586862334096e-17},
+  { 5.56813880873362477e-01,  2.82156721466000847e-17},
+  { 5.06937650293144859e-01, -5.33568103546223196e-17},
+  { 4.64311583202669020e-01, -1.85196372775457397e-17},
+  { 4.27583576155806999e-01,  5.23573728331422823e-18},
+  { 3.95698079552995907e-01, -5.77767505608912928e-18},
+  { 3.67822916452361093e-01,  1.38740109392503499e-19},
+  { 3.43295889862125392e-01, -1.19240631467685412e-17},
+  { 3.21585416454317485e-01,  1.70079856077221961e-17},
+  { 3.02261209363485939e-01, -2.13002438459551376e-17},
+  { 2.84972234737436381e-01,  8.53981302397312200e-18},
+  { 2.69429985164670427e-01,  2.48345797241347183e-17},
+  { 2.55395676310505748e-01, -4.27602229016594589e-18},
+  { 2.42670364612654538e-01,  8.85948000786290353e-18},
+  { 2.31087258730391876e-01, -5.74762364596781998e-18},
+  { 2.20505692204906678e-01, -1.34612295999307570e-17},
+  { 2.10806364061143586e-01, -5.62772590931025244e-18},
+  { 2.01887554546017006e-01,  3.29035590885698445e-18},
+  { 1.93662096279068691e-01, -1.20158465327391744e-17},
+  { 1.86054934684471096e-01,  7.76667829835616033e-18},
+  { 1.79001151181389956e-01, -5.42721759202002739e-18},
+  { 1.72444352102173598e-01,  9.75382340157330846e-18},
+  { 1.66335348426821877e-01, -6.13341633950197469e-19},
+  { 1.60631068126544402e-01,  2.40807446851982769e-18},
+  { 1.55293655608894299e-01, -1.35584454221609201e-18},
+  { 1.50289722474269360e-01, -1.37156868645726726e-19},
+  { 1.45589721275038553e-01, -1.37156473444443336e-17},
+  { 1.41167419763051805e-01, -1.25341946913660225e-17},
+  { 1.36999457625061383e-01,  7.19656813915871921e-18},
+  { 1.33064971241208252e-01,  4.18468650022013014e-18},
+  { 1.29345274785987924e-01, -1.29175085131573191e-17},
+  { 1.25823588194988067e-01,  1.73114925873585896e-18},
+  { 1.22484804273841424e-01, -6.88869313574429388e-18},
+  { 1.19315288627133323e-01,  4.90838455546025954e-18},
+  { 1.16302707210247311e-01, -3.17747868799729143e-18},
+  { 1.13435877214740494e-01, -2.83995804299078001e-18},
+  { 1.10704637733068628e-01, -1.83234749363973903e-18},
+  { 1.08099737246547464e-01,  2.17250001322154007e-18},
+  { 1.05612735468891800e-01,  2.76342157914190464e-18},
+  { 1.03235917478156927e-01,  3.86500358327895498e-19},
+  { 1.00962218399499093e-01, -4.70285761294306910e-18},
+  { 9.87851571734075368e-02,  3.31281782901441755e-18},
+  { 9.66987781697139226e-02, -1.77565727335395650e-18},
+  { 9.46975995953630301e-02, -5.46901537616685465e-18},
+  { 9.27765678005383482e-02,  6.21536475552848508e-18},
+  { 9.09310167188368546e-02, -2.79375371921842866e-18},
+  { 8.91566317872743846e-02,  5.22490859618254179e-18},
+  { 8.74494177846224935e-02,  3.31494859386233149e-18},
+  { 8.58056701048946074e-02, -5.66382694077563253e-18},
+  { 8.42219490491401823e-02, -4.20652838121292571e-18},
+  { 8.26950567750530663e-02, -6.76238393022572251e-18},
+  { 8.12220165918880049e-02, -5.67597234333802957e-19},
+  { 7.98000543291529363e-02, -2.79340030987008415e-18},
+  { 7.84265815426160168e-02, -2.28542620599283172e-18},
+  { 7.70991803512598994e-02,  2.22849835187080467e-18},
+  { 7.58155897246976795e-02, -2.76458763501349139e-18},
+  { 7.45736930628766864e-02, -3.41639586145517204e-18},
+  { 7.33715069291729916e-02,  6.79671516351160000e-18},
+  { 7.22071708146697633e-02, -2.77319978304035369e-18},
+  { 7.10789378258943755e-02,  3.37850648098434271e-18},
+  { 6.99851662008809244e-02,  3.28634065964687457e-18}
+};
+
+/* B_2k / (2k (2k-1)), k = 1, ..., 18, coefficients of the Stirling
+   series for log Gamma.  These suffice for arguments >= 16.        */
+static constexpr int n_stirling_coef = 18;
+static constexpr double stirling_coef[n_stirling_coef][2] = {
+  { 8.33333333333333287e-02,  4.62592926927148533e-18},
+  {-2.77777777777777788e-03,  1.06010879087471541e-19},
+  { 7.93650793650793650e-04,  6.88382331736828211e-22},
+  {-5.95238095238095292e-04,  5.36938218754726024e-20},
+  { 8.41750841750841714e-04,  3.68701748892376936e-20},
+  {-1.91752691752691763e-03,  1.06757027768724749e-19},
+  { 6.41025641025641003e-03,  2.22400445638052172e-19},
+  {-2.95506535947712423e-02,  4.86176095750885531e-19},
+  { 1.79644372368830574e-01, -6.40160048271094580e-19},
+  {-1.39243221690590113e+00,  1.58370569892303027e-17},
+  { 1.34028640441683926e+01, -6.15411410199396641e-16},
+  {-1.56848284626002027e+02,  9.39182314171538895e-15},
+  { 2.19310333333333347e+03, -1.33392556260029476e-13},
+  {-3.61087712537249899e+04,  5.89758335351436479e-13},
+  { 6.91472268851313042e+05,  2.55852963051579989e-11},
+  {-1.52382215394074153e+07, -8.76774522490625042e-10},
+  { 3.82900751391414165e+08, -2.40826847577335854e-08},
+  {-1.08822660357843914e+10,  3.14183093021974915e-07}
+};
+
+/* 2 / sqrt(pi) and log(2 pi) / 2. */
+static constexpr dd_real _2_sqrtpi = dd_real(1.12837916709551256e+00, 1.53354596131658812e-17);
+static constexpr dd_real _half_log_2pi = dd_real(9.18938533204672781e-01, -3.87829415806724145e-17);
+
+/* erf(a) for |a| < 1/2. */
+static dd_real erf_series(const dd_real &a) {
+  dd_real x = sqr(a);
+  int n = n_erf_coef - 1;
+  dd_real s = dd_real(erf_coef[n][0], erf_coef[n][1]);
+  for (int i = n - 1; i >= 0; i--)
+    s = s * x + dd_real(erf_coef[i][0], erf_coef[i][1]);
+  return _2_sqrtpi * a * s;
+}
+
+/* erfc(a) for a >= 1/2.  Same strategy as the quad-double version:
+   the even part of Laplace's continued fraction for a >= 8, and
+   below that a Taylor expansion
+
+     erfc(x0 + h) = exp(-x0^2) * (erfcx(x0) - 2/sqrt(pi) * F(h))
+
+   about the first node x0 = j/8 at or above a (see qd_real.cpp). */
+static dd_real erfc_pos(const dd_real &a) {
+  if (a.x[0] > 26.6)
+    return 0.0;
+
+  if (a.x[0] >= 8.0) {
+    int n = 4 + static_cast<int>(90.0 / a.x[0]);
+    dd_real y = mul_pwr2(sqr(a), 2.0);
+    dd_real f = y + (4.0 * n + 1.0);
+    for (int k = n; k >= 1; k--)
+      f = (y + (4.0 * k - 3.0)) - ((2.0 * k - 1.0) * (2.0 * k)) / f;
+    return _2_sqrtpi * a * exp(-sqr(a)) / f;
+  }
+
+  const int max_terms = 48;
+  double x0 = std::ceil(a.x[0] * 8.0) / 8.0;
+  dd_real h = a - x0;
+  const double *e = erfc_node[static_cast<int>(x0 * 8.0) - 4];
+  dd_real e0(e[0], e[1]);
+
+  /* Generate f_1, f_2, ... until two consecutive terms are
+     negligible. */
+  dd_real f[max_terms];
+  double abs_h = std::abs(h.x[0]);
+  double thresh = 0.25 * dd_real::_eps * e0.x[0];
+  double p = abs_h * abs_h;
+  double t_prev = abs_h, t = std::abs(x0) * p;
+  int n = 1;
+  f[0] = 1.0;
+  f[1] = -x0;
+  while (n < max_terms - 1 && (t > thresh || t_prev > thresh)) {
+    f[n + 1] = -(f[n] * (2.0 * x0 * (n + 1)) + f[n - 1] * (2.0 * n)) /
+               ((n + 1.0) * (n + 2.0));
+    n++;
+    p *= abs_h;
+    t_prev = t;
+    t = std::abs(f[n].x[0]) * p;
+  }
+
+  dd_real s = h * polyeval(f, n, h);
+  return exp(dd_real(-x0 * x0)) * (e0 - _2_sqrtpi * s);
+}
+
+dd_real erf(const dd_real &a) {
+  if (a.isnan())
+    return a;
+
+  dd_real x = abs(a);
+  dd_real r = (x.x[0] < 0.5) ? erf_series(x) : 1.0 - erfc_pos(x);
+  return (a.x[0] < 0.0) ? -r : r;
+}
+
+dd_real erfc(const dd_real &a) {
+  if (a.isnan())
+    return a;
+
+  if (a.x[0] >= 0.5)
+    return erfc_pos(a);
+  if (a.x[0] <= -0.5)
+    return 2.0 - erfc_pos(-a);
+  return 1.0 - erf_series(a);
+}
+
+/* log Gamma(z) by the Stirling series, for z >= 16. */
+static dd_real lgamma_stirling(const dd_real &z) {
+  dd_real w = 1.0 / z;
+  dd_real w2 = sqr(w);
+  int n = n_stirling_coef - 1;
+  dd_real s = dd_real(stirling_coef[n][0], stirling_coef[n][1]);
+  for (int i = n - 1; i >= 0; i--)
+    s = s * w2 + dd_real(stirling_coef[i][0], stirling_coef[i][1]);
+  return (z - 0.5) * log(z) - z + _half_log_2pi + w * s;
+}
+
+/* Returns z = a + n >= 16 for the smallest such integer n >= 0,
+   and the product a (a+1) ... (a+n-1) in p.  Assumes a > 0.   */
+static dd_real gamma_shift(const dd_real &a, dd_real &p) {
+  dd_real z = a;
+  p = 1.0;
+  while (z.x[0] < 16.0) {
+    p *= z;
+    z += 1.0;
+  }
+  return z;
+}
+
+/* sin(pi * a), reducing a exactly modulo 2 first. */
+static dd_real sinpi(const dd_real &a) {
+  dd_real n = nint(a);
+  dd_real s = sin(dd_real::_pi * (a - n));
+  return (std::fmod(n.x[0], 2.0) != 0.0) ? -s : s;
+}
+
+/* (n-1)! for integers 1 <= n <= 28, which is exact in double-double. */
+static dd_real int_gamma(int n) {
+  dd_real f = 1.0;
+  for (int i = 2; i < n; i++)
+    f *= static_cast<double>(i);
+  return f;
+}
+
+dd_real lgamma(const dd_real &a) {
+  if (a.isnan())
+    return a;
+  if (a.isinf())
+    return dd_real::_inf;
+
+  bool is_int = (a == nint(a));
+  if (a.x[0] <= 0.0) {
+    if (is_int) {
+      dd_real::error("(dd_real::lgamma): Pole.");
+      return dd_real::_inf;
+    }
+    /* Reflection formula  Gamma(a) Gamma(1-a) = pi / sin(pi a). */
+    return log(dd_real::_pi / abs(sinpi(a))) - lgamma(1.0 - a);
+  }
+
+  if (is_int && a.x[0] <= 28.0)
+    return log(int_gamma(static_cast<int>(a.x[0])));
+  if (a.x[0] >= 16.0)
+    return lgamma_stirling(a);
+
+  dd_real p;
+  dd_real z = gamma_shift(a, p);
+  return lgamma_stirling(z) - log(p);
+}
+
+dd_real tgamma(const dd_real &a) {
+  if (a.isnan())
+    return a;
+  if (a.isinf())
+    return (a.x[0] > 0.0) ? a : dd_real::_nan;
+
+  bool is_int = (a == nint(a));
+  if (a.x[0] <= 0.0) {
+    if (is_int) {
+      dd_real::error("(dd_real::tgamma): Pole.");
+      return dd_real::_nan;
+    }
+    /* Reflection formula  Gamma(a) Gamma(1-a) = pi / sin(pi a). */
+    return dd_real::_pi / (sinpi(a) * tgamma(1.0 - a));
+  }
+
+  if (is_int && a.x[0] <= 28.0)
+    return int_gamma(static_cast<int>(a.x[0]));
+  if (a.x[0] >= 16.0) {
+    /* Gamma(a) fits in a double up to a = 171.62, where its log
+       reaches 709.78 and exp overflows; take out 2^64 first.    */
+    dd_real l = lgamma_stirling(a);
+    if (l.x[0] < 700.0)
+      return exp(l);
+    return ldexp(exp(l - dd_real::_log2 * 64.0), 64);
+  }
+
+  dd_real p;
+  dd_real z = gamma_shift(a, p);
+  return exp(lgamma_stirling(z)) / p;
+}
+
 QD_API dd_real fmod(const dd_real &a, const dd_real &b) {
   dd_real n = aint(a / b);
   return (a - b * n);
@@ -901,32 +1600,23 @@ istream &operator>>(istream &s, dd_real &a) {
   return s;
 }
 
-void dd_real::to_digits(char *s, int &expn, int precision) const {
-  int D = precision + 1;  /* number of digits to compute */
-
-  dd_real r = abs(*this);
+int decimal_digits(const dd_real &a, char *s, int &expn) {
+  dd_real r = abs(a);
   int e;  /* exponent */
-  int i, d;
-
-  if (x[0] == 0.0) {
-    /* this == 0.0 */
-    expn = 0;
-    for (i = 0; i < precision; i++) s[i] = '0';
-    return;
-  }
+  uint64_t b[2];
+  int i, k;
 
   /* First determine the (approximate) exponent. */
-  e = to_int(std::floor(std::log10(std::abs(x[0]))));
-
-  if (e < -300) {
-    r *= dd_real(10.0) ^ 300;
-    r /= dd_real(10.0) ^ (e + 300);
-  } else if (e > 300) {
-    r = ldexp(r, -53);
-    r /= dd_real(10.0) ^ e;
-    r = ldexp(r, 53);
+  e = to_int(std::floor(std::log10(std::abs(a.x[0]))));
+
+  /* Exact powers of ten keep the digits of integers and short
+     decimal fractions exact. */
+  if (e >= 0 && e <= 22) {
+    r /= exact_pwr10[e];
+  } else if (e < 0 && e >= -22) {
+    r *= exact_pwr10[-e];
   } else {
-    r /= dd_real(10.0) ^ e;
+    r = mul_pwr10(r, -e);
   }
 
   /* Fix exponent if we are off by one */
@@ -940,55 +1630,56 @@ void dd_real::to_digits(char *s, int &expn, int precision) const {
 
   if (r >= 10.0 || r < 1.0) {
     dd_real::error("(dd_real::to_digits): can't compute exponent.");
-    return;
+    return 0;
   }
 
-  /* Extract the digits */
-  for (i = 0; i < D; i++) {
-    d = static_cast<int>(r.x[0]);
-    r -= d;
-    r *= 10.0;
-
-    s[i] = static_cast<char>(d + '0');
+  /* Extract the digits 19 at a time. */
+  r *= 1e18;
+  for (i = 0; i < 2; i++) {
+    dd_real t = floor(r);
+    b[i] = static_cast<uint64_t>(t.x[0]) + 
+           static_cast<uint64_t>(static_cast<int64_t>(t.x[1]));
+    r = (r - t) * 1e19;
   }
 
-  /* Fix out of range digits. */
-  for (i = D-1; i > 0; i--) {
-    if (s[i] < '0') {
-      s[i-1]--;
-      s[i] += 10;
-    } else if (s[i] > '9') {
-      s[i-1]++;
-      s[i] -= 10;
-    }
+  const uint64_t ten19 = 10000000000000000000ULL;
+  if (b[1] >= ten19) {
+    b[1] -= ten19;
+    b[0]++;
   }
-
-  if (s[0] <= '0') {
-    dd_real::error("(dd_real::to_digits): non-positive leading digit.");
-    return;
+  if (b[0] >= ten19) {
+    b[0] = ten19 / 10;
+    b[1] = 0;
+    e++;
   }
 
-  /* Round, handle carry */
-  if (s[D-1] >= '5') {
-    s[D-2]++;
-
-    i = D-2;
-    while (i > 0 && s[i] > '9') {
-      s[i] -= 10;
-      s[--i]++;
+  for (i = 0; i < 2; i++) {
+    for (k = 18; k >= 0; k--) {
+      s[19*i + k] = static_cast<char>('0' + b[i] % 10);
+      b[i] /= 10;
     }
   }
 
-  /* If first digit is 10, shift everything. */
-  if (s[0] > '9') { 
-    e++; 
-    for (i = precision; i >= 2; i--) s[i] = s[i-1]; 
-    s[0] = '1';
-    s[1] = '0';
+  expn = e;
+  return 38;
+}
+
+void dd_real::to_digits(char *s, int &expn, int precision) const {
+  char t[max_decimal_digits];
+  int i, n;
+
+  if (x[0] == 0.0) {
+    /* this == 0.0 */
+    expn = 0;
+    for (i = 0; i < precision; i++) s[i] = '0';
+    return;
   }
 
+  n = decimal_digits(*this, t, expn);
+  n = round_digits(t, n, precision, expn);
+  for (i = 0; i < precision; i++)
+    s[i] = (i < n) ? t[i] : '0';
   s[precision] = 0;
-  expn = e;
 }
 
 /* Writes the double-double number into the character array s of length len.
@@ -1047,6 +1738,15 @@ string dd_real::to_string(int precision, int width, ios_base::fmtflags fmt,
   if (isnan()) {
     s = uppercase ? "NAN" : "nan";
     sgn = false;
+  } else if ((fmt & ios_base::floatfield) ==
+             (ios_base::fixed | ios_base::scientific) && !isinf()) {
+    /* std::hexfloat: exact hexadecimal limbs. */
+    char t[max_hex_chars];
+    char *p = write_hex(t, t + sizeof(t), x, 2, uppercase);
+    sgn = std::signbit(x[0]) || showpos;
+    if (showpos && !std::signbit(x[0]))
+      s += '+';
+    s.append(t, p - t);
   } else {
     if (*this < 0.0)
       s += '-';
@@ -1066,7 +1766,15 @@ string dd_real::to_string(int precision, int width, ios_base::fmtflags fmt,
       }
     } else {
       /* Non-zero case */
-      int off = (fixed ? (1 + to_int(floor(log10(abs(*this))))) : 1);
+      /* In fixed notation the digits start at the decimal exponent,
+         taken from the digits themselves: log10 of an exact power of
+         ten may round below the integer.                          */
+      int off = 1;
+      if (fixed) {
+        char digits[max_decimal_digits];
+        if (decimal_digits(*this, digits, off) > 0)
+          off++;
+      }
       int d = precision + off;
 
       int d_with_extra = d;
@@ -1192,73 +1900,91 @@ string dd_real::to_string(int precision, int width, ios_base::fmtflags fmt,
   return s;
 }
 
-/* Reads in a double-double number from the string s. */
-int dd_real::read(const char *s, dd_real &a) {
-  const char *p = s;
-  char ch;
-  int sign = 0;
-  int point = -1;
-  int nd = 0;
-  int e = 0;
-  bool done = false;
+/* Converts the digits gathered by scan_decimal to a double-double. */
+static dd_real from_chunks(const decimal_chunks &d) {
   dd_real r = 0.0;
-  int nread;
-  
-  /* Skip any leading spaces */
-  while (*p == ' ')
-    p++;
-
-  while (!done && (ch = *p) != '\0') {
-    if (ch >= '0' && ch <= '9') {
-      int d = ch - '0';
-      r *= 10.0;
-      r += static_cast<double>(d);
-      nd++;
-    } else {
 
-      switch (ch) {
-
-      case '.':
-        if (point >= 0)
-          return -1;        
-        point = nd;
-        break;
-
-      case '-':
-      case '+':
-        if (sign != 0 || nd > 0)
-          return -1;
-        sign = (ch == '-') ? -1 : 1;
-        break;
-
-      case 'E':
-      case 'e':
-        nread = std::sscanf(p+1, "%d", &e);
-        done = true;
-        if (nread != 1)
-          return -1;
-        break;
-
-      default:
-        return -1;
-      }
-    }
-    
-    p++;
+  for (int i = 0; i < d.nchunks; i++) {
+    uint64_t c = d.chunk[i];
+    r *= (i == d.nchunks - 1) ? d.last_scale : 1e19;
+    r += static_cast<double>(c >> 32) * 4294967296.0;
+    r += static_cast<double>(c & 0xffffffffu);
   }
 
-  if (point >= 0) {
-    e -= (nd - point);
-  }
+  /* Dividing by an exact power of ten keeps short decimal
+     fractions such as 0.1 correctly rounded. */
+  if (d.expn < 0 && d.expn >= -22)
+    r /= exact_pwr10[-d.expn];
+  else if (d.expn != 0)
+    r = mul_pwr10(r, d.expn);
+
+  return d.negative ? -r : r;
+}
 
-  if (e != 0) {
-    r *= (dd_real(10.0) ^ e);
+/* Scans a decimal or hexadecimal number from [p, end) into a.  The
+   limbs of a hexadecimal number with exactly 2 limbs are taken as
+   they are, so that written numbers read back bit for bit; other
+   counts are summed.  Returns a pointer past the number, or 0.    */
+static const char *scan_number(const char *p, const char *end, dd_real &a) {
+  double x[4];
+  int n;
+  const char *q = scan_hex(p, end, x, 4, n);
+  if (q != 0) {
+    if (n == 2) {
+      a = dd_real(x[0], x[1]);
+    } else {
+      a = x[0];
+      for (int i = 1; i < n; i++)
+        a += x[i];
+    }
+    return q;
   }
 
-  a = (sign == -1) ? -r : r;
+  decimal_chunks d;
+  q = scan_decimal(p, end, d, 2);
+  if (q != 0)
+    a = from_chunks(d);
+  return q;
+}
+
+/* Reads in a double-double number from the string s.  Two chunks
+   of 19 digits are more than double-double precision holds.       */
+int dd_real::read(const char *s, dd_real &a) {
+  dd_real r;
+  const char *p = scan_number(s, s + std::strlen(s), r);
+
+  /* Text after an exponent is ignored, as it was by QD 2.3. */
+  if (p == 0 || (*p != '\0' && !ends_with_exponent(s, p)))
+    return -1;
+
+  a = r;
   return 0;
 }
 
+#if QD_HAVE_CXX17
+/* Parses a double-double from the beginning of s, after any leading
+   spaces.  Returns a pointer past the last character used, or null
+   if s does not begin with a number, in which case a is unchanged. */
+const char *dd_real::parse(std::string_view s, dd_real &a) {
+  return scan_number(s.data(), s.data() + s.size(), a);
+}
+
+std::to_chars_result to_chars(char *first, char *last, const dd_real &a) {
+  return to_chars_decimal(first, last, a, 0, -1);
+}
+
+std::to_chars_result to_chars(char *first, char *last, const dd_real &a,
+                              std::chars_format fmt) {
+  return to_chars_decimal(first, last, a, static_cast<int>(fmt), -1);
+}
+
+std::to_chars_result to_chars(char *first, char *last, const dd_real &a,
+                              std::chars_format fmt, int precision) {
+  return to_chars_decimal(first, last, a, static_cast<int>(fmt), 
+                          std::max(precision, 0));
+}
+#endif
+
 /* Debugging routines */
 void dd_real::dump(const string &name, std::ostream &os) const {
   std::ios_base::fmtflags old_flags = os.flags();
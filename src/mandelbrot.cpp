@@ -0,0 +1,1261 @@
+/*
+ * src/mandelbrot.cpp
+ *
+ * Deep zoom rendering of the Mandelbrot set by perturbation.  See
+ * include/qd/mandelbrot.h.
+ */
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include "config.h"
+#include <qd/dd_real.h>
+#include <qd/mandelbrot.h>
+#include <qd/qd_io.h>
+#include <qd/metal_cpu.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define qd_getpid _getpid
+#else
+#include <unistd.h>
+#define qd_getpid getpid
+#endif
+
+typedef std::chrono::steady_clock mandel_clock;
+
+static double seconds_since(mandel_clock::time_point t0) {
+  return std::chrono::duration<double>(mandel_clock::now() - t0).count();
+}
+
+void qd_mandel_orbit::compute(const qd_real &re, const qd_real &im,
+                              int max_iter, double bailout) {
+  this->re = re;
+  this->im = im;
+  this->max_iter = max_iter;
+  this->bailout = bailout;
+  zr.clear();
+  zi.clear();
+  zr_lo.clear();
+  zi_lo.clear();
+  zr.reserve(max_iter + 1);
+  zi.reserve(max_iter + 1);
+  zr_lo.reserve(max_iter + 1);
+  zi_lo.reserve(max_iter + 1);
+
+  qd_real x = 0.0, y = 0.0;
+  double b2 = bailout * bailout;
+  for (int n = 0; ; n++) {
+    double xd = to_double(x), yd = to_double(y);
+    zr.push_back(xd);
+    zi.push_back(yd);
+    zr_lo.push_back(to_double(x - xd));
+    zi_lo.push_back(to_double(y - yd));
+    if (n == max_iter || xd * xd + yd * yd > b2)
+      break;
+    /* (x + iy)^2 + C */
+    qd_real xy = x * y;
+    x = sqr(x) - sqr(y) + re;
+    y = mul_pwr2(xy, 2.0) + im;
+  }
+}
+
+int qd_mandel_series::compute(const qd_mandel_orbit &orbit, double radius,
+                              int terms, double tolerance, int limit) {
+  this->radius = radius;
+  skip = 0;
+  br.assign(terms > 0 ? terms : 0, 0.0);
+  bi.assign(br.size(), 0.0);
+  if (terms <= 0)
+    return 0;
+
+  /* a[k] holds b(k+1) at step skip, t[k] the next step. */
+  std::vector<dd_real> ar(terms, 0.0), ai(terms, 0.0);
+  std::vector<dd_real> tr(terms), ti(terms);
+  double tol2 = tolerance * tolerance;
+
+  /* Probes at the corners of the square inscribed in |dc| = radius,
+     iterated the way the pixels are.                                 */
+  const double h = std::sqrt(0.5);
+  const double ur[4] = { h, -h, -h, h }, ui[4] = { h, h, -h, -h };
+  double qr[4] = { 0.0, 0.0, 0.0, 0.0 }, qi[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+  int last = orbit.size() - 1;
+  if (limit >= 0 && limit < last)
+    last = limit;
+  bool lo = (orbit.zr_lo.size() == orbit.zr.size());
+  for (int n = 0; n < last; n++) {
+    dd_real zr2(2.0 * orbit.zr[n], lo ? 2.0 * orbit.zr_lo[n] : 0.0);
+    dd_real zi2(2.0 * orbit.zi[n], lo ? 2.0 * orbit.zi_lo[n] : 0.0);
+    for (int k = 0; k < terms; k++) {
+      /* 2 Z b(k+1) + sum(i+j=k+1) b(i) b(j) */
+      dd_real sr = zr2 * ar[k] - zi2 * ai[k];
+      dd_real si = zr2 * ai[k] + zi2 * ar[k];
+      for (int i = 0, j = k - 1; i <= j; i++, j--) {
+        dd_real pr = ar[i] * ar[j] - ai[i] * ai[j];
+        dd_real pi = ar[i] * ai[j] + ai[i] * ar[j];
+        if (i != j) {
+          pr = mul_pwr2(pr, 2.0);
+          pi = mul_pwr2(pi, 2.0);
+        }
+        sr += pr;
+        si += pi;
+      }
+      if (k == 0)
+        sr += radius;
+      tr[k] = sr;
+      ti[k] = si;
+    }
+
+    /* The last term estimates what the truncated ones add. */
+    double b1 = to_double(sqr(tr[0]) + sqr(ti[0]));
+    if (terms > 1 &&
+        to_double(sqr(tr[terms - 1]) + sqr(ti[terms - 1])) > tol2 * b1)
+      break;
+
+    bool valid = true;
+    for (int p = 0; p < 4; p++) {
+      double sr = 2.0 * orbit.zr[n] + qr[p], si = 2.0 * orbit.zi[n] + qi[p];
+      double t = sr * qr[p] - si * qi[p] + radius * ur[p];
+      qi[p] = sr * qi[p] + si * qr[p] + radius * ui[p];
+      qr[p] = t;
+
+      /* Horner's rule on the new coefficients. */
+      double er = 0.0, ei = 0.0;
+      for (int k = terms - 1; k >= 0; k--) {
+        double xr = er + to_double(tr[k]), xi = ei + to_double(ti[k]);
+        er = xr * ur[p] - xi * ui[p];
+        ei = xr * ui[p] + xi * ur[p];
+      }
+      double d2 = (er - qr[p]) * (er - qr[p]) + (ei - qi[p]) * (ei - qi[p]);
+      if (!(d2 <= tol2 * (qr[p] * qr[p] + qi[p] * qi[p])))
+        valid = false;
+    }
+    if (!valid)
+      break;
+
+    ar.swap(tr);
+    ai.swap(ti);
+    skip = n + 1;
+  }
+
+  for (int k = 0; k < terms; k++) {
+    br[k] = to_double(ar[k]);
+    bi[k] = to_double(ai[k]);
+  }
+  return skip;
+}
+
+void qd_mandel_series::evaluate(double ur, double ui,
+                                double &dzr, double &dzi) const {
+  double er = 0.0, ei = 0.0;
+  for (int k = static_cast<int>(br.size()) - 1; k >= 0; k--) {
+    double xr = er + br[k], xi = ei + bi[k];
+    er = xr * ur - xi * ui;
+    ei = xr * ui + xi * ur;
+  }
+  dzr = er;
+  dzi = ei;
+}
+
+void qd_mandel_series::derivative(double ur, double ui,
+                                  double &dr, double &di) const {
+  /* sum k b(k) u^(k-1), divided by radius */
+  double er = 0.0, ei = 0.0;
+  for (int k = static_cast<int>(br.size()) - 1; k >= 0; k--) {
+    double t = er * ur - ei * ui + (k + 1) * br[k];
+    ei = er * ui + ei * ur + (k + 1) * bi[k];
+    er = t;
+  }
+  dr = er / radius;
+  di = ei / radius;
+}
+
+/* Iterates the pixel at offset dc from the reference, starting from
+   dz and its derivative dz/dc = de at step skip, and returns its
+   smooth iteration count; n is set to the step it stopped at.  With
+   track set dz/dc is iterated along and distance is set to the
+   distance estimate 2 |z| log|z| / |dz/dc|, or 0 for interior pixels.
+
+   With g2 > 0 the pixel is glitched if |z(n)|^2 < g2 |Z(n)|^2 at some
+   step, or if it outlives the reference.  glitch is then set to
+   |z(n)|^2 / |Z(n)|^2 (1 for outliving pixels) and the count is not
+   valid; otherwise glitch is set to -1.  With g2 = 0 a pixel that
+   outlives the reference continues in plain double, unless C + dc
+   does not resolve dc in double, in which case it is glitched too.
+
+   With p2 > 0, which needs track, z(n) is compared with z at the
+   steps skip + 2^k before it (Brent's method).  If they differ by less
+   than sqrt(p2) |dz/dc|, that is if a change of c by sqrt(p2) could
+   make the orbit periodic with period p = n - saved, z(n + p) is
+   compared with z(n) in turn.  If that distance is smaller still the
+   cycle attracts and the pixel is interior; outside the set, orbits
+   near a miniature set follow its cycle closely but it repels.    */
+template <bool track>
+static float iterate(const qd_mandel_orbit &orbit, double dcr, double dci,
+                     int skip, double dzr, double dzi, double der, double dei,
+                     int max_iter, double bailout, double g2, double p2,
+                     int &n, double &glitch, double &distance) {
+  const double *zr = &orbit.zr[0], *zi = &orbit.zi[0];
+  const double *zr_lo = &orbit.zr_lo[0], *zi_lo = &orbit.zi_lo[0];
+  int last = orbit.size() - 1;
+  double b2 = bailout * bailout;
+  double xr = 0.0, xi = 0.0, r2 = 0.0;
+  glitch = -1.0;
+  distance = 0.0;
+
+  /* Z and dz at the step saved for the periodicity check, the step to
+     save at next, and the squared distance of a candidate cycle that
+     is confirmed or rejected at step confirm.                         */
+  double sr = 0.0, sr_lo = 0.0, si = 0.0, si_lo = 0.0, sdr = 0.0, sdi = 0.0;
+  double cand = 0.0;
+  int saved = skip, next = skip, confirm = -1;
+
+  for (n = skip; n <= max_iter; n++) {
+    if (n > last)
+      break;
+    xr = zr[n] + dzr;
+    xi = zi[n] + dzi;
+    r2 = xr * xr + xi * xi;
+    if (r2 > b2)
+      break;
+    double ref2 = zr[n] * zr[n] + zi[n] * zi[n];
+    if (r2 < g2 * ref2) {
+      glitch = r2 / ref2;
+      return qd_mandel_interior;
+    }
+    if (track && p2 > 0.0) {
+      bool save = (n == next && confirm < 0);
+      if (n > skip && (confirm < 0 || n == confirm)) {
+        /* z(n) - z(saved), with both limbs of the reference */
+        double er = (zr[n] - sr) + (zr_lo[n] - sr_lo) + (dzr - sdr);
+        double ei = (zi[n] - si) + (zi_lo[n] - si_lo) + (dzi - sdi);
+        double d2 = er * er + ei * ei;
+        if (confirm == n) {
+          if (d2 < cand)
+            return qd_mandel_interior;
+          confirm = -1;
+          save = true;
+        } else if (d2 < p2 * (der * der + dei * dei)) {
+          cand = d2;
+          confirm = 2 * n - saved;
+          save = true;
+        }
+      }
+      if (save) {
+        sr = zr[n];
+        sr_lo = zr_lo[n];
+        si = zi[n];
+        si_lo = zi_lo[n];
+        sdr = dzr;
+        sdi = dzi;
+        saved = n;
+        next = (n == skip) ? n + 1 : 2 * n - skip;
+      }
+    }
+    if (track) {
+      /* dz/dc = 2 z dz/dc + 1 */
+      double t = 2.0 * (xr * der - xi * dei) + 1.0;
+      dei = 2.0 * (xr * dei + xi * der);
+      der = t;
+    }
+    /* dz = (2 Z + dz) dz + dc */
+    double tr = 2.0 * zr[n] + dzr, ti = 2.0 * zi[n] + dzi;
+    double t = tr * dzr - ti * dzi + dcr;
+    dzi = tr * dzi + ti * dzr + dci;
+    dzr = t;
+  }
+
+  if (n > last && n <= max_iter && g2 > 0.0) {
+    glitch = 1.0;
+    return qd_mandel_interior;
+  }
+
+  /* The reference escaped first: continue with z itself in double,
+     from z(last) in xr, xi and dz/dc already at step last + 1, as
+     long as c = C + dc still resolves dc in double.                 */
+  if (n > last && n <= max_iter) {
+    double cr = to_double(orbit.re) + dcr, ci = to_double(orbit.im) + dci;
+    double er = to_double(orbit.re - cr) + dcr;
+    double ei = to_double(orbit.im - ci) + dci;
+    if (std::fabs(er) + std::fabs(ei) >
+        std::ldexp(std::fabs(dcr) + std::fabs(dci), -10)) {
+      glitch = 1.0;
+      return qd_mandel_interior;
+    }
+    for (n = last + 1; n <= max_iter; n++) {
+      double t = xr * xr - xi * xi + cr;
+      xi = 2.0 * xr * xi + ci;
+      xr = t;
+      r2 = xr * xr + xi * xi;
+      if (r2 > b2)
+        break;
+      if (track) {
+        t = 2.0 * (xr * der - xi * dei) + 1.0;
+        dei = 2.0 * (xr * dei + xi * der);
+        der = t;
+      }
+    }
+  }
+
+  if (n > max_iter) {
+    n = max_iter;
+    return qd_mandel_interior;
+  }
+  if (track)
+    distance = std::sqrt(r2) * std::log(r2) / std::hypot(der, dei);
+  return static_cast<float>(n + 1 -
+      std::log2(0.5 * std::log(r2) / std::log(bailout)));
+}
+
+/* A pool of nthreads threads (all hardware threads if nthreads <= 0),
+   or only the calling thread if no threads can be started.         */
+static std::unique_ptr<qd_cpu::thread_pool> make_pool(int nthreads) {
+  try {
+    return std::unique_ptr<qd_cpu::thread_pool>(
+        new qd_cpu::thread_pool(nthreads > 0 ? nthreads : 0));
+  } catch (const std::system_error &) {
+    return std::unique_ptr<qd_cpu::thread_pool>(new qd_cpu::thread_pool(1));
+  }
+}
+
+/* Sample points: width x height points, pixel apart, centered on the
+   center of the view the way its pixels are.  Point p is at offset
+   (x(p), y(p)) from the center; row 0 is the top.                 */
+struct sample_grid {
+  size_t width, height;
+  double pixel;
+
+  double x(size_t p) const { return (p % width + 0.5 - 0.5 * width) * pixel; }
+  double y(size_t p) const {
+    return (0.5 * height - p / width - 0.5) * pixel;
+  }
+};
+
+/* Points to render, tile by tile: tile t is idx[tiles[t]] up to
+   idx[tiles[t+1]] excluded.                                      */
+struct sample_list {
+  std::vector<size_t> idx;
+  std::vector<size_t> tiles;
+};
+
+/* What iterate returns for each point of a list, by position. */
+struct sample_results {
+  std::vector<float> count;
+  std::vector<double> distance;
+  std::vector<double> glitch;
+  std::vector<int> step;
+
+  void resize(size_t n) {
+    count.resize(n);
+    distance.resize(n);
+    glitch.resize(n);
+    step.resize(n);
+  }
+};
+
+/* The pixels of pass stride: those with both coordinates multiples of
+   stride, less those of the previous pass unless first is set.      */
+static void pass_pixels(const qd_mandel_view &v, int tile, int stride,
+                        bool first, sample_list &list) {
+  list.idx.clear();
+  list.tiles.clear();
+  for (int ty = 0; ty < v.height; ty += tile)
+    for (int tx = 0; tx < v.width; tx += tile) {
+      size_t start = list.idx.size();
+      for (int y = ty; y < std::min(ty + tile, v.height); y++) {
+        if (y % stride != 0)
+          continue;
+        for (int x = tx; x < std::min(tx + tile, v.width); x++)
+          if (x % stride == 0 &&
+              (first || x % (2 * stride) != 0 || y % (2 * stride) != 0))
+            list.idx.push_back(static_cast<size_t>(y) * v.width + x);
+      }
+      if (list.idx.size() > start)
+        list.tiles.push_back(start);
+    }
+  list.tiles.push_back(list.idx.size());
+}
+
+/* Cuts list.idx into tiles of n points. */
+static void cut_tiles(sample_list &list, size_t n) {
+  list.tiles.clear();
+  for (size_t i = 0; i < list.idx.size(); i += n)
+    list.tiles.push_back(i);
+  list.tiles.push_back(list.idx.size());
+}
+
+static bool is_cancelled(const std::atomic<bool> *cancel) {
+  return cancel && cancel->load(std::memory_order_relaxed);
+}
+
+/* Renders the points of list against orbit, whose C is at offset
+   (ref_x, ref_y) from the center of the view, starting from series.
+   The results of point i go to position pos[i] of res; dz/dc and the
+   distance estimates are computed only if track is set.  Returns the
+   iterations done.                                                  */
+static long long render_samples(qd_cpu::thread_pool &pool,
+                                const sample_grid &grid,
+                                const qd_mandel_view &v,
+                                const qd_mandel_options &opt,
+                                const qd_mandel_orbit &orbit,
+                                double ref_x, double ref_y,
+                                const qd_mandel_series &series,
+                                double g2, double p2, bool track,
+                                const sample_list &list,
+                                const std::vector<size_t> &pos,
+                                sample_results &res,
+                                const std::atomic<bool> *cancel) {
+  std::atomic<long long> iterations(0);
+  pool.parallel_for(list.tiles.size() - 1, [&](size_t t) {
+    long long total = 0;
+    for (size_t i = list.tiles[t]; i < list.tiles[t + 1]; i++) {
+      if (is_cancelled(cancel))
+        break;
+      size_t p = list.idx[i], r = pos[i];
+      double dcr = grid.x(p) - ref_x, dci = grid.y(p) - ref_y;
+      double dzr = 0.0, dzi = 0.0, der = 0.0, dei = 0.0;
+      if (series.skip > 0) {
+        double ur = dcr / series.radius, ui = dci / series.radius;
+        series.evaluate(ur, ui, dzr, dzi);
+        series.derivative(ur, ui, der, dei);
+      }
+      int n;
+      if (track)
+        res.count[r] = iterate<true>(orbit, dcr, dci, series.skip, dzr, dzi,
+                                     der, dei, v.max_iter, opt.bailout, g2,
+                                     p2, n, res.glitch[r], res.distance[r]);
+      else
+        res.count[r] = iterate<false>(orbit, dcr, dci, series.skip, dzr, dzi,
+                                      der, dei, v.max_iter, opt.bailout, g2,
+                                      0.0, n, res.glitch[r], res.distance[r]);
+      res.step[r] = n;
+      total += n - series.skip;
+    }
+    iterations += total;
+  });
+  return iterations.load();
+}
+
+/* Renders the points of list by perturbation, starting against the
+   reference first at offset (ref_x, ref_y) with its series, and
+   rendering glitched points again against new references.  Adds the
+   time spent on references, their number and the points glitched
+   with first.  track is as in render_samples.  Returns the
+   iterations done.                                                  */
+static long long perturb_samples(qd_cpu::thread_pool &pool,
+                                 const sample_grid &grid,
+                                 const qd_mandel_view &v,
+                                 const qd_mandel_options &opt,
+                                 const qd_mandel_orbit &first,
+                                 const qd_mandel_series &first_series,
+                                 double ref_x, double ref_y,
+                                 bool track, const sample_list &list,
+                                 sample_results &res,
+                                 const std::atomic<bool> *cancel,
+                                 double &t_ref, int &references,
+                                 int &glitched) {
+  double g2 = opt.glitch_tolerance * opt.glitch_tolerance;
+  double p2 = opt.periodicity_tolerance * grid.pixel;
+  p2 *= p2;
+  res.resize(list.idx.size());
+  std::vector<size_t> pos(list.idx.size());
+  for (size_t i = 0; i < pos.size(); i++)
+    pos[i] = i;
+
+  const qd_mandel_orbit *orbit = &first;
+  const qd_mandel_series *series = &first_series;
+  qd_mandel_orbit other;
+  qd_mandel_series other_series;
+  sample_list cur = list;
+  long long iterations = 0;
+  int used = 1;
+
+  for (;;) {
+    /* The last reference accepts its glitches. */
+    bool final = (used >= opt.max_references);
+    iterations += render_samples(pool, grid, v, opt, *orbit, ref_x, ref_y,
+                                 *series, final ? 0.0 : g2, p2, track, cur,
+                                 pos, res, cancel);
+    if (is_cancelled(cancel))
+      break;
+
+    sample_list left;
+    std::vector<size_t> left_pos;
+    for (size_t i = 0; i < cur.idx.size(); i++)
+      if (res.glitch[pos[i]] >= 0.0) {
+        left.idx.push_back(cur.idx[i]);
+        left_pos.push_back(pos[i]);
+      }
+    if (used == 1)
+      glitched += static_cast<int>(left.idx.size());
+    if (left.idx.empty() || final)
+      break;
+
+    /* Points that glitch at the same step form one region; the next
+       reference is the point of the largest region that came closest
+       to zero, which lies near the miniature set causing it.        */
+    std::map<int, int> regions;
+    for (size_t i = 0; i < left_pos.size(); i++)
+      regions[res.step[left_pos[i]]]++;
+    int region = regions.begin()->first, size = 0;
+    for (std::map<int, int>::const_iterator it = regions.begin();
+         it != regions.end(); ++it)
+      if (it->second > size) {
+        region = it->first;
+        size = it->second;
+      }
+    size_t best = left_pos.size();
+    for (size_t i = 0; i < left_pos.size(); i++)
+      if (res.step[left_pos[i]] == region &&
+          (best == left_pos.size() ||
+           res.glitch[left_pos[i]] < res.glitch[left_pos[best]]))
+        best = i;
+
+    ref_x = grid.x(left.idx[best]);
+    ref_y = grid.y(left.idx[best]);
+    double radius = grid.pixel;
+    for (size_t i = 0; i < left.idx.size(); i++)
+      radius = std::max(radius, std::hypot(grid.x(left.idx[i]) - ref_x,
+                                           grid.y(left.idx[i]) - ref_y));
+
+    mandel_clock::time_point t1 = mandel_clock::now();
+    other.compute(v.re + ref_x, v.im + ref_y, v.max_iter, opt.bailout);
+    other_series.compute(other, radius, opt.series_terms,
+                         opt.series_tolerance);
+    t_ref += seconds_since(t1);
+    orbit = &other;
+    series = &other_series;
+    used++;
+    references++;
+
+    cur.idx.swap(left.idx);
+    pos.swap(left_pos);
+    cut_tiles(cur, static_cast<size_t>(opt.tile_size) * opt.tile_size);
+  }
+  return iterations;
+}
+
+/* a rounded to T. */
+static dd_real round_to(const qd_real &a, const dd_real *) {
+  return to_dd_real(a);
+}
+
+static dd_real round_to(const dd_real &a, const dd_real *) { return a; }
+
+static qd_real round_to(const qd_real &a, const qd_real *) { return a; }
+
+/* Smooth iteration count of c = cr + i ci, iterating z itself in T
+   and, with track set, dz/dc in dd_real; n, distance and p2 are as
+   in iterate.                                                      */
+template <bool track, class T>
+static float direct_count(const T &cr, const T &ci, int max_iter,
+                          double bailout, double p2, int &n,
+                          double &distance) {
+  T x = 0.0, y = 0.0, sx = 0.0, sy = 0.0;
+  dd_real der = 0.0, dei = 0.0;
+  double b2 = bailout * bailout, cand = 0.0;
+  int saved = 0, next = 0, confirm = -1;
+  distance = 0.0;
+  for (n = 0; n <= max_iter; n++) {
+    double r2 = to_double(sqr(x) + sqr(y));
+    if (r2 > b2) {
+      if (track)
+        distance = std::sqrt(r2) * std::log(r2) /
+                   std::hypot(to_double(der), to_double(dei));
+      return static_cast<float>(n + 1 -
+          std::log2(0.5 * std::log(r2) / std::log(bailout)));
+    }
+    if (track && p2 > 0.0) {
+      bool save = (n == next && confirm < 0);
+      if (n > 0 && (confirm < 0 || n == confirm)) {
+        double er = to_double(x - sx), ei = to_double(y - sy);
+        double d2 = er * er + ei * ei;
+        if (confirm == n) {
+          if (d2 < cand)
+            return qd_mandel_interior;
+          confirm = -1;
+          save = true;
+        } else if (d2 < p2 * to_double(sqr(der) + sqr(dei))) {
+          cand = d2;
+          confirm = 2 * n - saved;
+          save = true;
+        }
+      }
+      if (save) {
+        sx = x;
+        sy = y;
+        saved = n;
+        next = (n == 0) ? 1 : 2 * n;
+      }
+    }
+    if (track) {
+      dd_real xd = round_to(x, static_cast<dd_real *>(0));
+      dd_real yd = round_to(y, static_cast<dd_real *>(0));
+      dd_real t = mul_pwr2(xd * der - yd * dei, 2.0) + 1.0;
+      dei = mul_pwr2(xd * dei + yd * der, 2.0);
+      der = t;
+    }
+    T xy = x * y;
+    x = sqr(x) - sqr(y) + cr;
+    y = mul_pwr2(xy, 2.0) + ci;
+  }
+  n = max_iter;
+  return qd_mandel_interior;
+}
+
+/* Renders the points of list by iterating each one in T; track is
+   as in render_samples.                                           */
+template <class T>
+static long long direct_samples(qd_cpu::thread_pool &pool,
+                                const sample_grid &grid,
+                                const qd_mandel_view &v,
+                                const qd_mandel_options &opt,
+                                bool track, const sample_list &list,
+                                sample_results &res,
+                                const std::atomic<bool> *cancel) {
+  T re = round_to(v.re, static_cast<T *>(0));
+  T im = round_to(v.im, static_cast<T *>(0));
+  double p2 = opt.periodicity_tolerance * grid.pixel;
+  p2 *= p2;
+  res.resize(list.idx.size());
+  std::atomic<long long> iterations(0);
+  pool.parallel_for(list.tiles.size() - 1, [&](size_t t) {
+    long long total = 0;
+    for (size_t i = list.tiles[t]; i < list.tiles[t + 1]; i++) {
+      if (is_cancelled(cancel))
+        break;
+      size_t p = list.idx[i];
+      T cr = re + grid.x(p), ci = im + grid.y(p);
+      int n;
+      if (track)
+        res.count[i] = direct_count<true>(cr, ci, v.max_iter, opt.bailout,
+                                          p2, n, res.distance[i]);
+      else
+        res.count[i] = direct_count<false>(cr, ci, v.max_iter, opt.bailout,
+                                           0.0, n, res.distance[i]);
+      res.glitch[i] = -1.0;
+      res.step[i] = n;
+      total += n;
+    }
+    iterations += total;
+  });
+  return iterations.load();
+}
+
+/* Fills the pixels off the grid of multiples of stride by bilinear
+   interpolation of the grid, or from its nearest point up and left
+   when a corner is interior.                                        */
+static void interpolate(const qd_mandel_view &v, int stride,
+                        std::vector<float> &counts) {
+  for (int y = 0; y < v.height; y++) {
+    int y0 = y - y % stride, y1 = std::min(y0 + stride, v.height - 1);
+    y1 -= y1 % stride;
+    double fy = (y1 > y0) ? double(y - y0) / (y1 - y0) : 0.0;
+    for (int x = 0; x < v.width; x++) {
+      if (x % stride == 0 && y % stride == 0)
+        continue;
+      int x0 = x - x % stride, x1 = std::min(x0 + stride, v.width - 1);
+      x1 -= x1 % stride;
+      double fx = (x1 > x0) ? double(x - x0) / (x1 - x0) : 0.0;
+      float c00 = counts[y0 * v.width + x0], c01 = counts[y0 * v.width + x1];
+      float c10 = counts[y1 * v.width + x0], c11 = counts[y1 * v.width + x1];
+      if (c00 < 0.0f || c01 < 0.0f || c10 < 0.0f || c11 < 0.0f)
+        counts[y * v.width + x] = c00;
+      else
+        counts[y * v.width + x] = static_cast<float>(
+            (1.0 - fy) * ((1.0 - fx) * c00 + fx * c01) +
+            fy * ((1.0 - fx) * c10 + fx * c11));
+    }
+  }
+}
+
+/* True if pixel (x, y) is worth supersampling: it is outside the set
+   but closer to it than max_distance pixels, or inside next to a
+   pixel outside.                                                    */
+static bool near_boundary(const qd_mandel_view &v,
+                          const std::vector<float> &counts,
+                          const std::vector<float> &distance,
+                          double max_distance, int x, int y) {
+  size_t p = static_cast<size_t>(y) * v.width + x;
+  if (counts[p] >= 0.0f)
+    return distance[p] < max_distance;
+  return (x > 0 && counts[p - 1] >= 0.0f) ||
+         (x + 1 < v.width && counts[p + 1] >= 0.0f) ||
+         (y > 0 && counts[p - v.width] >= 0.0f) ||
+         (y + 1 < v.height && counts[p + v.width] >= 0.0f);
+}
+
+static bool valid(const qd_mandel_view &v, const qd_mandel_options &opt) {
+  return v.width > 0 && v.height > 0 && v.max_iter >= 0 &&
+         v.radius > 0.0 && opt.bailout >= 2.0 && opt.max_references >= 1 &&
+         opt.glitch_tolerance >= 0.0 && opt.passes >= 1 &&
+         opt.passes <= 16 && opt.tile_size >= 1 &&
+         (opt.kernel == qd_mandel_perturbation ||
+          opt.kernel == qd_mandel_direct_dd ||
+          opt.kernel == qd_mandel_direct_qd) &&
+         opt.periodicity_tolerance >= 0.0 && opt.antialias >= 1 &&
+         opt.antialias <= 16 && opt.antialias_distance >= 0.0;
+}
+
+/* Renders v into counts and, if distance is not null, the distance
+   estimates in pixels into it.  Calls on_pass(p) after pass p, and
+   stops early if cancel becomes set.  Returns true if it completed. */
+static bool render(qd_cpu::thread_pool &pool, const qd_mandel_view &v,
+                   const qd_mandel_options &opt, std::vector<float> &counts,
+                   std::vector<float> *distance, qd_mandel_stats *stats,
+                   const std::atomic<bool> *cancel,
+                   const std::function<void(int)> &on_pass) {
+  mandel_clock::time_point t0 = mandel_clock::now();
+  double pixel = 2.0 * v.radius / v.width;
+  size_t npixels = static_cast<size_t>(v.width) * v.height;
+  counts.assign(npixels, qd_mandel_interior);
+  std::vector<float> de(npixels, 0.0f);
+  long long iterations = 0;
+  int references = 0, glitched = 0, periodic = 0, supersampled = 0;
+
+  /* The first reference, at the center or taken from the cache at
+     offset (ref_x, ref_y), and its series serve every pass.        */
+  std::shared_ptr<const qd_mandel_orbit> first;
+  qd_mandel_series first_series;
+  double ref_x = 0.0, ref_y = 0.0;
+  bool cached = false;
+  if (opt.kernel == qd_mandel_perturbation) {
+    if (opt.orbit_cache) {
+      first = opt.orbit_cache->get(v, opt.bailout, &cached);
+      ref_x = to_double(first->re - v.re);
+      ref_y = to_double(first->im - v.im);
+    } else {
+      qd_mandel_orbit *orbit = new qd_mandel_orbit;
+      first.reset(orbit);
+      orbit->compute(v.re, v.im, v.max_iter, opt.bailout);
+    }
+    first_series.compute(*first, std::hypot(ref_x, ref_y) +
+                         0.5 * pixel * std::hypot(v.width, v.height),
+                         opt.series_terms, opt.series_tolerance, v.max_iter);
+    references = 1;
+  }
+  double t_ref = seconds_since(t0);
+
+  /* Renders list on grid into res with the kernel of opt, skipping
+     dz/dc unless something needs it.                             */
+  bool track = distance || opt.antialias > 1 ||
+               opt.periodicity_tolerance > 0.0;
+  auto run = [&](const sample_grid &grid, const sample_list &list,
+                 sample_results &res) {
+    if (opt.kernel == qd_mandel_direct_dd)
+      iterations += direct_samples<dd_real>(pool, grid, v, opt, track, list,
+                                            res, cancel);
+    else if (opt.kernel == qd_mandel_direct_qd)
+      iterations += direct_samples<qd_real>(pool, grid, v, opt, track, list,
+                                            res, cancel);
+    else
+      iterations += perturb_samples(pool, grid, v, opt, *first, first_series,
+                                    ref_x, ref_y, track, list, res, cancel,
+                                    t_ref, references, glitched);
+  };
+
+  sample_grid grid = { static_cast<size_t>(v.width),
+                       static_cast<size_t>(v.height), pixel };
+  sample_list list;
+  sample_results res;
+  for (int pass = 1; pass <= opt.passes; pass++) {
+    int stride = 1 << (opt.passes - pass);
+    pass_pixels(v, opt.tile_size, stride, pass == 1, list);
+    run(grid, list, res);
+    if (is_cancelled(cancel))
+      return false;
+
+    for (size_t i = 0; i < list.idx.size(); i++) {
+      counts[list.idx[i]] = res.count[i];
+      de[list.idx[i]] = static_cast<float>(res.distance[i] / pixel);
+      periodic += (res.count[i] < 0.0f && res.step[i] < v.max_iter);
+    }
+    if (stride > 1)
+      interpolate(v, stride, counts);
+
+    /* Near the boundary, average antialias^2 points in each pixel;
+       the pixel is interior if most of them are.                    */
+    if (pass == opt.passes && opt.antialias > 1) {
+      size_t aa = static_cast<size_t>(opt.antialias);
+      sample_grid fine = { aa * v.width, aa * v.height, pixel / aa };
+      std::vector<size_t> pixels;
+      list.idx.clear();
+      for (int y = 0; y < v.height; y++)
+        for (int x = 0; x < v.width; x++)
+          if (near_boundary(v, counts, de, opt.antialias_distance, x, y)) {
+            pixels.push_back(static_cast<size_t>(y) * v.width + x);
+            for (size_t j = 0; j < aa; j++)
+              for (size_t i = 0; i < aa; i++)
+                list.idx.push_back((y * aa + j) * fine.width + x * aa + i);
+          }
+      cut_tiles(list, static_cast<size_t>(opt.tile_size) * opt.tile_size);
+      run(fine, list, res);
+      if (is_cancelled(cancel))
+        return false;
+
+      for (size_t k = 0; k < pixels.size(); k++) {
+        double sum = 0.0;
+        size_t escaped = 0;
+        for (size_t i = k * aa * aa; i < (k + 1) * aa * aa; i++)
+          if (res.count[i] >= 0.0f) {
+            sum += res.count[i];
+            escaped++;
+          }
+        counts[pixels[k]] = (2 * escaped >= aa * aa)
+            ? static_cast<float>(sum / escaped) : qd_mandel_interior;
+      }
+      supersampled = static_cast<int>(pixels.size());
+    }
+
+    if (on_pass)
+      on_pass(pass);
+  }
+
+  if (distance)
+    distance->swap(de);
+  if (stats) {
+    stats->seconds = seconds_since(t0);
+    stats->reference_seconds = t_ref;
+    stats->iterations = static_cast<double>(iterations);
+    stats->reference_length =
+        first ? std::min(first->size() - 1, v.max_iter) : 0;
+    stats->series_skip = first_series.skip;
+    stats->references = references;
+    stats->glitched = glitched;
+    stats->reference_cached = cached;
+    stats->periodic = periodic;
+    stats->supersampled = supersampled;
+  }
+  return true;
+}
+
+int qd_mandel_render(const qd_mandel_view &v, std::vector<float> &counts,
+                     const qd_mandel_options &opt, qd_mandel_stats *stats) {
+  if (!valid(v, opt)) {
+    errno = EINVAL;
+    return -1;
+  }
+  std::unique_ptr<qd_cpu::thread_pool> pool = make_pool(opt.nthreads);
+  render(*pool, v, opt, counts, 0, stats, 0, std::function<void(int)>());
+  return 0;
+}
+
+int qd_mandel_render(const qd_mandel_view &v, std::vector<float> &counts,
+                     std::vector<float> &distance,
+                     const qd_mandel_options &opt, qd_mandel_stats *stats) {
+  if (!valid(v, opt)) {
+    errno = EINVAL;
+    return -1;
+  }
+  std::unique_ptr<qd_cpu::thread_pool> pool = make_pool(opt.nthreads);
+  render(*pool, v, opt, counts, &distance, stats, 0,
+         std::function<void(int)>());
+  return 0;
+}
+
+/* z(period) and dz(period)/dc at c = cr + i ci, iterated in T. */
+template <class T>
+static void periodic_point(const T &cr, const T &ci, int period,
+                           T &zr, T &zi, T &dr, T &di) {
+  zr = 0.0;
+  zi = 0.0;
+  dr = 0.0;
+  di = 0.0;
+  for (int n = 0; n < period; n++) {
+    /* dz/dc = 2 z dz/dc + 1, z = z^2 + c */
+    T t = mul_pwr2(zr * dr - zi * di, 2.0) + 1.0;
+    di = mul_pwr2(zr * di + zi * dr, 2.0);
+    dr = t;
+    T xy = zr * zi;
+    zr = sqr(zr) - sqr(zi) + cr;
+    zi = mul_pwr2(xy, 2.0) + ci;
+  }
+}
+
+/* The Newton step -z(period) / (dz(period)/dc) at c, computed in T.
+   Returns false if the derivative vanishes or the step overflows. */
+template <class T>
+static bool newton_step(const qd_real &re, const qd_real &im, int period,
+                        T &sr, T &si) {
+  T cr = round_to(re, static_cast<T *>(0));
+  T ci = round_to(im, static_cast<T *>(0));
+  T zr, zi, dr, di;
+  periodic_point(cr, ci, period, zr, zi, dr, di);
+  T d2 = sqr(dr) + sqr(di);
+  if (d2.is_zero())
+    return false;
+  sr = -(zr * dr + zi * di) / d2;
+  si = (zr * di - zi * dr) / d2;
+  return std::isfinite(to_double(sr)) && std::isfinite(to_double(si));
+}
+
+int qd_mandel_find_nucleus(const qd_real &re, const qd_real &im,
+                           int period, qd_mandel_nucleus &nucleus,
+                           int max_steps) {
+  if (period < 1 || max_steps < 1) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  /* Newton's method converges quadratically: once a dd_real step is
+     below 2^-80 |c| the next would exhaust dd_real's 106 bits, so the
+     rest is done in qd_real until the step is down to its roundoff. */
+  qd_real cr = re, ci = im;
+  bool dd = true, converged = false;
+  double last = 0.0;
+  int steps = 0;
+  while (steps < max_steps && !converged) {
+    double c = std::max(1.0, std::hypot(to_double(cr), to_double(ci)));
+    double step;
+    if (dd) {
+      dd_real sr, si;
+      if (!newton_step(cr, ci, period, sr, si))
+        break;
+      step = std::hypot(to_double(sr), to_double(si));
+      if (step < std::ldexp(c, -80)) {
+        dd = false;
+        continue;
+      }
+      cr += sr;
+      ci += si;
+    } else {
+      qd_real sr, si;
+      if (!newton_step(cr, ci, period, sr, si))
+        break;
+      step = std::hypot(to_double(sr), to_double(si));
+      if (last > 0.0 && step >= last && step < std::ldexp(c, -160)) {
+        /* The steps stopped shrinking: roundoff is reached. */
+        converged = true;
+      } else {
+        cr += sr;
+        ci += si;
+        converged = step < std::ldexp(c, -190);
+      }
+      last = step;
+    }
+    steps++;
+    if (std::hypot(to_double(cr), to_double(ci)) > 2.0)
+      break;
+  }
+  if (!converged) {
+    errno = EDOM;
+    return -1;
+  }
+
+  /* The least period is the first q with z(q) = 0 up to roundoff, and
+     the atom domain is sized by the smallest |z(q)| before it.      */
+  nucleus.re = cr;
+  nucleus.im = ci;
+  nucleus.steps = steps;
+  nucleus.period = period;
+  nucleus.size = std::numeric_limits<double>::infinity();
+  qd_real zr = 0.0, zi = 0.0, dr = 0.0, di = 0.0;
+  double smallest = std::numeric_limits<double>::infinity();
+  for (int q = 1; q < period; q++) {
+    qd_real t = mul_pwr2(zr * dr - zi * di, 2.0) + 1.0;
+    di = mul_pwr2(zr * di + zi * dr, 2.0);
+    dr = t;
+    qd_real xy = zr * zi;
+    zr = sqr(zr) - sqr(zi) + cr;
+    zi = mul_pwr2(xy, 2.0) + ci;
+    double z = std::hypot(to_double(zr), to_double(zi));
+    double d = std::hypot(to_double(dr), to_double(di));
+    if (z <= std::ldexp(d, -160)) {
+      nucleus.period = q;
+      break;
+    }
+    if (z < smallest) {
+      smallest = z;
+      nucleus.size = z / d;
+    }
+  }
+  return 0;
+}
+
+qd_mandel_orbit_cache::qd_mandel_orbit_cache(size_t memory_limit,
+                                             const char *spill_dir,
+                                             double reuse_radius)
+  : memory_limit(memory_limit), spill_dir(spill_dir ? spill_dir : ""),
+    reuse_radius(reuse_radius), clock(0), in_memory(0), files(0) {}
+
+qd_mandel_orbit_cache::~qd_mandel_orbit_cache() {
+  clear();
+}
+
+std::shared_ptr<const qd_mandel_orbit>
+qd_mandel_orbit_cache::get(const qd_mandel_view &v, double bailout,
+                           bool *hit) {
+  {
+    std::lock_guard<std::mutex> lock(m);
+    std::shared_ptr<const qd_mandel_orbit> orbit = find(v, bailout);
+    if (orbit) {
+      if (hit)
+        *hit = true;
+      return orbit;
+    }
+  }
+
+  /* Computed without the lock, so that other threads can use the
+     cache meanwhile.  One that added an orbit for v in the meantime
+     wins, and this one is dropped.                                 */
+  std::shared_ptr<qd_mandel_orbit> orbit(new qd_mandel_orbit);
+  orbit->compute(v.re, v.im, v.max_iter, bailout);
+  if (hit)
+    *hit = false;
+  std::lock_guard<std::mutex> lock(m);
+  std::shared_ptr<const qd_mandel_orbit> other = find(v, bailout);
+  return other ? other : insert(orbit);
+}
+
+std::shared_ptr<const qd_mandel_orbit>
+qd_mandel_orbit_cache::add(const qd_real &re, const qd_real &im,
+                           int max_iter, double bailout) {
+  std::shared_ptr<qd_mandel_orbit> orbit(new qd_mandel_orbit);
+  orbit->compute(re, im, max_iter, bailout);
+  std::lock_guard<std::mutex> lock(m);
+  return insert(orbit);
+}
+
+/* The closest orbit that serves v, or null if none does; m must be
+   held.                                                            */
+std::shared_ptr<const qd_mandel_orbit>
+qd_mandel_orbit_cache::find(const qd_mandel_view &v, double bailout) {
+  entry *best = 0;
+  double best_dist = 0.0;
+  for (size_t i = 0; i < entries.size(); i++) {
+    entry &e = entries[i];
+    bool covers = (e.length >= v.max_iter || e.length < e.max_iter);
+    if (e.bailout != bailout || !covers)
+      continue;
+    double d = std::hypot(to_double(e.re - v.re), to_double(e.im - v.im));
+    if (d <= reuse_radius * v.radius && (!best || d < best_dist)) {
+      best = &e;
+      best_dist = d;
+    }
+  }
+
+  if (best && (best->orbit || load(*best) == 0)) {
+    best->used = ++clock;
+    std::shared_ptr<const qd_mandel_orbit> orbit = best->orbit;
+    evict(best);
+    return orbit;
+  }
+  return std::shared_ptr<const qd_mandel_orbit>();
+}
+
+/* Adds a computed orbit; m must be held. */
+std::shared_ptr<const qd_mandel_orbit>
+qd_mandel_orbit_cache::insert(const std::shared_ptr<qd_mandel_orbit> &orbit) {
+  entry e;
+  e.re = orbit->re;
+  e.im = orbit->im;
+  e.max_iter = orbit->max_iter;
+  e.bailout = orbit->bailout;
+  e.length = orbit->size() - 1;
+  e.orbit = orbit;
+  e.used = ++clock;
+  entries.push_back(e);
+  in_memory += orbit->bytes();
+  evict(&entries.back());
+  return orbit;
+}
+
+/* Maps the file of e back into memory.  Returns 0 on success and -1
+   on failure, in which case e is removed.                           */
+int qd_mandel_orbit_cache::load(entry &e) {
+  qd_mapped_array file;
+  size_t n = static_cast<size_t>(e.length) + 1;
+  if (file.open(e.path.c_str()) != 0 || file.size() != 2 * n) {
+    remove(e);
+    return -1;
+  }
+
+  qd_mandel_orbit *orbit = new qd_mandel_orbit;
+  orbit->re = e.re;
+  orbit->im = e.im;
+  orbit->max_iter = e.max_iter;
+  orbit->bailout = e.bailout;
+  /* Real parts of Z are elements 0 to n-1, imaginary parts n to 2n-1. */
+  const double *hi = file.limb(0), *lo = file.limb(1);
+  std::vector<dd_real> a;
+  if (!hi || !lo) {
+    a.resize(2 * n);
+    file.load(&a[0]);
+  }
+  orbit->zr.resize(n);
+  orbit->zi.resize(n);
+  orbit->zr_lo.resize(n);
+  orbit->zi_lo.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    orbit->zr[i] = hi ? hi[i] : a[i].x[0];
+    orbit->zi[i] = hi ? hi[n + i] : a[n + i].x[0];
+    orbit->zr_lo[i] = lo ? lo[i] : a[i].x[1];
+    orbit->zi_lo[i] = lo ? lo[n + i] : a[n + i].x[1];
+  }
+  e.orbit.reset(orbit);
+  in_memory += orbit->bytes();
+  return 0;
+}
+
+/* Moves the least recently used orbits other than keep out of memory
+   until the rest fit in memory_limit.                              */
+void qd_mandel_orbit_cache::evict(const entry *keep) {
+  while (in_memory > memory_limit) {
+    entry *lru = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+      if (&entries[i] != keep && entries[i].orbit &&
+          (!lru || entries[i].used < lru->used))
+        lru = &entries[i];
+    if (!lru)
+      return;
+
+    const qd_mandel_orbit &orbit = *lru->orbit;
+    if (lru->path.empty() && !spill_dir.empty()) {
+      size_t n = orbit.zr.size();
+      std::vector<dd_real> a(2 * n);
+      for (size_t i = 0; i < n; i++) {
+        a[i] = dd_real(orbit.zr[i], orbit.zr_lo[i]);
+        a[n + i] = dd_real(orbit.zi[i], orbit.zi_lo[i]);
+      }
+      /* The process id keeps caches of different processes sharing
+         spill_dir apart. */
+      char name[96];
+      std::snprintf(name, sizeof(name), "/qd_orbit_%ld_%p_%u.qda",
+                    static_cast<long>(qd_getpid()),
+                    static_cast<void *>(this), files++);
+      lru->path = spill_dir + name;
+      if (qd_write_array(lru->path.c_str(), &a[0], a.size(),
+                         qd_array_soa) != 0) {
+        std::remove(lru->path.c_str());
+        lru->path.clear();
+      }
+    }
+
+    in_memory -= orbit.bytes();
+    lru->orbit.reset();
+    if (lru->path.empty()) {
+      /* Not kept on disk: forget it, keeping keep valid. */
+      size_t k = keep ? keep - &entries[0] : 0;
+      size_t i = lru - &entries[0];
+      entries.erase(entries.begin() + i);
+      if (keep && i < k)
+        keep = &entries[k - 1];
+    }
+  }
+}
+
+void qd_mandel_orbit_cache::remove(entry &e) {
+  if (e.orbit)
+    in_memory -= e.orbit->bytes();
+  if (!e.path.empty())
+    std::remove(e.path.c_str());
+  entries.erase(entries.begin() + (&e - &entries[0]));
+}
+
+void qd_mandel_orbit_cache::clear() {
+  std::lock_guard<std::mutex> lock(m);
+  for (size_t i = 0; i < entries.size(); i++)
+    if (!entries[i].path.empty())
+      std::remove(entries[i].path.c_str());
+  entries.clear();
+  in_memory = 0;
+}
+
+size_t qd_mandel_orbit_cache::size() const {
+  std::lock_guard<std::mutex> lock(m);
+  return entries.size();
+}
+
+size_t qd_mandel_orbit_cache::memory() const {
+  std::lock_guard<std::mutex> lock(m);
+  return in_memory;
+}
+
+size_t qd_mandel_orbit_cache::spilled() const {
+  std::lock_guard<std::mutex> lock(m);
+  size_t n = 0;
+  for (size_t i = 0; i < entries.size(); i++)
+    n += !entries[i].orbit;
+  return n;
+}
+
+qd_mandel_renderer::qd_mandel_renderer(const qd_mandel_options &opt,
+                                       const callback &on_pass)
+  : opt(opt), on_pass(on_pass), pool(make_pool(opt.nthreads)),
+    cancelled(false), passes_done(0), completed(false) {}
+
+qd_mandel_renderer::~qd_mandel_renderer() {
+  cancel();
+  wait();
+}
+
+int qd_mandel_renderer::start(const qd_mandel_view &v) {
+  if (!valid(v, opt)) {
+    errno = EINVAL;
+    return -1;
+  }
+  cancel();
+  wait();
+  cancelled = false;
+  {
+    std::lock_guard<std::mutex> lock(m);
+    view = v;
+    image.assign(static_cast<size_t>(v.width) * v.height,
+                 qd_mandel_interior);
+    passes_done = 0;
+    completed = false;
+  }
+  thread = std::thread(&qd_mandel_renderer::run, this);
+  return 0;
+}
+
+void qd_mandel_renderer::cancel() {
+  cancelled = true;
+}
+
+bool qd_mandel_renderer::wait() {
+  if (thread.joinable())
+    thread.join();
+  std::lock_guard<std::mutex> lock(m);
+  return completed;
+}
+
+int qd_mandel_renderer::snapshot(std::vector<float> &counts) const {
+  std::lock_guard<std::mutex> lock(m);
+  counts = image;
+  return passes_done;
+}
+
+qd_mandel_stats qd_mandel_renderer::stats() const {
+  std::lock_guard<std::mutex> lock(m);
+  return last_stats;
+}
+
+void qd_mandel_renderer::run() {
+  std::vector<float> counts;
+  qd_mandel_stats s;
+  bool done = render(*pool, view, opt, counts, 0, &s, &cancelled,
+                     [&](int pass) {
+                       {
+                         std::lock_guard<std::mutex> lock(m);
+                         image = counts;
+                         passes_done = pass;
+                       }
+                       if (on_pass)
+                         on_pass(pass);
+                     });
+  std::lock_guard<std::mutex> lock(m);
+  completed = done;
+  if (done)
+    last_stats = s;
+}
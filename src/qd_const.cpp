@@ -12,6 +12,9 @@
 #include "config.h"
 #include <qd/qd_real.h>
 
+/* With C++17 these are inline constexpr variables in qd_real.h;
+   see dd_const.cpp. */
+#if !QD_HAVE_CXX17
 /* Some useful constants. */
 const qd_real qd_real::_2pi = qd_real(6.283185307179586232e+00,
                                       2.449293598294706414e-16,
@@ -59,4 +62,12 @@ const qd_real qd_real::_safe_max = qd_real(
     1.7976931080746007281e+308,  9.97920154767359795037e+291, 
     5.53956966280111259858e+275, 3.07507889307840487279e+259);
 const int qd_real::_ndigits = 62;
+#else
+extern const void *const qd_qd_constants[] = {
+    &qd_real::_2pi, &qd_real::_pi, &qd_real::_pi2, &qd_real::_pi4,
+    &qd_real::_3pi4, &qd_real::_e, &qd_real::_log2, &qd_real::_log10,
+    &qd_real::_nan, &qd_real::_inf, &qd_real::_eps,
+    &qd_real::_min_normalized, &qd_real::_max, &qd_real::_safe_max,
+    &qd_real::_ndigits};
+#endif
 
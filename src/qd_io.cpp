@@ -0,0 +1,640 @@
+/*
+ * src/qd_io.cpp
+ *
+ * Bulk input and output of dd_real and qd_real arrays.  See
+ * include/qd/qd_io.h for the binary array file format.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include <qd/qd_io.h>
+#include <qd/metal_cpu.h>
+
+#ifdef _WIN32
+#define QD_HAVE_MMAP 0
+#else
+#define QD_HAVE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static const char qd_array_magic[8] = "QDARRAY";
+
+static uint32_t swap32(uint32_t x) {
+  return (x >> 24) | ((x >> 8) & 0xff00u) | ((x << 8) & 0xff0000u) | (x << 24);
+}
+
+static uint64_t swap64(uint64_t x) {
+  return (static_cast<uint64_t>(swap32(static_cast<uint32_t>(x))) << 32) |
+         swap32(static_cast<uint32_t>(x >> 32));
+}
+
+/* Writes n numbers of nlimbs doubles each.  The file is written under
+   a temporary name and renamed into place, so an existing file (for
+   example the previous checkpoint) is replaced only once the new one
+   is complete.                                                     */
+static int write_limbs(const char *path, const double *a, size_t n,
+                       int nlimbs, qd_array_layout layout) {
+  qd_array_header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, qd_array_magic, sizeof(h.magic));
+  h.version = qd_array_version;
+  h.endian = qd_array_endian_tag;
+  h.limb_size = sizeof(double);
+  h.limbs = nlimbs;
+  h.layout = layout;
+  h.count = n;
+  h.data_offset = sizeof(h);
+
+  std::string tmp = std::string(path) + ".tmp";
+  std::FILE *f = std::fopen(tmp.c_str(), "wb");
+  if (f == 0)
+    return -1;
+
+  bool ok = (std::fwrite(&h, sizeof(h), 1, f) == 1);
+  if (layout == qd_array_aos) {
+    ok = ok && (std::fwrite(a, sizeof(double) * nlimbs, n, f) == n);
+  } else {
+    /* Gather one limb at a time through a small buffer. */
+    const size_t block = 4096;
+    double buf[block];
+    for (int k = 0; ok && k < nlimbs; k++) {
+      for (size_t i = 0; ok && i < n; i += block) {
+        size_t m = std::min(block, n - i);
+        for (size_t j = 0; j < m; j++)
+          buf[j] = a[(i + j) * nlimbs + k];
+        ok = (std::fwrite(buf, sizeof(double), m, f) == m);
+      }
+    }
+  }
+
+  int err = errno;
+  if (std::fclose(f) != 0)
+    ok = false;
+  else
+    errno = err;
+
+  if (!ok || std::rename(tmp.c_str(), path) != 0) {
+    err = errno;
+    std::remove(tmp.c_str());
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
+int qd_write_array(const char *path, const dd_real *a, size_t n,
+                   qd_array_layout layout) {
+  return write_limbs(path, reinterpret_cast<const double *>(a), n, 2, layout);
+}
+
+int qd_write_array(const char *path, const qd_real *a, size_t n,
+                   qd_array_layout layout) {
+  return write_limbs(path, reinterpret_cast<const double *>(a), n, 4, layout);
+}
+
+qd_mapped_array::qd_mapped_array()
+  : base(0), length(0), swapped(false) {
+  std::memset(&hdr, 0, sizeof(hdr));
+}
+
+qd_mapped_array::~qd_mapped_array() {
+  close();
+}
+
+/* Maps the whole file path read-only.  An empty file gives base = 0
+   and length = 0.  Returns 0 on success and -1 on failure.        */
+static int map_file(const char *path, const char *&base, size_t &length) {
+  base = 0;
+  length = 0;
+
+#if QD_HAVE_MMAP
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  if (st.st_size == 0) {
+    ::close(fd);
+    return 0;
+  }
+
+  void *p = mmap(0, static_cast<size_t>(st.st_size), PROT_READ,
+                 MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED)
+    return -1;
+  base = static_cast<const char *>(p);
+  length = static_cast<size_t>(st.st_size);
+#else
+  std::FILE *f = std::fopen(path, "rb");
+  if (f == 0)
+    return -1;
+  std::fseek(f, 0, SEEK_END);
+  long len = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  if (len <= 0) {
+    std::fclose(f);
+    return (len == 0) ? 0 : -1;
+  }
+  char *p = static_cast<char *>(std::malloc(static_cast<size_t>(len)));
+  if (p == 0 || std::fread(p, 1, static_cast<size_t>(len), f) !=
+                static_cast<size_t>(len)) {
+    std::free(p);
+    std::fclose(f);
+    return -1;
+  }
+  std::fclose(f);
+  base = p;
+  length = static_cast<size_t>(len);
+#endif
+  return 0;
+}
+
+static void unmap_file(const char *base, size_t length) {
+  if (base == 0)
+    return;
+#if QD_HAVE_MMAP
+  munmap(const_cast<char *>(base), length);
+#else
+  std::free(const_cast<char *>(base));
+#endif
+}
+
+int qd_mapped_array::open(const char *path) {
+  close();
+
+  if (map_file(path, base, length) != 0)
+    return -1;
+  if (length < sizeof(qd_array_header)) {
+    close();
+    errno = EINVAL;
+    return -1;
+  }
+
+  /* Validate the header. */
+  std::memcpy(&hdr, base, sizeof(hdr));
+  swapped = (hdr.endian == swap32(qd_array_endian_tag));
+  if (swapped) {
+    hdr.version = swap32(hdr.version);
+    hdr.endian = swap32(hdr.endian);
+    hdr.limb_size = swap32(hdr.limb_size);
+    hdr.limbs = swap32(hdr.limbs);
+    hdr.layout = swap32(hdr.layout);
+    hdr.count = swap64(hdr.count);
+    hdr.data_offset = swap64(hdr.data_offset);
+  }
+
+  bool valid =
+    std::memcmp(hdr.magic, qd_array_magic, sizeof(hdr.magic)) == 0 &&
+    hdr.endian == qd_array_endian_tag &&
+    hdr.version == qd_array_version &&
+    (hdr.limb_size == sizeof(double) || hdr.limb_size == sizeof(float)) &&
+    hdr.limbs >= 1 && hdr.limbs <= 4 &&
+    (hdr.layout == qd_array_aos || hdr.layout == qd_array_soa) &&
+    hdr.data_offset >= sizeof(hdr) && hdr.data_offset <= length &&
+    hdr.data_offset % hdr.limb_size == 0 &&
+    hdr.count <= (length - hdr.data_offset) / (hdr.limb_size * hdr.limbs);
+
+  if (!valid) {
+    close();
+    errno = EINVAL;
+    return -1;
+  }
+  return 0;
+}
+
+void qd_mapped_array::close() {
+  unmap_file(base, length);
+  base = 0;
+  length = 0;
+  swapped = false;
+  std::memset(&hdr, 0, sizeof(hdr));
+}
+
+bool qd_mapped_array::native() const {
+  return base != 0 && !swapped && hdr.limb_size == sizeof(double);
+}
+
+const dd_real *qd_mapped_array::dd_data() const {
+  if (!native() || hdr.limbs != 2 || hdr.layout != qd_array_aos)
+    return 0;
+  return reinterpret_cast<const dd_real *>(base + hdr.data_offset);
+}
+
+const qd_real *qd_mapped_array::qd_data() const {
+  if (!native() || hdr.limbs != 4 || hdr.layout != qd_array_aos)
+    return 0;
+  return reinterpret_cast<const qd_real *>(base + hdr.data_offset);
+}
+
+const double *qd_mapped_array::limb(int k) const {
+  if (!native() || hdr.layout != qd_array_soa || k < 0 ||
+      k >= static_cast<int>(hdr.limbs))
+    return 0;
+  return reinterpret_cast<const double *>(base + hdr.data_offset) +
+         static_cast<size_t>(k) * hdr.count;
+}
+
+int qd_mapped_array::load_limbs(double *a, int nlimbs) const {
+  if (base == 0)
+    return -1;
+
+  const char *data = base + hdr.data_offset;
+  size_t n = static_cast<size_t>(hdr.count);
+  int L = static_cast<int>(hdr.limbs);
+  size_t ls = hdr.limb_size;
+
+  if (native() && hdr.layout == qd_array_aos && L == nlimbs) {
+    std::memcpy(a, data, n * nlimbs * sizeof(double));
+    return 0;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    for (int k = 0; k < nlimbs; k++) {
+      double v = 0.0;
+      if (k < L) {
+        size_t j = (hdr.layout == qd_array_aos) ? i * L + k : k * n + i;
+        if (ls == sizeof(double)) {
+          uint64_t u;
+          std::memcpy(&u, data + j * ls, sizeof(u));
+          if (swapped) u = swap64(u);
+          std::memcpy(&v, &u, sizeof(v));
+        } else {
+          uint32_t u;
+          float f;
+          std::memcpy(&u, data + j * ls, sizeof(u));
+          if (swapped) u = swap32(u);
+          std::memcpy(&f, &u, sizeof(f));
+          v = f;
+        }
+      }
+      a[i * nlimbs + k] = v;
+    }
+  }
+  return 0;
+}
+
+int qd_mapped_array::load(dd_real *a) const {
+  return load_limbs(reinterpret_cast<double *>(a), 2);
+}
+
+int qd_mapped_array::load(qd_real *a) const {
+  return load_limbs(reinterpret_cast<double *>(a), 4);
+}
+
+static inline bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' ||
+         c == '\v' || c == '\f';
+}
+
+/* Parses the token [p, p + n) as a complete number. */
+template <class T>
+static bool parse_token(const char *p, size_t n, T &a) {
+#if QD_HAVE_CXX17
+  return T::parse(std::string_view(p, n), a) == p + n;
+#else
+  char buf[256];
+  if (n >= sizeof(buf))
+    return false;
+  std::memcpy(buf, p, n);
+  buf[n] = '\0';
+  return a.read(buf, a) == 0;
+#endif
+}
+
+/* A piece of the text ending at whitespace, so that no token is
+   split between pieces. */
+struct text_piece {
+  const char *begin, *end;
+  size_t ntokens;  /* tokens in the piece */
+  size_t nlines;   /* newlines in the piece */
+  size_t index;    /* array index of the first token */
+  size_t line;     /* line number of begin */
+  std::vector<qd_text_error> errors;
+};
+
+static void count_tokens(text_piece &t) {
+  size_t tokens = 0, lines = 0;
+  bool in_token = false;
+  for (const char *p = t.begin; p != t.end; ++p) {
+    char c = *p;
+    if (is_space(c)) {
+      lines += (c == '\n');
+      in_token = false;
+    } else {
+      tokens += !in_token;
+      in_token = true;
+    }
+  }
+  t.ntokens = tokens;
+  t.nlines = lines;
+}
+
+template <class T>
+static void parse_tokens(text_piece &t, const char *text, T *a) {
+  size_t i = t.index, line = t.line;
+  const char *p = t.begin;
+  while (p != t.end) {
+    if (is_space(*p)) {
+      line += (*p == '\n');
+      ++p;
+      continue;
+    }
+    const char *q = p;
+    while (q != t.end && !is_space(*q))
+      ++q;
+    if (!parse_token(p, static_cast<size_t>(q - p), a[i])) {
+      const char *s = p;
+      while (s != text && s[-1] != '\n')
+        --s;
+      qd_text_error e;
+      e.index = i;
+      e.line = line;
+      e.column = static_cast<size_t>(p - s) + 1;
+      t.errors.push_back(e);
+      a[i] = T::_nan;
+    }
+    ++i;
+    p = q;
+  }
+}
+
+/* Runs f(k) for k = 0, ..., n-1, each on its own thread. */
+template <class F>
+static void parallel_for(size_t n, F f) {
+  std::vector<std::thread> threads;
+  size_t k = 1;
+  try {
+    for (; k < n; k++)
+      threads.push_back(std::thread(f, k));
+  } catch (const std::system_error &) {
+    /* Could not start a thread; do the rest here. */
+    for (size_t j = k; j < n; j++)
+      f(j);
+  }
+  if (n > 0)
+    f(0);
+  for (size_t j = 0; j < threads.size(); j++)
+    threads[j].join();
+}
+
+template <class T>
+static int parse_text(const char *s, size_t len, std::vector<T> &a,
+                      std::vector<qd_text_error> *errors, int nthreads) {
+  /* Give each thread at least 64 KiB. */
+  const size_t min_piece = 65536;
+  if (nthreads <= 0)
+    nthreads = static_cast<int>(std::thread::hardware_concurrency());
+  size_t npieces = std::max<size_t>(1, std::min<size_t>(
+      static_cast<size_t>(std::max(nthreads, 1)), len / min_piece));
+
+  std::vector<text_piece> pieces;
+  const char *p = s, *end = s + len;
+  for (size_t k = 0; k < npieces && p != end; k++) {
+    const char *q = (k == npieces - 1) ? end : s + len / npieces * (k + 1);
+    if (q < p)
+      q = p;
+    while (q != end && !is_space(*q))
+      ++q;
+    text_piece t = text_piece();
+    t.begin = p;
+    t.end = q;
+    pieces.push_back(t);
+    p = q;
+  }
+  if (pieces.empty()) {
+    a.clear();
+    return 0;
+  }
+
+  parallel_for(pieces.size(), [&pieces](size_t k) {
+    count_tokens(pieces[k]);
+  });
+
+  size_t n = 0, line = 1;
+  for (size_t k = 0; k < pieces.size(); k++) {
+    pieces[k].index = n;
+    pieces[k].line = line;
+    n += pieces[k].ntokens;
+    line += pieces[k].nlines;
+  }
+
+  a.resize(n);
+  if (n == 0)
+    return 0;
+  T *data = &a[0];
+  parallel_for(pieces.size(), [&pieces, s, data](size_t k) {
+    parse_tokens(pieces[k], s, data);
+  });
+
+  bool ok = true;
+  for (size_t k = 0; k < pieces.size(); k++) {
+    if (!pieces[k].errors.empty()) {
+      ok = false;
+      if (errors)
+        errors->insert(errors->end(), pieces[k].errors.begin(),
+                       pieces[k].errors.end());
+    }
+  }
+  if (!ok) {
+    errno = EINVAL;
+    return -1;
+  }
+  return 0;
+}
+
+template <class T>
+static int read_text(const char *path, std::vector<T> &a,
+                     std::vector<qd_text_error> *errors, int nthreads) {
+  const char *base;
+  size_t length;
+  if (map_file(path, base, length) != 0)
+    return -1;
+  int r = parse_text(base, length, a, errors, nthreads);
+  int err = errno;
+  unmap_file(base, length);
+  errno = err;
+  return r;
+}
+
+int qd_parse_text(const char *s, size_t len, std::vector<dd_real> &a,
+                  std::vector<qd_text_error> *errors, int nthreads) {
+  return parse_text(s, len, a, errors, nthreads);
+}
+
+int qd_parse_text(const char *s, size_t len, std::vector<qd_real> &a,
+                  std::vector<qd_text_error> *errors, int nthreads) {
+  return parse_text(s, len, a, errors, nthreads);
+}
+
+int qd_read_text(const char *path, std::vector<dd_real> &a,
+                 std::vector<qd_text_error> *errors, int nthreads) {
+  return read_text(path, a, errors, nthreads);
+}
+
+int qd_read_text(const char *path, std::vector<qd_real> &a,
+                 std::vector<qd_text_error> *errors, int nthreads) {
+  return read_text(path, a, errors, nthreads);
+}
+
+/* Formats a into buf, which has room for cap characters, and returns
+   the number of characters written, or 0 if they do not fit. */
+template <class T>
+static size_t format_number(char *buf, size_t cap, const T &a,
+                            const qd_text_format &f) {
+#if QD_HAVE_CXX17
+  std::chars_format fmt;
+  switch (f.notation) {
+    case qd_text_scientific: fmt = std::chars_format::scientific; break;
+    case qd_text_fixed:      fmt = std::chars_format::fixed; break;
+    case qd_text_general:    fmt = std::chars_format::general; break;
+    default:
+      if (f.precision < 0) {
+        std::to_chars_result r = to_chars(buf, buf + cap, a);
+        return (r.ec == std::errc()) ? static_cast<size_t>(r.ptr - buf) : 0;
+      }
+      fmt = std::chars_format::scientific;
+      break;
+  }
+  std::to_chars_result r = (f.precision < 0) ?
+    to_chars(buf, buf + cap, a, fmt) :
+    to_chars(buf, buf + cap, a, fmt, f.precision);
+  return (r.ec == std::errc()) ? static_cast<size_t>(r.ptr - buf) : 0;
+#else
+  int precision = (f.precision < 0) ? T::_ndigits : f.precision;
+  std::ios_base::fmtflags fmt = (f.notation == qd_text_fixed) ?
+    std::ios_base::fixed : std::ios_base::scientific;
+  std::string s = a.to_string(precision, 0, fmt);
+  if (s.size() > cap)
+    return 0;
+  std::memcpy(buf, s.data(), s.size());
+  return s.size();
+#endif
+}
+
+/* Formats rows [i0, i1) of the ncols columns into out. */
+template <class T>
+static void format_rows(const T *const *columns, size_t ncols,
+                        size_t i0, size_t i1, const qd_text_format &f,
+                        std::vector<char> &out) {
+  /* Room for one number: digits, sign, point and exponent, or up
+     to 310 digits before the point in fixed notation; doubled if a
+     number does not fit all the same. */
+  size_t cap = 400 + static_cast<size_t>(std::max(f.precision, 0));
+  out.clear();
+  for (size_t i = i0; i < i1; i++) {
+    for (size_t j = 0; j < ncols; j++) {
+      size_t m = out.size(), k;
+      for (;;) {
+        out.resize(m + cap + 1);
+        if ((k = format_number(&out[m], cap, columns[j][i], f)) > 0)
+          break;
+        cap *= 2;
+      }
+      m += k;
+      out[m++] = (j + 1 < ncols) ? f.separator : '\n';
+      out.resize(m);
+    }
+  }
+}
+
+template <class T>
+static int write_text(std::FILE *file, const T *const *columns, size_t ncols,
+                      size_t n, const qd_text_format &f) {
+  /* Rows formatted by each thread before the buffers are written. */
+  const size_t block = 4096;
+  size_t nthreads = (f.nthreads > 0) ? f.nthreads :
+                    std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::vector<char> > bufs(nthreads);
+
+  if (ncols == 0)
+    return 0;
+
+  /* One set of threads for all the batches, no more than there are
+     blocks; the calling thread alone if none can be started.       */
+  unsigned npool = static_cast<unsigned>(
+      std::min(nthreads, std::max<size_t>((n + block - 1) / block, 1)));
+  std::unique_ptr<qd_cpu::thread_pool> pool;
+  try {
+    pool.reset(new qd_cpu::thread_pool(npool));
+  } catch (const std::system_error &) {
+    pool.reset(new qd_cpu::thread_pool(1));
+  }
+
+  for (size_t i = 0; i < n; i += nthreads * block) {
+    size_t m = std::min(nthreads * block, n - i);
+    size_t npieces = (m + block - 1) / block;
+    pool->parallel_for(npieces, [&, i](size_t k) {
+      size_t i0 = i + k * block;
+      format_rows(columns, ncols, i0, std::min(i0 + block, i + m), f,
+                  bufs[k]);
+    });
+
+    for (size_t k = 0; k < npieces; k++) {
+      if (!bufs[k].empty() &&
+          std::fwrite(&bufs[k][0], 1, bufs[k].size(), file) != bufs[k].size())
+        return -1;
+    }
+  }
+  return 0;
+}
+
+template <class T>
+static int write_text(const char *path, const T *const *columns,
+                      size_t ncols, size_t n, const qd_text_format &f) {
+  std::FILE *file = std::fopen(path, "w");
+  if (file == 0)
+    return -1;
+  int r = write_text(file, columns, ncols, n, f);
+  int err = errno;
+  if (std::fclose(file) != 0)
+    return -1;
+  errno = err;
+  return r;
+}
+
+int qd_write_text(const char *path, const dd_real *a, size_t n,
+                  const qd_text_format &f) {
+  return write_text(path, &a, 1, n, f);
+}
+
+int qd_write_text(const char *path, const qd_real *a, size_t n,
+                  const qd_text_format &f) {
+  return write_text(path, &a, 1, n, f);
+}
+
+int qd_write_text(const char *path, const dd_real *const *columns,
+                  size_t ncols, size_t n, const qd_text_format &f) {
+  return write_text(path, columns, ncols, n, f);
+}
+
+int qd_write_text(const char *path, const qd_real *const *columns,
+                  size_t ncols, size_t n, const qd_text_format &f) {
+  return write_text(path, columns, ncols, n, f);
+}
+
+int qd_write_text(std::FILE *file, const dd_real *const *columns,
+                  size_t ncols, size_t n, const qd_text_format &f) {
+  return write_text(file, columns, ncols, n, f);
+}
+
+int qd_write_text(std::FILE *file, const qd_real *const *columns,
+                  size_t ncols, size_t n, const qd_text_format &f) {
+  return write_text(file, columns, ncols, n, f);
+}
@@ -195,104 +195,110 @@ ostream &operator<<(ostream &os, const qd_real &qd) {
       showpos, uppercase, os.fill());
 }
 
-/* Read a quad-double from s. */
-int qd_real::read(const char *s, qd_real &qd) {
-  const char *p = s;
-  char ch;
-  int sign = 0;
-  int point = -1;  /* location of decimal point */
-  int nd = 0;      /* number of digits read */
-  int e = 0;       /* exponent. */
-  bool done = false;
-  qd_real r = 0.0;  /* number being read */
-
-  /* Skip any leading spaces */
-  while (*p == ' ') p++;
-
-  while (!done && (ch = *p) != '\0') {
-    if (ch >= '0' && ch <= '9') {
-      /* It's a digit */
-      int d = ch - '0';
-      r *= 10.0;
-      r += static_cast<double>(d);
-      nd++;
-    } else {
-      /* Non-digit */
-      switch (ch) {
-      case '.':
-        if (point >= 0)
-          return -1;   /* we've already encountered a decimal point. */
-        point = nd;
-        break;
-      case '-':
-      case '+':
-        if (sign != 0 || nd > 0)
-          return -1;  /* we've already encountered a sign, or if its
-                            not at first position. */
-        sign = (ch == '-') ? -1 : 1;
-        break;
-      case 'E':
-      case 'e':
-        int nread;
-        nread = std::sscanf(p+1, "%d", &e);
-        done = true;
-        if (nread != 1)
-          return -1;  /* read of exponent failed. */
-        break;
-      case ' ':
-        done = true;
-        break;
-      default:
-        return -1;
-      
-      }
-    }
+/* Converts the digits gathered by scan_decimal to a quad-double.
+   Chunks are combined with multiplications by 10^19, which is exact
+   in double precision, and the result is scaled once by 10^expn.  */
+static qd_real from_chunks(const decimal_chunks &d) {
+  qd_real r = 0.0;
 
-    p++;
+  for (int i = 0; i < d.nchunks; i++) {
+    uint64_t c = d.chunk[i];
+    r *= (i == d.nchunks - 1) ? d.last_scale : 1e19;
+    r += static_cast<double>(c >> 32) * 4294967296.0;
+    r += static_cast<double>(c & 0xffffffffu);
   }
 
+  /* Dividing by an exact power of ten keeps short decimal
+     fractions such as 0.1 correctly rounded. */
+  if (d.expn < 0 && d.expn >= -22)
+    r /= exact_pwr10[-d.expn];
+  else if (d.expn != 0)
+    r = mul_pwr10(r, d.expn);
 
+  return d.negative ? -r : r;
+}
 
-  /* Adjust exponent to account for decimal point */
-  if (point >= 0) {
-    e -= (nd - point);
+/* Scans a decimal or hexadecimal number from [p, end) into a.  The
+   limbs of a hexadecimal number with exactly 4 limbs are taken as
+   they are, so that written numbers read back bit for bit; other
+   counts are summed.  Returns a pointer past the number, or 0.    */
+static const char *scan_number(const char *p, const char *end, qd_real &a) {
+  double x[4];
+  int n;
+  const char *q = scan_hex(p, end, x, 4, n);
+  if (q != 0) {
+    if (n == 4) {
+      a = qd_real(x[0], x[1], x[2], x[3]);
+    } else {
+      a = x[0];
+      for (int i = 1; i < n; i++)
+        a += x[i];
+    }
+    return q;
   }
 
-  /* Multiply the the exponent */
-  if (e != 0) {
-    r *= (qd_real(10.0) ^ e);
-  }
+  decimal_chunks d;
+  q = scan_decimal(p, end, d, decimal_chunks::max_chunks);
+  if (q != 0)
+    a = from_chunks(d);
+  return q;
+}
 
-  qd = (sign < 0) ? -r : r;
+/* Read a quad-double from s. */
+int qd_real::read(const char *s, qd_real &qd) {
+  qd_real r;
+  const char *p = scan_number(s, s + std::strlen(s), r);
+
+  /* The number may be followed by a space and anything after it, and
+     text after an exponent is ignored, as it was by QD 2.3. */
+  if (p == 0 || (*p != '\0' && *p != ' ' && !ends_with_exponent(s, p)))
+    return -1;
+
+  qd = r;
   return 0;
 }
 
-void qd_real::to_digits(char *s, int &expn, int precision) const {
-  int D = precision + 1;  /* number of digits to compute */
+#if QD_HAVE_CXX17
+/* Parses a quad-double from the beginning of s, after any leading
+   spaces.  Returns a pointer past the last character used, or null
+   if s does not begin with a number, in which case a is unchanged. */
+const char *qd_real::parse(std::string_view s, qd_real &a) {
+  return scan_number(s.data(), s.data() + s.size(), a);
+}
 
-  qd_real r = abs(*this);
-  int e;  /* exponent */
-  int i, d;
+std::to_chars_result to_chars(char *first, char *last, const qd_real &a) {
+  return to_chars_decimal(first, last, a, 0, -1);
+}
 
-  if (x[0] == 0.0) {
-    /* this == 0.0 */
-    expn = 0;
-    for (i = 0; i < precision; i++) s[i] = '0';
-    return;
-  }
+std::to_chars_result to_chars(char *first, char *last, const qd_real &a,
+                              std::chars_format fmt) {
+  return to_chars_decimal(first, last, a, static_cast<int>(fmt), -1);
+}
+
+std::to_chars_result to_chars(char *first, char *last, const qd_real &a,
+                              std::chars_format fmt, int precision) {
+  return to_chars_decimal(first, last, a, static_cast<int>(fmt), 
+                          std::max(precision, 0));
+}
+#endif
+
+int decimal_digits(const qd_real &a, char *s, int &expn) {
+  qd_real r = abs(a);
+  int e;  /* exponent */
+  uint64_t b[4];
+  int i, k;
 
   /* First determine the (approximate) exponent. */
-  e = static_cast<int>(std::floor(std::log10(std::abs(x[0]))));
-
-  if (e < -300) {
-    r *= qd_real(10.0) ^ 300;
-    r /= qd_real(10.0) ^ (e + 300);
-  } else if (e > 300) {
-    r = ldexp(r, -53);
-    r /= qd_real(10.0) ^ e;
-    r = ldexp(r, 53);
+  e = static_cast<int>(std::floor(std::log10(std::abs(a[0]))));
+
+  /* Exact powers of ten keep the digits of integers and short
+     decimal fractions exact. */
+  if (e >= 0 && e <= 22) {
+    r /= exact_pwr10[e];
+  } else if (e < 0 && e >= -22) {
+    r *= exact_pwr10[-e];
   } else {
-    r /= qd_real(10.0) ^ e;
+    r = mul_pwr10(r, -e);
   }
 
   /* Fix exponent if we are off by one */
@@ -306,55 +312,61 @@ void qd_real::to_digits(char *s, int &expn, int precision) const {
 
   if (r >= 10.0 || r < 1.0) {
     qd_real::error("(qd_real::to_digits): can't compute exponent.");
-    return;
+    return 0;
+  }
+
+  /* Extract the digits 19 at a time.  The limbs of floor(r) are
+     integers, so their sum is exact in 64-bit arithmetic.      */
+  r *= 1e18;
+  for (i = 0; i < 4; i++) {
+    qd_real t = floor(r);
+    b[i] = static_cast<uint64_t>(t[0]) + static_cast<uint64_t>(
+        static_cast<int64_t>(t[1]) + static_cast<int64_t>(t[2]) + 
+        static_cast<int64_t>(t[3]));
+    r = (r - t) * 1e19;
+  }
+
+  /* Propagate any carries from rounding errors in the products. */
+  const uint64_t ten19 = 10000000000000000000ULL;
+  for (i = 3; i > 0; i--) {
+    if (b[i] >= ten19) {
+      b[i] -= ten19;
+      b[i-1]++;
+    }
   }
-
-  /* Extract the digits */
-  for (i = 0; i < D; i++) {
-    d = static_cast<int>(r[0]);
-    r -= d;
-    r *= 10.0;
-
-    s[i] = static_cast<char>(d + '0');
+  if (b[0] >= ten19) {
+    b[0] = ten19 / 10;
+    b[1] = b[2] = b[3] = 0;
+    e++;
   }
 
-  /* Fix out of range digits. */
-  for (i = D-1; i > 0; i--) {
-    if (s[i] < '0') {
-      s[i-1]--;
-      s[i] += 10;
-    } else if (s[i] > '9') {
-      s[i-1]++;
-      s[i] -= 10;
+  for (i = 0; i < 4; i++) {
+    for (k = 18; k >= 0; k--) {
+      s[19*i + k] = static_cast<char>('0' + b[i] % 10);
+      b[i] /= 10;
     }
   }
 
-  if (s[0] <= '0') {
-    qd_real::error("(qd_real::to_digits): non-positive leading digit.");
-    return;
-  }
-
-  /* Round, handle carry */
-  if (s[D-1] >= '5') {
-    s[D-2]++;
+  expn = e;
+  return 76;
+}
 
-    i = D-2;
-    while (i > 0 && s[i] > '9') {
-      s[i] -= 10;
-      s[--i]++;
-    }
-  }
+void qd_real::to_digits(char *s, int &expn, int precision) const {
+  char t[max_decimal_digits];
+  int i, n;
 
-  /* If first digit is 10, shift everything. */
-  if (s[0] > '9') { 
-    e++; 
-    for (i = precision; i >= 2; i--) s[i] = s[i-1]; 
-    s[0] = '1';
-    s[1] = '0';
+  if (x[0] == 0.0) {
+    /* this == 0.0 */
+    expn = 0;
+    for (i = 0; i < precision; i++) s[i] = '0';
+    return;
   }
 
+  n = decimal_digits(*this, t, expn);
+  n = round_digits(t, n, precision, expn);
+  for (i = 0; i < precision; i++)
+    s[i] = (i < n) ? t[i] : '0';
   s[precision] = 0;
-  expn = e;
 }
 
 /* Writes the quad-double number into the character array s of length len.
@@ -421,6 +433,15 @@ string qd_real::to_string(int precision, int width, ios_base::fmtflags fmt,
   } else if (isnan()) {
     s = uppercase ? "NAN" : "nan";
     sgn = false;
+  } else if ((fmt & ios_base::floatfield) ==
+             (ios_base::fixed | ios_base::scientific) && !isinf()) {
+    /* std::hexfloat: exact hexadecimal limbs. */
+    char t[max_hex_chars];
+    char *p = write_hex(t, t + sizeof(t), x, 4, uppercase);
+    sgn = std::signbit(x[0]) || showpos;
+    if (showpos && !std::signbit(x[0]))
+      s += '+';
+    s.append(t, p - t);
   } else {
     if (*this < 0.0)
       s += '-';
@@ -438,7 +459,15 @@ string qd_real::to_string(int precision, int width, ios_base::fmtflags fmt,
       }
     } else {
       /* Non-zero case */
-      int off = (fixed ? (1 + to_int(floor(log10(abs(*this))))) : 1);
+      /* In fixed notation the digits start at the decimal exponent,
+         taken from the digits themselves: log10 of an exact power of
+         ten may round below the integer.                          */
+      int off = 1;
+      if (fixed) {
+        char digits[max_decimal_digits];
+        if (decimal_digits(*this, digits, off) > 0)
+          off++;
+      }
       int d = precision + off;
 
       int d_with_extra = d;
@@ -598,7 +627,72 @@ qd_real pow(const qd_real &a, int n) {
 }
 
 qd_real pow(const qd_real &a, const qd_real &b) {
-  return exp(b * log(a));
+  /* Strategy.  Small integer and half-integer exponents are
+     handled by binary exponentiation (and a square root), which
+     is both faster and more accurate than going through log.
+     Otherwise write a = 2^e * f with sqrt(1/2) <= f < sqrt(2), so
+     that
+
+        a^b = 2^(b*e) * f^b = 2^m * exp(r),
+
+     where m is an integer and |r| <= log(2)/2.  The integer part
+     of b*e never passes through log or exp, so only log(f) needs
+     to be computed, and exp is called on an already reduced
+     argument.                                                   */
+
+  const double max_fast_pwr = 32.0;
+
+  if (b[1] == 0.0 && std::abs(b[0]) <= max_fast_pwr) {
+    double b2 = 2.0 * b[0];
+    if (b2 == std::floor(b2)) {
+      if (b2 == 2.0 * std::floor(b[0]))
+        return pow(a, static_cast<int>(b[0]));
+      if (a[0] > 0.0)
+        return pow(a, static_cast<int>(std::floor(b[0]))) * sqrt(a);
+    }
+  }
+
+  if (a.isnan() || b.isnan())
+    return qd_real::_nan;
+
+  /* Infinite arguments give the limits that std::pow gives. */
+  if (b.isinf()) {
+    qd_real c = abs(a) - 1.0;
+    if (c.is_zero())
+      return 1.0;
+    return ((c[0] > 0.0) == (b[0] > 0.0)) ? qd_real::_inf : qd_real(0.0);
+  }
+  if (a.isinf() && a[0] > 0.0)
+    return (b[0] > 0.0) ? qd_real::_inf : qd_real(0.0);
+
+  if (a[0] <= 0.0) {
+    if (a.is_zero() && b[0] > 0.0)
+      return 0.0;
+    qd_real::error("(qd_real::pow): Non-positive argument.");
+    return qd_real::_nan;
+  }
+
+  int e;
+  if (std::frexp(a[0], &e) < 0.7071067811865476)
+    e--;
+  qd_real f = ldexp(a, -e);
+
+  qd_real t = b * static_cast<double>(e);
+  double m = nint(t[0]);
+  qd_real y = (t - m) * qd_real::_log2 + b * log(f);
+  double m2 = nint(y[0] / qd_real::_log2[0]);
+  m += m2;
+
+  if (m > 1024.0)
+    return qd_real::_inf;
+  if (m < -1100.0)
+    return 0.0;
+
+  return ldexp(exp(y - qd_real::_log2 * m2), static_cast<int>(m));
+}
+
+qd_real pow(const qd_real &a, double b) {
+  return pow(a, qd_real(b));
 }
 
 qd_real npwr(const qd_real &a, int n) {
@@ -779,8 +873,15 @@ qd_real nroot(const qd_real &a, int n) {
 
         x' = x + x * (1 - a * x^n) / n
 
-     Since Newton's iteration converges quadratically, 
-     we only need to perform it twice.
+     Newton's iteration doubles the number of correct bits, so
+     the double precision approximation is first refined with
+     one step in double-double arithmetic.  The final step is
+     done in quad-double with the second order correction term
+
+        x' = x + x * (h / n + (n+1)/(2n^2) * h^2),  h = 1 - a * x^n,
+
+     which triples the number of correct bits.  Since h^2 is
+     only about 2^-208 it is computed in double precision.
 
    */
 	if (n <= 0) {
@@ -810,17 +911,21 @@ qd_real nroot(const qd_real &a, int n) {
 
 	/* Perform Newton's iteration. */
 	double dbl_n = static_cast<double>(n);
-	x += x * (1.0 - r * npwr(x, n)) / dbl_n;
-	x += x * (1.0 - r * npwr(x, n)) / dbl_n;
-	x += x * (1.0 - r * npwr(x, n)) / dbl_n;
+	dd_real xx = x[0];
+	xx += xx * (1.0 - dd_real(r[0], r[1]) * npwr(xx, n)) / dbl_n;
+	x = xx;
+
+	qd_real h = 1.0 - r * npwr(x, n);
+	double h0 = h[0];
+	x += x * (h / dbl_n + (dbl_n + 1.0) / (2.0 * dbl_n * dbl_n) * h0 * h0);
 	if (a[0] < 0.0){
 		x = -x;
 	}
 	return 1.0 / x;
 }
 
-static const int n_inv_fact = 15;
-static const qd_real inv_fact[n_inv_fact] = {
+static constexpr int n_inv_fact = 62;  /* 1/3!, ..., 1/64! */
+static constexpr qd_real inv_fact[n_inv_fact] = {
   qd_real( 1.66666666666666657e-01,  9.25185853854297066e-18,
            5.13581318503262866e-34,  2.85094902409834186e-50),
   qd_real( 4.16666666666666644e-02,  2.31296463463574266e-18,
@@ -850,10 +955,192 @@ static const qd_real inv_fact[n_inv_fact] = {
   qd_real( 4.77947733238738525e-14,  4.39920548583408126e-31,
           -4.89221204822661465e-49,  1.20086655902368901e-65),
   qd_real( 2.81145725434552060e-15,  1.65088427308614326e-31,
-          -2.87777179307447918e-50,  4.27110689256293549e-67)
+          -2.87777179307447918e-50,  4.27110689256293549e-67),
+  qd_real( 1.56192069685862253e-16,  1.19106796602737540e-32,
+          -4.57750605962998323e-49,  2.87494142340899603e-67),
+  qd_real( 8.22063524662432950e-18,  2.21418941196042654e-34,
+          -1.50891402377419897e-50,  1.40072951514781548e-67),
+  qd_real( 4.11031762331216484e-19,  1.44129733786595271e-36,
+          -5.28562754878981208e-53, -4.14764725635765685e-70),
+  qd_real( 1.95729410633912626e-20, -1.36435038300879085e-36,
+           1.33923482511250642e-53, -6.82108942414933122e-70),
+  qd_real( 8.89679139245057408e-22, -7.91140261487237622e-38,
+          -3.18779767905709333e-54,  1.27057810175205662e-70),
+  qd_real( 3.86817017063068413e-23, -8.84317765548234385e-40,
+           3.87181571061732467e-56, -1.95652575315225570e-72),
+  qd_real( 1.61173757109611839e-24, -3.68465735645097660e-41,
+           1.61325654609055195e-57, -8.15219063813439928e-74),
+  qd_real( 6.44695028438447359e-26, -1.93304042337034648e-42,
+          -1.52130238070391442e-58,  6.64377273721295753e-75),
+  qd_real( 2.47959626322479759e-27, -1.29537309647652288e-43,
+           6.40339015984996241e-60, -8.46024562770674585e-77),
+  qd_real( 9.18368986379554601e-29,  1.43031503967873220e-45,
+          -8.55122677465050480e-62,  8.38146710023453832e-78),
+  qd_real( 3.27988923706983776e-30,  1.51175427440298787e-46,
+           8.05851771951971593e-63, -9.09648053071092885e-81),
+  qd_real( 1.13099628864477159e-31,  1.04980154129595060e-47,
+          -4.34615092939779518e-64, -4.96677980014005581e-81),
+  qd_real( 3.76998762881590539e-33,  2.58703478327503238e-49,
+           3.23789002742563999e-66,  2.56128591057885727e-82),
+  qd_real( 1.21612504155351789e-34,  5.58629056788880577e-51,
+           6.61594857808279193e-68, -3.16204422895208591e-84),
+  qd_real( 3.80039075485474342e-36,  1.74571580246525180e-52,
+           2.06748393065087248e-69, -9.88138821547526846e-86),
+  qd_real( 1.15163356207719509e-37, -6.09957445788453978e-54,
+          -5.34474961965941048e-70,  2.62531262385000815e-86),
+  qd_real( 3.38715753552116180e-39,  5.09056148151084995e-56,
+           3.98956734903634403e-72, -1.14951294479092623e-88),
+  qd_real( 9.67759295863189067e-41,  3.20229554864556196e-57,
+           6.54750720501810104e-74, -5.91334284153607619e-91),
+  qd_real( 2.68822026628663633e-42,  5.35506116594333401e-59,
+          -1.12906019874498676e-75, -7.09714352853527274e-92),
+  qd_real( 7.26546017915307136e-44, -4.36409714935444569e-61,
+           2.55032501210183748e-77,  3.62259693228430960e-94),
+  qd_real( 1.91196320504028195e-45, -2.78608221768831261e-62,
+           2.03474372241013280e-78, -9.13939362246162657e-95),
+  qd_real( 4.90246975651354352e-47, -1.21301910051792795e-63,
+          -4.47071800113765855e-80,  5.37597340717858998e-97),
+  qd_real( 1.22561743912838585e-48,  6.03392734831560539e-68,
+           4.07624961245823730e-84, -1.59820353307989972e-102),
+  qd_real( 2.98931082714240461e-50, -1.04072477030331555e-66,
+          -1.37613197137759057e-83, -5.01838323088147032e-100),
+  qd_real( 7.11740673129143899e-52,  3.17420753842055730e-68,
+           1.24112898646225877e-84, -1.09918879326293741e-100),
+  qd_real( 1.65521086774219515e-53,  4.14710519049482419e-70,
+           4.32187417758181306e-88,  1.61954498080637494e-104),
+  qd_real( 3.76184288123226157e-55,  2.25971359112361835e-71,
+          -1.45255187387709499e-87, -1.23159968713973769e-104),
+  qd_real( 8.35965084718280449e-57, -5.04027988508830642e-73,
+          -1.97116512594399311e-89, -1.18661232656178291e-106),
+  qd_real( 1.81731540156147899e-58,  1.36506933987936603e-74,
+           2.54490150401424344e-91, -2.39064169520447011e-107),
+  qd_real( 3.86662851396059404e-60, -1.56435500578638898e-76,
+          -1.28638554473548469e-92, -4.72409213107264703e-109),
+  qd_real( 8.05547607075123644e-62,  8.25581847807094913e-78,
+          -2.67996988486559310e-94, -9.84185860640134798e-111),
+  qd_real( 1.64397470831657907e-63, -4.08088098184429381e-80,
+          -3.32913139064192010e-96,  1.47073743046046679e-112),
+  qd_real( 3.28794941663315801e-65,  5.33225140364648137e-82,
+           8.32419386223677347e-99,  6.67478974686111898e-115),
+  qd_real( 6.44695964045717240e-67,  2.85424992234768430e-83,
+          -1.34283448690062958e-99,  8.07662720281449964e-116),
+  qd_real( 1.23979993085714862e-68, -2.43037721005142100e-85,
+          -8.23931872836172134e-102, -1.55032543805821661e-118),
+  qd_real( 2.33924515256065764e-70,  8.16187193608559738e-87,
+           4.84775838685487134e-103, -1.97599569997566896e-119),
+  qd_real( 4.33193546770492182e-72, -1.09508904585482285e-88,
+          -6.00866970243255482e-105, -1.07752335301836004e-121),
+  qd_real( 7.87624630491803921e-74,  2.57884874250475112e-90,
+          -5.37557107111765897e-107, -1.07899884302217330e-123),
+  qd_real( 1.40647255444964979e-75,  1.16180777048980937e-91,
+          -2.90641933241759372e-108, -1.92678364825388090e-125),
+  qd_real( 2.46749570956078931e-77, -4.75671984859365057e-95,
+          -4.49883827404899384e-112,  6.98961356745275990e-129),
+  qd_real( 4.25430294751860222e-79,  3.31266604955696644e-96,
+          -9.37875950847319100e-113, -3.85922158408949368e-129),
+  qd_real( 7.21068296189593649e-81, -4.67566065956127818e-97,
+          -2.27328265586799957e-113, -1.23909425792343248e-129),
+  qd_real( 1.20178049364932260e-82,  6.83747084247765565e-99,
+           1.08404390119938030e-115,  4.89540763199837748e-132),
+  qd_real( 1.97013195680216823e-84,  8.21096887938691099e-101,
+           1.36106511060297614e-117, -2.65652582142175469e-134),
+  qd_real( 3.17763218839059421e-86, -1.55616275958042510e-102,
+           2.83486858497346175e-119,  2.81629268457002035e-136),
+  qd_real( 5.04386061649300675e-88, -3.17879715761914906e-104,
+           2.61371303575286691e-120,  8.63644145883892965e-137),
+  qd_real( 7.88103221327032304e-90, -4.96687055877992040e-106,
+           4.08392661836385455e-122,  1.34944397794358276e-138)
+};
+
+/* Coefficients of the fixed-degree kernels below, in increasing
+   powers of the argument.  The reduced intervals are so small
+   (|r| <= 5.3e-6 for exp, |t| <= pi/2048 for sin/cos) that minimax
+   or Chebyshev economization would save at most one term over the
+   truncated Taylor series, so the Taylor coefficients are kept.   */
+
+/* (exp(r) - 1) / r = sum r^i / (i+1)!,  up to r^10. */
+static constexpr int n_exp_coef = 11;
+static constexpr qd_real exp_coef[n_exp_coef] = {
+  qd_real(1.0, 0.0, 0.0, 0.0), qd_real(0.5, 0.0, 0.0, 0.0),
+  inv_fact[0], inv_fact[1], inv_fact[2], inv_fact[3], inv_fact[4],
+  inv_fact[5], inv_fact[6], inv_fact[7], inv_fact[8]
 };
 
+/* sin(t) / t = sum (-t^2)^i / (2i+1)!,  up to t^16. */
+static constexpr int n_sin_coef = 9;
+static constexpr qd_real sin_coef[n_sin_coef] = {
+  qd_real(1.0, 0.0, 0.0, 0.0),
+  inv_fact[0], inv_fact[2], inv_fact[4], inv_fact[6],
+  inv_fact[8], inv_fact[10], inv_fact[12], inv_fact[14]
+};
+
+/* cos(t) = sum (-t^2)^i / (2i)!,  up to t^16. */
+static constexpr int n_cos_coef = 9;
+static constexpr qd_real cos_coef[n_cos_coef] = {
+  qd_real(1.0, 0.0, 0.0, 0.0), qd_real(0.5, 0.0, 0.0, 0.0),
+  inv_fact[1], inv_fact[3], inv_fact[5], inv_fact[7],
+  inv_fact[9], inv_fact[11], inv_fact[13]
+};
+
+/* Smallest degree n < N such that the first omitted term
+   c[n+1] * x^(n+1) is at most thresh in magnitude (x >= 0).  Only
+   double arithmetic is involved, so the quad-double evaluation
+   that follows has no data-dependent exit.                        */
+template <int N>
+static int poly_degree(const qd_real (&c)[N], double x, double thresh) {
+  int n = 0;
+  double p = x;
+  while (n < N - 1 && p * std::abs(c[n + 1].x[0]) > thresh) {
+    p *= x;
+    n++;
+  }
+  return n;
+}
+
+/* Evaluates c[0] + c[1] x + ... + c[n] x^n using Estrin's scheme.
+   The products within each level are independent of each other,
+   so unlike Horner's rule they can overlap in the pipeline; the
+   dependency chain is only about log2(n) multiplies long.        */
+template <int N>
+static qd_real polyeval_estrin(const qd_real (&c)[N], int n, 
+                               const qd_real &x) {
+  qd_real b[(N + 1) / 2];
+  qd_real p = x;
+  int m = n + 1;
+  int i;
+
+  for (i = 0; i < m / 2; i++)
+    b[i] = c[2 * i] + c[2 * i + 1] * p;
+  if (m & 1)
+    b[m / 2] = c[m - 1];
+  m = (m + 1) / 2;
+
+  while (m > 1) {
+    p = sqr(p);
+    for (i = 0; i < m / 2; i++)
+      b[i] = b[2 * i] + b[2 * i + 1] * p;
+    if (m & 1)
+      b[m / 2] = b[m - 1];
+    m = (m + 1) / 2;
+  }
+  return b[0];
+}
+
+/* Tolerance 2^-bits used by the precision-tunable transcendentals,
+   clamped to the working precision. */
+static double bits_to_eps(int bits) {
+  if (bits >= std::numeric_limits<qd_real>::digits)
+    return qd_real::_eps;
+  if (bits < 1)
+    bits = 1;
+  return std::ldexp(1.0, -bits);
+}
+
 qd_real exp(const qd_real &a) {
+  return exp(a, std::numeric_limits<qd_real>::digits);
+}
+
+qd_real exp(const qd_real &a, int bits) {
   /* Strategy:  We first reduce the size of x by noting that
      
           exp(kr + m * log(2)) = 2^m * exp(r)^k
@@ -861,7 +1148,11 @@ qd_real exp(const qd_real &a) {
      where m and k are integers.  By choosing m appropriately
      we can make |kr| <= log(2) / 2 = 0.347.  Then exp(r) is 
      evaluated using the familiar Taylor series.  Reducing the 
-     argument substantially speeds up the convergence.       */  
+     argument substantially speeds up the convergence.
+
+     The degree of the polynomial is chosen so that the first
+     omitted term is below 2^-bits / k, so that after the k-fold
+     squaring the relative error is about 2^-bits.            */  
 
   const double k = ldexp(1.0, 16);
   const double inv_k = 1.0 / k;
@@ -880,17 +1171,9 @@ qd_real exp(const qd_real &a) {
 
   double m = std::floor(a.x[0] / qd_real::_log2.x[0] + 0.5);
   qd_real r = mul_pwr2(a - qd_real::_log2 * m, inv_k);
-  qd_real s, p, t;
-  double thresh = inv_k * qd_real::_eps;
-
-  p = sqr(r);
-  s = r + mul_pwr2(p, 0.5);
-  int i = 0;
-  do {
-    p *= r;
-    t = p * inv_fact[i++];
-    s += t;
-  } while (std::abs(to_double(t)) > thresh && i < 9);
+  double abs_r = std::abs(to_double(r));
+  int n = poly_degree(exp_coef, abs_r, inv_k * bits_to_eps(bits) / abs_r);
+  qd_real s = r * polyeval_estrin(exp_coef, n, r);
 
   s = mul_pwr2(s, 2.0) + sqr(s);
   s = mul_pwr2(s, 2.0) + sqr(s);
@@ -915,6 +1198,10 @@ qd_real exp(const qd_real &a) {
 /* Logarithm.  Computes log(x) in quad-double precision.
    This is a natural logarithm (i.e., base e).            */
 qd_real log(const qd_real &a) {
+  return log(a, std::numeric_limits<qd_real>::digits);
+}
+
+qd_real log(const qd_real &a, int bits) {
   /* Strategy.  The Taylor series for log converges much more
      slowly than that of exp, due to the lack of the factorial
      term in the denominator.  Hence this routine instead tries
@@ -928,8 +1215,11 @@ qd_real log(const qd_real &a) {
             = x - (1 - a * exp(-x))
             = x + a * exp(-x) - 1.
            
-     Two iteration is needed, since Newton's iteration 
-     approximately doubles the number of digits per iteration. */
+     The double precision initial approximation has an absolute
+     error of about 2^-52 * max(1, |x|).  Newton's iteration 
+     approximately doubles the number of correct bits, so we
+     iterate until about `bits' bits are correct (three times
+     for full precision).                                      */
 
   if (a.is_one()) {
     return 0.0;
@@ -944,11 +1234,36 @@ qd_real log(const qd_real &a) {
     return -qd_real::_inf;
   }
 
+  if (a.isnan() || a.isinf()) {
+    qd_real::error("(qd_real::log): Non-finite argument.");
+    return qd_real::_nan;
+  }
+
+  /* Far from 1, exp(-x) would lose its lower limbs to underflow:
+     take out a power of two first.                            */
+  int k = std::ilogb(a[0]);
+  if (k > 512 || k < -512)
+    return log(ldexp(a, -k), bits) + qd_real::_log2 * static_cast<double>(k);
+
   qd_real x = std::log(a[0]);   /* Initial approximation */
 
-  x = x + a * exp(-x) - 1.0;
-  x = x + a * exp(-x) - 1.0;
-  x = x + a * exp(-x) - 1.0;
+  int prec = 52 - std::max(std::ilogb(x[0]), 0);
+  if (bits > std::numeric_limits<qd_real>::digits)
+    bits = std::numeric_limits<qd_real>::digits;
+
+  /* The first step only needs about 104 bits, so it is done
+     in double-double arithmetic.                           */
+  if (prec < bits) {
+    dd_real xx = x[0];
+    xx = xx + dd_real(a[0], a[1]) * exp(-xx) - 1.0;
+    x = xx;
+    prec = std::min(2 * prec, 100);
+  }
+
+  while (prec < bits) {
+    x = x + a * exp(-x, 2 * prec) - 1.0;
+    prec *= 2;
+  }
 
   return x;
 }
@@ -957,12 +1272,12 @@ qd_real log10(const qd_real &a) {
   return log(a) / qd_real::_log10;
 }
 
-static const qd_real _pi1024 = qd_real(
+static constexpr qd_real _pi1024 = qd_real(
     3.067961575771282340e-03, 1.195944139792337116e-19,
    -2.924579892303066080e-36, 1.086381075061880158e-52);
 
 /* Table of sin(k * pi/1024) and cos(k * pi/1024). */
-static const qd_real sin_table [] = {
+static constexpr qd_real sin_table [] = {
   qd_real( 3.0679567629659761e-03, 1.2690279085455925e-19,
        5.2879464245328389e-36, -1.7820334081955298e-52),
   qd_real( 6.1358846491544753e-03, 9.0545257482474933e-20,
@@ -1477,7 +1792,7 @@ static const qd_real sin_table [] = {
        2.0693376543497068e-33, 2.4677734957341755e-50)
 };
 
-static const qd_real cos_table [] = {
+static constexpr qd_real cos_table [] = {
   qd_real( 9.9999529380957619e-01, -1.9668064285322189e-17,
        -6.3053955095883481e-34, 5.3266110855726731e-52),
   qd_real( 9.9998117528260111e-01, 3.3568103522895585e-17,
@@ -1993,78 +2308,50 @@ static const qd_real cos_table [] = {
 };
 
 /* Computes sin(a) and cos(a) using Taylor series.
-   Assumes |a| <= pi/2048.                           */
+   Assumes |a| <= pi/2048.  Both polynomials are evaluated,
+   since they are independent and overlap with each other.   */
 static void sincos_taylor(const qd_real &a, 
-                          qd_real &sin_a, qd_real &cos_a) {
-  const double thresh = 0.5 * qd_real::_eps * std::abs(to_double(a));
-  qd_real p, s, t, x;
-
+                          qd_real &sin_a, qd_real &cos_a,
+                          double eps = qd_real::_eps) {
   if (a.is_zero()) {
     sin_a = 0.0;
     cos_a = 1.0;
     return;
   }
 
-  x = -sqr(a);
-  s = a;
-  p = a;
-  int i = 0;
-  do {
-    p *= x;
-    t = p * inv_fact[i];
-    s += t;
-    i += 2;
-  } while (i < n_inv_fact && std::abs(to_double(t)) > thresh);
-
-  sin_a = s;
-  cos_a = sqrt(1.0 - sqr(s));
+  qd_real x = -sqr(a);
+  double abs_x = std::abs(to_double(x));
+  int n = poly_degree(sin_coef, abs_x, 0.5 * eps);
+  int m = poly_degree(cos_coef, abs_x, 0.5 * eps);
+  sin_a = a * polyeval_estrin(sin_coef, n, x);
+  cos_a = polyeval_estrin(cos_coef, m, x);
 }
 
-static qd_real sin_taylor(const qd_real &a) {
-  const double thresh = 0.5 * qd_real::_eps * std::abs(to_double(a));
-  qd_real p, s, t, x;
-
+static qd_real sin_taylor(const qd_real &a, double eps = qd_real::_eps) {
   if (a.is_zero()) {
     return 0.0;
   }
 
-  x = -sqr(a);
-  s = a;
-  p = a;
-  int i = 0;
-  do {
-    p *= x;
-    t = p * inv_fact[i];
-    s += t;
-    i += 2;
-  } while (i < n_inv_fact && std::abs(to_double(t)) > thresh);
-
-  return s;
+  qd_real x = -sqr(a);
+  int n = poly_degree(sin_coef, std::abs(to_double(x)), 0.5 * eps);
+  return a * polyeval_estrin(sin_coef, n, x);
 }
 
-static qd_real cos_taylor(const qd_real &a) {
-  const double thresh = 0.5 * qd_real::_eps;
-  qd_real p, s, t, x;
-
+static qd_real cos_taylor(const qd_real &a, double eps = qd_real::_eps) {
   if (a.is_zero()) {
     return 1.0;
   }
 
-  x = -sqr(a);
-  s = 1.0 + mul_pwr2(x, 0.5);
-  p = x;
-  int i = 1;
-  do {
-    p *= x;
-    t = p * inv_fact[i];
-    s += t;
-    i += 2;
-  } while (i < n_inv_fact && std::abs(to_double(t)) > thresh);
-
-  return s;
+  qd_real x = -sqr(a);
+  int n = poly_degree(cos_coef, std::abs(to_double(x)), 0.5 * eps);
+  return polyeval_estrin(cos_coef, n, x);
 }
 
 qd_real sin(const qd_real &a) {
+  return sin(a, std::numeric_limits<qd_real>::digits);
+}
+
+qd_real sin(const qd_real &a, int bits) {
 
   /* Strategy.  To compute sin(x), we choose integers a, b so that
 
@@ -2073,12 +2360,20 @@ qd_real sin(const qd_real &a) {
      and |s| <= pi/2048.  Using a precomputed table of
      sin(k pi / 1024) and cos(k pi / 1024), we can compute
      sin(x) from sin(s) and cos(s).  This greatly increases the
-     convergence of the sine Taylor series.                          */
+     convergence of the sine Taylor series.  The Taylor series
+     are truncated once the terms drop below 2^-bits.                */
+
+  const double eps = bits_to_eps(bits);
 
   if (a.is_zero()) {
     return 0.0;
   }
 
+  if (a.isnan() || a.isinf()) {
+    qd_real::error("(qd_real::sin): Non-finite argument.");
+    return qd_real::_nan;
+  }
+
   // approximately reduce modulo 2*pi
   qd_real z = nint(a / qd_real::_2pi);
   qd_real r = a - qd_real::_2pi * z;
@@ -2105,20 +2400,20 @@ qd_real sin(const qd_real &a) {
   if (k == 0) {
     switch (j) {
       case 0:
-        return sin_taylor(t);
+        return sin_taylor(t, eps);
       case 1:
-        return cos_taylor(t);
+        return cos_taylor(t, eps);
       case -1:
-        return -cos_taylor(t);
+        return -cos_taylor(t, eps);
       default:
-        return -sin_taylor(t);
+        return -sin_taylor(t, eps);
     }
   }
 
   qd_real sin_t, cos_t;
   qd_real u = cos_table[abs_k-1];
   qd_real v = sin_table[abs_k-1];
-  sincos_taylor(t, sin_t, cos_t);
+  sincos_taylor(t, sin_t, cos_t, eps);
 
   if (j == 0) {
     if (k > 0) {
@@ -2150,11 +2445,22 @@ qd_real sin(const qd_real &a) {
 }
 
 qd_real cos(const qd_real &a) {
+  return cos(a, std::numeric_limits<qd_real>::digits);
+}
+
+qd_real cos(const qd_real &a, int bits) {
+
+  const double eps = bits_to_eps(bits);
 
   if (a.is_zero()) {
     return 1.0;
   }
 
+  if (a.isnan() || a.isinf()) {
+    qd_real::error("(qd_real::cos): Non-finite argument.");
+    return qd_real::_nan;
+  }
+
   // approximately reduce modulo 2*pi
   qd_real z = nint(a / qd_real::_2pi);
   qd_real r = a - qd_real::_2pi * z;
@@ -2181,18 +2487,18 @@ qd_real cos(const qd_real &a) {
   if (k == 0) {
     switch (j) {
       case 0:
-        return cos_taylor(t);
+        return cos_taylor(t, eps);
       case 1:
-        return -sin_taylor(t);
+        return -sin_taylor(t, eps);
       case -1:
-        return sin_taylor(t);
+        return sin_taylor(t, eps);
       default:
-        return -cos_taylor(t);
+        return -cos_taylor(t, eps);
     }
   }
 
   qd_real sin_t, cos_t;
-  sincos_taylor(t, sin_t, cos_t);
+  sincos_taylor(t, sin_t, cos_t, eps);
 
   qd_real u = cos_table[abs_k-1];
   qd_real v = sin_table[abs_k-1];
@@ -2234,6 +2540,12 @@ void sincos(const qd_real &a, qd_real &sin_a, qd_real &cos_a) {
     return;
   }
 
+  if (a.isnan() || a.isinf()) {
+    qd_real::error("(qd_real::sincos): Non-finite argument.");
+    cos_a = sin_a = qd_real::_nan;
+    return;
+  }
+
   // approximately reduce by 2*pi
   qd_real z = nint(a / qd_real::_2pi);
   qd_real t = a - qd_real::_2pi * z;
@@ -2526,6 +2838,612 @@ qd_real atanh(const qd_real &a) {
   return mul_pwr2(log((1.0 + a) / (1.0 - a)), 0.5);
 }
 
+/* Coefficients (-1)^n / (n! (2n+1)) of the Maclaurin series
+
+     erf(x) = 2/sqrt(pi) * x * sum c_n x^(2n),
+
+   used for |x| < 1/2.                                         */
+static constexpr int n_erf_coef = 37;
+static constexpr qd_real erf_coef[n_erf_coef] = {
+  qd_real( 1.00000000000000000e+00,  0.00000000000000000e+00,
+           0.00000000000000000e+00,  0.00000000000000000e+00),
+  qd_real(-3.33333333333333315e-01, -1.85037170770859413e-17,
+          -1.02716263700652573e-33, -5.70189804819668373e-50),
+  qd_real( 1.00000000000000006e-01, -5.55111512312578301e-18,
+           3.08148791101957754e-34, -1.71056941445900531e-50),
+  qd_real(-2.38095238095238082e-02, -1.32169407693471009e-18,
+          -7.33687597861804094e-35, -4.07278432014048838e-51),
+  qd_real( 4.62962962962962937e-03,  2.56996070515082518e-19,
+           1.42661477362017463e-35,  7.91930284471761629e-52),
+  qd_real(-7.57575757575757575e-04, -6.57092225748790565e-22,
+          -5.69936654944139397e-40, -4.94341247575645797e-58),
+  qd_real( 1.06837606837606838e-04,  9.26668523491884131e-23,
+           8.03756821075068381e-41,  6.97147913247705611e-59),
+  qd_real(-1.32275132275132281e-05,  5.53215592640586407e-22,
+           1.56633067360362362e-38,  1.18270280346961624e-54),
+  qd_real( 1.45891690009337058e-06,  1.00916343669139804e-22,
+          -5.87637418702383503e-39,  3.89934160552666238e-57),
+  qd_real(-1.45038522231504685e-07, -2.75729942161182996e-24,
+          -7.95924682565610658e-41,  1.69920339648956748e-57),
+  qd_real( 1.31225329638028058e-08, -7.58902608585477723e-25,
+           3.69384315981812500e-41,  5.25981765257933021e-58),
+  qd_real(-1.08922210371485731e-09, -2.69190200194198817e-26,
+           1.60741086747956764e-42, -1.01589180445988759e-58),
+  qd_real( 8.35070279514723971e-11, -1.21046505653354370e-27,
+          -3.95306049044311043e-44, -9.07122847405497495e-61),
+  qd_real(-5.94779401363763541e-12,  3.71589825397953809e-28,
+           4.73187574212732137e-45,  7.17016447187518352e-62),
+  qd_real( 3.95542951645852569e-13,  7.12259060442439502e-30,
+           1.89233819591097576e-46, -5.72631246865177518e-63),
+  qd_real(-2.46682701026445706e-14,  1.29977179148148958e-30,
+           4.54556775355477315e-47, -7.51140626036503847e-64),
+  qd_real( 1.44832646435981379e-15, -6.43599210116630327e-32,
+          -4.99102681796627746e-48, -1.76886698963569669e-64),
+  qd_real(-8.03273501241577328e-17, -3.30813202092288827e-33,
+           3.99209499856556865e-50, -1.91131671170213957e-66),
+  qd_real( 4.22140728880708822e-18,  9.59729713379292999e-36,
+           4.50408921036929828e-52,  1.17800645504972018e-68),
+  qd_real(-2.10785519144213592e-19,  9.13743697743918310e-36,
+          -6.06819180989611447e-52, -2.26131841449298932e-68),
+  qd_real( 1.00251649349077191e-20,  1.08550314048073388e-37,
+          -5.36351389923561820e-54, -6.66589895076927806e-71),
+  qd_real(-4.55184675892819988e-22, -4.04408070502801905e-38,
+           1.74154094103958479e-55,  7.43911114562475947e-72),
+  qd_real( 1.97706475387790510e-23,  7.23509715097634394e-40,
+           3.47601912871445798e-57,  2.45153821727520077e-73),
+  qd_real(-8.23014929921422104e-25, -3.19873432885007931e-41,
+           2.53865022293970258e-57, -5.19235007257184723e-76),
+  qd_real( 3.28926034917575191e-26, -1.80620490108938426e-42,
+           1.56469506293752461e-58, -1.30275577919409304e-75),
+  qd_real(-1.26410789889891639e-27,  3.43857690183680412e-44,
+          -1.01930711849909823e-60, -6.25353983367682239e-77),
+  qd_real( 4.67848351551848558e-29,  1.89199317927580608e-45,
+          -7.87874681606411109e-62,  5.57337660654883174e-78),
+  qd_real(-1.66976179341737213e-30,  1.01385041489915504e-46,
+           8.97995718829349905e-63,  2.99045772648399786e-79),
+  qd_real( 5.75419164398217174e-32,  3.47433270348196358e-49,
+           3.74260253713263411e-65,  1.02409800536779689e-81),
+  qd_real(-1.91694286210978258e-33,  4.82106105054361876e-50,
+           1.23975328484552179e-67,  6.84719920060330924e-84),
+  qd_real( 6.18030758822279615e-35, -1.40540863634693812e-52,
+          -7.72649382396362567e-69,  3.67696336000610067e-85),
+  qd_real(-1.93035720881510799e-36,  1.34059113652305092e-52,
+           8.07567408850353053e-69, -3.91028043717067769e-85),
+  qd_real( 5.84675500746883582e-38,  4.77381404893683809e-54,
+           2.54716468565747886e-70, -6.96474563739507192e-87),
+  qd_real(-1.71885606280178354e-39, -7.93986322554160833e-56,
+          -4.02643894347987250e-73,  1.80056562535713485e-89),
+  qd_real( 4.90892396452342322e-41, -2.51306849670059098e-57,
+           8.60416948516415648e-75, -3.56869198806006516e-91),
+  qd_real(-1.36304126177913957e-42, -9.20209142019208986e-60,
+          -3.47265672142527014e-77,  3.34089468007859169e-94),
+  qd_real( 3.68249351546114568e-44,  5.97175167326787837e-61,
+           2.51558111821053082e-78,  7.19691294685447591e-95)
+};
+
+/* exp(x0^2) * erfc(x0) at the nodes x0 = j/16, j = 8, ..., 128. */
+static constexpr int n_erfc_node = 121;
+static constexpr qd_real erfc_node[n_erfc_node] = {
+  qd_real( 6.15690344192925898e-01, -2.31217586862334096e-17,
+          -9.50416940282482736e-34, -2.36018210370592823e-50),
+  qd_real( 5.84998621474965730e-01,  4.77849845408508741e-17,
+           2.56906364000322864e-33,  1.06846590522141409e-49),
+  qd_real( 5.56813880873362477e-01,  2.82156721466000847e-17,
+           5.36477808475418203e-34, -9.31773505425796777e-51),
+  qd_real( 5.30870872417554485e-01, -1.00306040620651532e-17,
+           2.16808136373116917e-34, -6.71712717272237463e-51),
+  qd_real( 5.06937650293144859e-01, -5.33568103546223196e-17,
+          -3.13491587267514146e-34,  1.48242434175941536e-50),
+  qd_real( 4.84810828561620222e-01, -5.14184070972225786e-18,
+           2.99336628254318976e-34, -1.77872521260066264e-50),
+  qd_real( 4.64311583202669020e-01, -1.85196372775457397e-17,
+          -1.92361004831622728e-34,  7.36953522573437807e-51),
+  qd_real( 4.45282273136881679e-01, -2.70694841278375906e-19,
+           1.30925990612832629e-35,  1.57332111284823968e-52),
+  qd_real( 4.27583576155806999e-01,  5.23573728331422823e-18,
+          -5.56077913779278563e-35,  2.84342188961305439e-52),
+  qd_real( 4.11092054444830490e-01, -5.99887582302419109e-18,
+          -2.42801622395155747e-34,  1.25144139631652834e-50),
+  qd_real( 3.95698079552995907e-01, -5.77767505608912928e-18,
+          -3.71414360844042775e-34,  1.18428497160703703e-50),
+  qd_real( 3.81304058966717874e-01,  2.43856147804395747e-17,
+           5.13571258653101253e-34, -3.19865561363067965e-50),
+  qd_real( 3.67822916452361093e-01,  1.38740109392503499e-19,
+          -3.95026615108830545e-36,  1.91010918710574100e-52),
+  qd_real( 3.55176786497634123e-01,  2.17564318742691909e-17,
+          -4.29349705535403684e-35,  1.78032557511822514e-51),
+  qd_real( 3.43295889862125392e-01, -1.19240631467685412e-17,
+          -5.99166303423963166e-34, -3.29448984120171586e-50),
+  qd_real( 3.32117562728372340e-01, -3.81075415017979455e-18,
+           2.77603346040588710e-34, -1.27429085312002440e-50),
+  qd_real( 3.21585416454317485e-01,  1.70079856077221961e-17,
+          -1.44882251156132670e-34, -3.60524350166221799e-51),
+  qd_real( 3.11648608648130043e-01,  9.80372503528028616e-18,
+           3.70955525063666878e-34, -7.49714954061852851e-51),
+  qd_real( 3.02261209363485939e-01, -2.13002438459551376e-17,
+          -1.31604875520631088e-33, -7.64432635070878461e-50),
+  qd_real( 2.93381648765277225e-01,  1.25391833376109225e-17,
+           3.69917915632806280e-34, -3.87673148911804121e-51),
+  qd_real( 2.84972234737436381e-01,  8.53981302397312200e-18,
+           3.79250271158466792e-34,  3.64513712035370894e-51),
+  qd_real( 2.76998730673052751e-01, -5.29722698223957107e-19,
+           4.32234067241123924e-35,  1.56942507251392635e-51),
+  qd_real( 2.69429985164670427e-01,  2.48345797241347183e-17,
+           1.24182140462292114e-34, -4.97253817797505800e-52),
+  qd_real( 2.62237606550381419e-01,  1.97320773243498036e-17,
+           2.51681377709406192e-34,  2.03365659368994208e-50),
+  qd_real( 2.55395676310505748e-01, -4.27602229016594589e-18,
+           2.65974585920011432e-34,  9.66135007638844808e-51),
+  qd_real( 2.48880496184162359e-01,  2.58640416329388107e-18,
+          -1.74325421469977622e-34, -4.23532296717645728e-51),
+  qd_real( 2.42670364612654538e-01,  8.85948000786290353e-18,
+          -6.50246465328668101e-34,  1.72421069309374677e-50),
+  qd_real( 2.36745378740146284e-01,  6.03349335419093502e-18,
+          -3.11442142499098052e-34,  8.07389259592723090e-51),
+  qd_real( 2.31087258730391876e-01, -5.74762364596781998e-18,
+           2.87097882662989292e-35,  2.77768835950978514e-52),
+  qd_real( 2.25679191606819374e-01,  1.22605307158600402e-17,
+          -1.02353780772015668e-34,  8.67729414629687443e-51),
+  qd_real( 2.20505692204906678e-01, -1.34612295999307570e-17,
+          -7.22291172163734630e-34, -3.25615769689407071e-50),
+  qd_real( 2.15552479151177478e-01,  9.86231842680207550e-18,
+           1.94522433113403140e-36, -3.42867418416850823e-53),
+  qd_real( 2.10806364061143586e-01, -5.62772590931025244e-18,
+           3.54240299963980712e-34, -1.60688241178516822e-50),
+  qd_real( 2.06255152386500912e-01, -1.32032916100291311e-17,
+          -9.43178052189186779e-35,  1.09325886710311495e-51),
+  qd_real( 2.01887554546017006e-01,  3.29035590885698445e-18,
+           6.13631752081169128e-35, -5.02471314847136979e-51),
+  qd_real( 1.97693106149972986e-01, -1.22573668409961065e-17,
+           6.36163773718640676e-35,  2.15772642261896862e-51),
+  qd_real( 1.93662096279068691e-01, -1.20158465327391744e-17,
+           4.74232448920121374e-35,  2.90724628562307211e-52),
+  qd_real( 1.89785502908994624e-01, -8.70131075560581683e-19,
+           7.57935880746243735e-36,  1.66633760492354958e-52),
+  qd_real( 1.86054934684471096e-01,  7.76667829835616033e-18,
+           2.45603139356460753e-34,  1.12258650271156717e-50),
+  qd_real( 1.82462578344034732e-01, -1.37520264007672845e-17,
+          -4.92224405053050354e-35, -4.99417710212534636e-51),
+  qd_real( 1.79001151181389956e-01, -5.42721759202002739e-18,
+           7.84390736380506234e-35, -8.01614130045791942e-52),
+  qd_real( 1.75663858002584328e-01,  7.66158317530573781e-18,
+           1.85478942731142388e-34,  4.48250764966470814e-51),
+  qd_real( 1.72444352102173598e-01,  9.75382340157330846e-18,
+          -1.25272643698013681e-34,  4.27943773232338592e-51),
+  qd_real( 1.69336699837247751e-01,  1.24796816764501213e-17,
+           1.67423352663223423e-34,  8.79296838746108388e-51),
+  qd_real( 1.66335348426821877e-01, -6.13341633950197469e-19,
+           9.13991973834888125e-36,  6.47116703163842593e-52),
+  qd_real( 1.63435096646622313e-01,  4.31867556339852728e-18,
+           3.25286719558761851e-34,  1.49469468902644136e-50),
+  qd_real( 1.60631068126544402e-01,  2.40807446851982769e-18,
+          -7.57439447913525059e-35, -4.03998932380452609e-51),
+  qd_real( 1.57918686990727614e-01, -4.55734102026422390e-18,
+          -3.09035008245725780e-34,  1.80534432214780810e-52),
+  qd_real( 1.55293655608894299e-01, -1.35584454221609201e-18,
+          -8.75225681711361247e-35,  2.07592460384996485e-51),
+  qd_real( 1.52751934252847499e-01, -1.62288576774125938e-18,
+           3.44740474252547664e-35, -6.45292475411050236e-52),
+  qd_real( 1.50289722474269360e-01, -1.37156868645726726e-19,
+          -1.02125800811831724e-35, -2.22291909237286215e-52),
+  qd_real( 1.47903442039589994e-01, -2.34668404571895965e-18,
+          -9.11868391058405654e-35,  3.87788208708597341e-51),
+  qd_real( 1.45589721275038553e-01, -1.37156473444443336e-17,
+           4.48813430718023599e-34,  3.29428320776492662e-51),
+  qd_real( 1.43345380690332119e-01, -1.34977080154868751e-17,
+          -6.87595984115813366e-34,  2.21289212405646476e-50),
+  qd_real( 1.41167419763051805e-01, -1.25341946913660225e-17,
+           4.93012531300128875e-34,  6.28763196920633850e-51),
+  qd_real( 1.39053004777814515e-01,  8.32752156500682639e-18,
+           6.27963440987932718e-34, -2.38962988985336682e-50),
+  qd_real( 1.36999457625061383e-01,  7.19656813915871921e-18,
+           7.25946893179842230e-34, -4.05400704688544145e-50),
+  qd_real( 1.35004245473810680e-01, -1.76742979027500660e-18,
+           1.11401366748120297e-34, -4.52874812618370520e-51),
+  qd_real( 1.33064971241208252e-01,  4.18468650022013014e-18,
+          -6.09630167040479193e-35, -2.54882866840057666e-52),
+  qd_real( 1.31179364789272945e-01,  9.91732785254849446e-18,
+           2.75562252973706667e-35,  2.45158437584688438e-51),
+  qd_real( 1.29345274785987924e-01, -1.29175085131573191e-17,
+           6.10945217193786024e-34,  9.11925970020250903e-51),
+  qd_real( 1.27560661173924700e-01, -4.11232111502636914e-18,
+          -1.86442580250889059e-34,  1.01680618963105208e-50),
+  qd_real( 1.25823588194988067e-01,  1.73114925873585896e-18,
+          -3.96711203829653148e-35,  6.55600627546720972e-52),
+  qd_real( 1.24132217924707564e-01, -3.50874497911961763e-18,
+          -6.47696588915068234e-35,  4.37456300454698198e-51),
+  qd_real( 1.22484804273841424e-01, -6.88869313574429388e-18,
+           3.81778929415236169e-34,  1.00539635123578367e-51),
+  qd_real( 1.20879687418954482e-01, -1.81933599542155778e-18,
+          -1.71949012452592326e-34, -3.92113505781217267e-51),
+  qd_real( 1.19315288627133323e-01,  4.90838455546025954e-18,
+          -1.13133665831055781e-34, -4.75818809276956896e-51),
+  qd_real( 1.17790105443152965e-01, -4.60981794168026323e-18,
+           1.54295747810021649e-34, -5.46163871794828947e-51),
+  qd_real( 1.16302707210247311e-01, -3.17747868799729143e-18,
+          -1.31445346710106850e-34, -1.96011409015801733e-51),
+  qd_real( 1.14851730898194879e-01, -1.82724806539744520e-18,
+           1.50236517379291078e-34, -7.16811186777495227e-51),
+  qd_real( 1.13435877214740494e-01, -2.83995804299078001e-18,
+           7.34799408711045191e-35,  3.21288826787341787e-51),
+  qd_real( 1.12053906978460821e-01,  6.09834672401953172e-18,
+          -1.84455291381292761e-34,  7.31551617153211100e-51),
+  qd_real( 1.10704637733068628e-01, -1.83234749363973903e-18,
+          -3.39539163992934419e-35,  1.58498192140759218e-51),
+  qd_real( 1.09386940584858788e-01, -3.82321728727012815e-18,
+           1.11458160123549254e-34, -5.73348426201393379e-51),
+  qd_real( 1.08099737246547464e-01,  2.17250001322154007e-18,
+           3.12441939748286143e-35,  1.77157815048096252e-51),
+  qd_real( 1.06841997272159261e-01, -1.53119960856806160e-18,
+          -7.66938971803953580e-35,  2.35726037046878846e-51),
+  qd_real( 1.05612735468891800e-01,  2.76342157914190464e-18,
+           1.59855025884819796e-34,  9.74061592808469259e-51),
+  qd_real( 1.04411009473045241e-01,  1.91379372853911972e-18,
+          -7.99204045318275180e-35,  5.03471864025514999e-51),
+  qd_real( 1.03235917478156927e-01,  3.86500358327895498e-19,
+          -1.99200660290206577e-36,  2.19453605713001300e-53),
+  qd_real( 1.02086596104440167e-01,  5.92180422182327590e-19,
+           2.44593395941900201e-35, -5.23118325259783703e-52),
+  qd_real( 1.00962218399499093e-01, -4.70285761294306910e-18,
+          -2.35139370009300071e-34, -1.32936003007650905e-50),
+  qd_real( 9.98619919610876788e-02, -5.29593784797281984e-18,
+           4.45015783221594136e-35,  2.35992467332676024e-51),
+  qd_real( 9.87851571734075368e-02,  3.31281782901441755e-18,
+           9.59446147468479581e-35, -2.61037505306207947e-51),
+  qd_real( 9.77309855491024504e-02, -1.42621054970039431e-18,
+          -7.32515085242499263e-35, -4.60303307733148492e-51),
+  qd_real( 9.66987781697139226e-02, -1.77565727335395650e-18,
+          -1.76276195821423821e-34, -8.82480821203563313e-51),
+  qd_real( 9.56878642179170014e-02,  4.09976972879112951e-18,
+          -4.08654226877529523e-35, -6.39408545858817727e-52),
+  qd_real( 9.46975995953630301e-02, -5.46901537616685465e-18,
+           4.31858872599342664e-35, -1.38761326422961244e-51),
+  qd_real( 9.37273656204212907e-02,  5.58304065539873791e-18,
+          -1.87009387531767391e-35, -7.31518998862384512e-52),
+  qd_real( 9.27765678005383482e-02,  6.21536475552848508e-18,
+           1.10500836910475832e-34, -1.06167154364572935e-51),
+  qd_real( 9.18446346743245073e-02, -5.42297856356264159e-18,
+           1.18574777768379035e-34, -7.07350587386823811e-51),
+  qd_real( 9.09310167188368546e-02, -2.79375371921842866e-18,
+           2.73355305119998427e-35,  9.90215973788991697e-52),
+  qd_real( 9.00351853178581601e-02,  5.76179818335355570e-18,
+          -5.72795649396938610e-35,  2.32242467097190383e-51),
+  qd_real( 8.91566317872743846e-02,  5.22490859618254179e-18,
+           3.42877091944639253e-34,  1.93123804512829182e-50),
+  qd_real( 8.82948664539331268e-02, -2.39885031511255680e-18,
+           4.50226811355580691e-35,  5.97796565747285796e-52),
+  qd_real( 8.74494177846224935e-02,  3.31494859386233149e-18,
+           8.15465423702467036e-35, -2.84602569274117605e-51),
+  qd_real( 8.66198315620469034e-02, -2.94318581558677570e-18,
+           2.92705021983301214e-35, -2.32876231906582873e-51),
+  qd_real( 8.58056701048946074e-02, -5.66382694077563253e-18,
+           6.54391811471272510e-35,  3.94337231493381230e-51),
+  qd_real( 8.50065115292938378e-02,  1.35164597155399438e-19,
+           5.03001517931539907e-36, -9.14488140966201367e-53),
+  qd_real( 8.42219490491401823e-02, -4.20652838121292571e-18,
+           9.31220460495603259e-35, -2.13942043867583702e-51),
+  qd_real( 8.34515903129498943e-02, -1.42806090853098110e-19,
+          -5.18788522489530321e-36, -1.10256956757129085e-52),
+  qd_real( 8.26950567750530663e-02, -6.76238393022572251e-18,
+          -3.63805487785110596e-34, -9.76219386103746439e-51),
+  qd_real( 8.19519830990871473e-02,  4.17576680524697372e-19,
+           2.30876238113676045e-35, -1.55692320734588419e-52),
+  qd_real( 8.12220165918880049e-02, -5.67597234333802957e-19,
+           1.40246352398881415e-35,  9.33035430052091792e-52),
+  qd_real( 8.05048166660011222e-02, -2.43775648933843691e-18,
+          -1.31372859654005766e-34,  8.75289463511740180e-51),
+  qd_real( 7.98000543291529363e-02, -2.79340030987008415e-18,
+          -5.73067195943986171e-35,  2.68793688952426835e-51),
+  qd_real( 7.91074116991302145e-02, -3.23365430406760236e-18,
+          -6.94918098794452919e-35, -7.81896809423945352e-56),
+  qd_real( 7.84265815426160168e-02, -2.28542620599283172e-18,
+           2.35820442947877937e-35,  2.70968384373567217e-52),
+  qd_real( 7.77572668366240533e-02,  6.42519060217002534e-18,
+           2.16232880550925297e-34,  3.64811221000886712e-51),
+  qd_real( 7.70991803512598994e-02,  2.22849835187080467e-18,
+           1.09778911172168427e-34,  8.37330802212425277e-51),
+  qd_real( 7.64520442526178817e-02,  3.67749627975268847e-18,
+          -6.38128948863139211e-36, -6.26476146723445733e-52),
+  qd_real( 7.58155897246976795e-02, -2.76458763501349139e-18,
+          -1.15298885274920055e-34,  2.12042867110254922e-51),
+  qd_real( 7.51895566092938283e-02,  1.95604014547135619e-18,
+          -7.30964727479599072e-36,  4.49599994497898513e-53),
+  qd_real( 7.45736930628766864e-02, -3.41639586145517204e-18,
+           1.63275571472349093e-34,  3.77028694142065354e-51),
+  qd_real( 7.39677552295432417e-02,  8.78901754576344383e-19,
+           8.08878039714478394e-36,  3.35654447820269684e-52),
+  qd_real( 7.33715069291729916e-02,  6.79671516351160000e-18,
+           1.36172928204846226e-34, -4.55160703801496236e-51),
+  qd_real( 7.27847193599760328e-02,  3.40421600742888172e-18,
+          -1.65099777004236839e-34,  2.28873607740255702e-51),
+  qd_real( 7.22071708146697633e-02, -2.77319978304035369e-18,
+           8.08016636367397441e-36, -4.57982694505966605e-52),
+  qd_real( 7.16386464095661868e-02, -2.20949255014371606e-18,
+          -8.77734831502231249e-35, -2.26597087681900816e-51),
+  qd_real( 7.10789378258943755e-02,  3.37850648098434271e-18,
+           1.03502992202087695e-34, -2.57831798055676127e-51),
+  qd_real( 7.05278430627224867e-02, -7.37783371557776901e-19,
+          -2.35404246897197471e-35, -8.54892901042929319e-52),
+  qd_real( 6.99851662008809244e-02,  3.28634065964687457e-18,
+           1.51821413639024326e-35,  1.98081450388811411e-52)
+};
+
+/* B_2k / (2k (2k-1)), k = 1, ..., 36, coefficients of the Stirling
+   series for log Gamma.  These suffice for arguments >= 32.        */
+static constexpr int n_stirling_coef = 36;
+static constexpr qd_real stirling_coef[n_stirling_coef] = {
+  qd_real( 8.33333333333333287e-02,  4.62592926927148533e-18,
+           2.56790659251631433e-34,  1.42547451204917093e-50),
+  qd_real(-2.77777777777777788e-03,  1.06010879087471541e-19,
+           3.47737351069917552e-36,  3.26671242344601679e-52),
+  qd_real( 7.93650793650793650e-04,  6.88382331736828211e-22,
+           5.97076495655765083e-40,  5.17881306984009883e-58),
+  qd_real(-5.95238095238095292e-04,  5.36938218754726024e-20,
+          -1.83421899465451050e-36,  1.65456863005707355e-52),
+  qd_real( 8.41750841750841714e-04,  3.68701748892376936e-20,
+          -6.88990089532470776e-37,  3.76841825707443410e-53),
+  qd_real(-1.91752691752691763e-03,  1.06757027768724749e-19,
+           6.56834249542655383e-37, -2.03112614013416523e-53),
+  qd_real( 6.41025641025641003e-03,  2.22400445638052172e-19,
+           1.97531276347408799e-35,  6.85324284639024464e-52),
+  qd_real(-2.95506535947712423e-02,  4.86176095750885531e-19,
+           1.31668151753532592e-35,  2.71818424111337035e-52),
+  qd_real( 1.79644372368830574e-01, -6.40160048271094580e-19,
+           9.77997743967833185e-36, -1.64598734214484078e-52),
+  qd_real(-1.39243221690590113e+00,  1.58370569892303027e-17,
+           5.20560126850388543e-34,  2.85858793057439511e-50),
+  qd_real( 1.34028640441683926e+01, -6.15411410199396641e-16,
+           1.36104365980160770e-34, -2.67092015197618985e-51),
+  qd_real(-1.56848284626002027e+02,  9.39182314171538895e-15,
+           1.65703924710861581e-31, -4.37812781670204933e-48),
+  qd_real( 2.19310333333333347e+03, -1.33392556260029476e-13,
+           6.73161305788596784e-31, -4.32067026500151941e-47),
+  qd_real(-3.61087712537249899e+04,  5.89758335351436479e-13,
+           7.04970971579373310e-31,  3.24896626706216895e-47),
+  qd_real( 6.91472268851313042e+05,  2.55852963051579989e-11,
+          -1.25217228216408432e-27, -8.04285717897239093e-44),
+  qd_real(-1.52382215394074153e+07, -8.76774522490625042e-10,
+          -1.96723535939239966e-26, -1.19876979883652352e-42),
+  qd_real( 3.82900751391414165e+08, -2.40826847577335854e-08,
+          -4.34478705583408518e-25,  4.26710386188646028e-41),
+  qd_real(-1.08822660357843914e+10,  3.14183093021974915e-07,
+          -2.01393464641994708e-23,  4.45486987764433579e-41),
+  qd_real( 3.47320283765002258e+11, -6.04852899774774780e-06,
+           5.34164921691901066e-23,  4.87141803043470482e-39),
+  qd_real(-1.23696021422692754e+13,  9.36373289650728642e-04,
+           3.29994263595807899e-20, -2.22832671377892580e-36),
+  qd_real( 4.88788064793079312e+14,  2.25758151625180224e-02,
+           4.80097171539227846e-19,  8.20451710044459387e-36),
+  qd_real(-2.13203339609193720e+16, -1.89697505898213681e+00,
+          -3.04740691356497279e-17, -2.03064548824586365e-33),
+  qd_real( 1.02177529652570010e+18, -1.84347123719464143e+01,
+          -1.77495703101616841e-16,  9.65872838051337372e-33),
+  qd_real(-5.35754721733002035e+19, -9.08277091919692054e+01,
+           9.64064230995254487e-16, -5.34967258339523634e-32),
+  qd_real( 3.06157826370488343e+21, -1.43328489486703766e+04,
+          -6.83949015062387599e-13,  6.61921135562071054e-30),
+  qd_real(-1.89999174263992039e+23, -1.25916114293069439e+06,
+           9.97935855325427625e-11,  2.64486895053045623e-27),
+  qd_real( 1.27633740338288348e+25, -6.44253432622302175e+08,
+           5.44717903140079875e-10,  2.63361225573513650e-26),
+  qd_real(-9.25284717612041578e+26, -5.30927547948347626e+10,
+           2.95290254375653091e-07, -8.41501122886129659e-24),
+  qd_real( 7.21882259518561062e+28, -3.23640145345498340e+12,
+          -2.22337601595797398e-04, -4.99169302328790548e-21),
+  qd_real(-6.04518340599585719e+30,  2.26514861971549438e+14,
+           1.52139338556040327e-02,  7.10813543365583274e-20),
+  qd_real( 5.42067047157009455e+32, -6.56273188931470000e+14,
+           1.36612021857923497e-03,  1.18492040708798299e-21),
+  qd_real(-5.19295781531408236e+34,  4.11595761344320512e+18,
+          -2.40846997062713967e+02, -7.12621510025940444e-15),
+  qd_real( 5.30365885511970086e+36, -2.60554377378700689e+20,
+           7.34769929263540598e+03, -4.32757044675037206e-13),
+  qd_real(-5.76332534816496380e+38, -2.13731191577735290e+22,
+          -1.64681507375621889e+06, -1.76070934504418811e-11),
+  qd_real( 6.65115571484845346e+40,  4.78104831687843473e+24,
+          -3.64755226064054519e+07,  1.18339555115026609e-09),
+  qd_real(-8.13737835813668011e+42, -4.31118642778394651e+26,
+           1.80421148948350258e+10,  3.33384116429995521e-07)
+};
+
+/* 2 / sqrt(pi) and log(2 pi) / 2. */
+static constexpr qd_real _2_sqrtpi = qd_real(1.12837916709551256e+00,
+                                             1.53354596131658812e-17,
+                                             -4.76568459669368630e-34,
+                                             -2.00779466165526301e-50);
+static constexpr qd_real _half_log_2pi = qd_real(9.18938533204672781e-01,
+                                                 -3.87829415806724145e-17,
+                                                 -1.32397159684980697e-33,
+                                                 5.15086043687168421e-50);
+
+/* erf(a) for |a| < 1/2. */
+static qd_real erf_series(const qd_real &a) {
+  qd_real x = sqr(a);
+  int n = poly_degree(erf_coef, to_double(x), 0.5 * qd_real::_eps);
+  return _2_sqrtpi * a * polyeval_estrin(erf_coef, n, x);
+}
+
+/* erfc(a) for a >= 1/2. */
+static qd_real erfc_pos(const qd_real &a) {
+  /* Strategy.  For a >= 8 the even part of Laplace's continued
+     fraction
+
+                    2a exp(-a^2) / sqrt(pi)
+       erfc(a) = -----------------------------------------
+                 2a^2 + 1 - 1*2 / (2a^2 + 5 - 3*4 / (2a^2 + 9 - ...))
+
+     converges quickly enough.  Below that, a is written as x0 + h
+     where x0 = j/16 is the first node at or above a, so that
+
+       erfc(a) = exp(-x0^2) * (erfcx(x0) - 2/sqrt(pi) * F(h)),
+
+       F(h) = int_0^h exp(-2 x0 t - t^2) dt = sum_{k>=1} f_k h^k,
+
+     with erfcx(x0) = exp(x0^2) erfc(x0) taken from a table.  The
+     coefficients are f_k = q_{k-1} / k!, where q_n = (-1)^n H_n(x0)
+     are signed Hermite polynomials:
+
+       q_0 = 1,  q_1 = -2 x0,  q_{n+1} = -2 x0 q_n - 2n q_{n-1}.
+
+     Since h <= 0, F(h) <= 0 and there is no cancellation.      */
+
+  if (a[0] > 26.6)
+    return 0.0;
+
+  if (a[0] >= 8.0) {
+    int n = 9 + static_cast<int>(250.0 / a[0]);
+    qd_real y = mul_pwr2(sqr(a), 2.0);
+    qd_real f = y + (4.0 * n + 1.0);
+    for (int k = n; k >= 1; k--)
+      f = (y + (4.0 * k - 3.0)) - ((2.0 * k - 1.0) * (2.0 * k)) / f;
+    return _2_sqrtpi * a * exp(-sqr(a)) / f;
+  }
+
+  const int max_terms = n_inv_fact;
+  double x0 = std::ceil(a[0] * 16.0) / 16.0;
+  qd_real h = a - x0;
+  const qd_real &e0 = erfc_node[static_cast<int>(x0 * 16.0) - 8];
+
+  /* Generate f_1, f_2, ... until two consecutive terms are
+     negligible. */
+  qd_real f[max_terms];
+  qd_real q0 = 1.0, q1 = -2.0 * x0, q2;
+  double abs_h = std::abs(to_double(h));
+  double thresh = 0.25 * qd_real::_eps * e0[0];
+  double p = abs_h * abs_h;
+  double t_prev = abs_h, t = std::abs(x0) * p;
+  int n = 1;
+  f[0] = 1.0;
+  f[1] = -x0;
+  while (n < max_terms - 1 && (t > thresh || t_prev > thresh)) {
+    q2 = -(q1 * (2.0 * x0) + q0 * (2.0 * n));
+    f[n + 1] = q2 * inv_fact[n - 1];
+    q0 = q1;
+    q1 = q2;
+    n++;
+    p *= abs_h;
+    t_prev = t;
+    t = std::abs(f[n][0]) * p;
+  }
+
+  qd_real s = h * polyeval_estrin(f, n, h);
+  return exp(qd_real(-x0 * x0)) * (e0 - _2_sqrtpi * s);
+}
+
+qd_real erf(const qd_real &a) {
+  if (a.isnan())
+    return a;
+
+  qd_real x = abs(a);
+  qd_real r = (x[0] < 0.5) ? erf_series(x) : 1.0 - erfc_pos(x);
+  return (a[0] < 0.0) ? -r : r;
+}
+
+qd_real erfc(const qd_real &a) {
+  if (a.isnan())
+    return a;
+
+  if (a[0] >= 0.5)
+    return erfc_pos(a);
+  if (a[0] <= -0.5)
+    return 2.0 - erfc_pos(-a);
+  return 1.0 - erf_series(a);
+}
+
+/* log Gamma(z) by the Stirling series, for z >= 32. */
+static qd_real lgamma_stirling(const qd_real &z) {
+  qd_real w = 1.0 / z;
+  qd_real w2 = sqr(w);
+  int n = poly_degree(stirling_coef, to_double(w2), qd_real::_eps);
+  qd_real s = w * polyeval_estrin(stirling_coef, n, w2);
+  return (z - 0.5) * log(z) - z + _half_log_2pi + s;
+}
+
+/* Returns z = a + n >= 32 for the smallest such integer n >= 0,
+   and the product a (a+1) ... (a+n-1) in p.  Assumes a > 0.   */
+static qd_real gamma_shift(const qd_real &a, qd_real &p) {
+  qd_real z = a;
+  p = 1.0;
+  while (z[0] < 32.0) {
+    p *= z;
+    z += 1.0;
+  }
+  return z;
+}
+
+/* sin(pi * a), reducing a exactly modulo 2 first. */
+static qd_real sinpi(const qd_real &a) {
+  qd_real n = nint(a);
+  qd_real s = sin(qd_real::_pi * (a - n));
+  return (std::fmod(n[0], 2.0) != 0.0) ? -s : s;
+}
+
+/* (n-1)! for integers 1 <= n <= 50, which is exact in quad-double. */
+static qd_real int_gamma(int n) {
+  qd_real f = 1.0;
+  for (int i = 2; i < n; i++)
+    f *= static_cast<double>(i);
+  return f;
+}
+
+qd_real lgamma(const qd_real &a) {
+  if (a.isnan())
+    return a;
+  if (a.isinf())
+    return qd_real::_inf;
+
+  bool is_int = (a == nint(a));
+  if (a[0] <= 0.0) {
+    if (is_int) {
+      qd_real::error("(qd_real::lgamma): Pole.");
+      return qd_real::_inf;
+    }
+    /* Reflection formula  Gamma(a) Gamma(1-a) = pi / sin(pi a). */
+    return log(qd_real::_pi / abs(sinpi(a))) - lgamma(1.0 - a);
+  }
+
+  if (is_int && a[0] <= 50.0)
+    return log(int_gamma(static_cast<int>(a[0])));
+  if (a[0] >= 32.0)
+    return lgamma_stirling(a);
+
+  qd_real p;
+  qd_real z = gamma_shift(a, p);
+  return lgamma_stirling(z) - log(p);
+}
+
+qd_real tgamma(const qd_real &a) {
+  if (a.isnan())
+    return a;
+  if (a.isinf())
+    return (a[0] > 0.0) ? a : qd_real::_nan;
+
+  bool is_int = (a == nint(a));
+  if (a[0] <= 0.0) {
+    if (is_int) {
+      qd_real::error("(qd_real::tgamma): Pole.");
+      return qd_real::_nan;
+    }
+    /* Reflection formula  Gamma(a) Gamma(1-a) = pi / sin(pi a). */
+    return qd_real::_pi / (sinpi(a) * tgamma(1.0 - a));
+  }
+
+  if (is_int && a[0] <= 50.0)
+    return int_gamma(static_cast<int>(a[0]));
+  if (a[0] >= 32.0) {
+    /* Gamma(a) fits in a double up to a = 171.62, where its log
+       reaches 709.78 and exp overflows; take out 2^64 first.    */
+    qd_real l = lgamma_stirling(a);
+    if (l[0] < 700.0)
+      return exp(l);
+    return ldexp(exp(l - qd_real::_log2 * 64.0), 64);
+  }
+
+  qd_real p;
+  qd_real z = gamma_shift(a, p);
+  return exp(lgamma_stirling(z)) / p;
+}
+
 QD_API qd_real fmod(const qd_real &a, const qd_real &b) {
   qd_real n = aint(a / b);
   return (a - b * n);
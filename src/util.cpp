@@ -1,5 +1,11 @@
 #include <cstdlib>
+#include <cmath>
+#include "config.h"
+#include <qd/dd_real.h>
+#include <qd/qd_real.h>
 #include "util.h"
+#include <qd/dd_inline.h>
+#include <qd/qd_inline.h>
 
 void append_expn(std::string &str, int expn) {
   int k;
@@ -20,3 +26,521 @@ void append_expn(std::string &str, int expn) {
   str += '0' + expn;
 }
 
+
+/* Powers of ten are written  10^k = 10^i * M_j * 2^E_j  with
+   k = 16 j + i, 0 <= i < 16.  10^i is exact in double precision, and
+   10^(16 j) = M_j * 2^E_j with 1 <= M_j < 2 correctly rounded to
+   quad-double precision, so that no table entry is subnormal.     */
+const double exact_pwr10[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const int pow10_jmin = -23;  /* table covers 10^-368 ... 10^367 */
+static const int pow10_jmax = 22;
+
+static constexpr qd_real pow10_block[pow10_jmax - pow10_jmin + 1] = {
+  qd_real( 1.44439074515673149e+00,  9.46361378605603653e-17,
+           8.43256281186079531e-34, -9.17077037613619509e-51),
+  qd_real( 1.60359586182849023e+00, -1.42028061635976074e-17,
+           8.53358798720173848e-34,  7.91559947141955146e-50),
+  qd_real( 1.78034904799561100e+00,  1.99480942674332108e-17,
+          -5.36935187015428539e-34,  3.50333714792102920e-50),
+  qd_real( 1.97658450495420523e+00,  2.26094810253697033e-17,
+          -1.10333856728127944e-33, -8.42439429686652861e-50),
+  qd_real( 1.09722481375873770e+00,  3.18348610641183299e-17,
+          -1.13888639506881043e-33,  3.72785223434508606e-50),
+  qd_real( 1.21816425142499996e+00, -7.03313104974540714e-17,
+           4.20725148050750641e-33,  2.57417601711876351e-49),
+  qd_real( 1.35243399970730294e+00,  9.44179987510778101e-17,
+           2.28524977401278216e-33, -3.39550908583345460e-50),
+  qd_real( 1.50150336576094001e+00,  3.40416471116114884e-17,
+          -1.80099467986749344e-33, -4.59609168292679887e-50),
+  qd_real( 1.66700360821996352e+00,  5.10638548546514294e-17,
+          -3.06584843646675081e-33, -1.69769418443154648e-49),
+  qd_real( 1.85074578797901745e+00, -3.49498619515383603e-17,
+           1.69144393927391904e-33, -3.95529525007857331e-50),
+  qd_real( 1.02737029327116680e+00, -1.00585890743894329e-16,
+          -3.42089150086737195e-33, -6.79387979348809284e-50),
+  qd_real( 1.14061015440554891e+00, -1.10319524808111222e-16,
+           3.03004305169841210e-33, -1.57098017197421990e-50),
+  qd_real( 1.26633165554229521e+00,  5.17396448065929070e-18,
+           1.60225416115419654e-34, -8.65782368114151564e-51),
+  qd_real( 1.40591056079474885e+00,  1.59758572011676683e-17,
+           4.08264246703678457e-34,  3.57774943115844670e-50),
+  qd_real( 1.56087427515799604e+00,  7.73029343688634466e-17,
+           4.45334151995544039e-33,  1.91560024597407390e-49),
+  qd_real( 1.73291855882550938e+00, -9.36020165655009518e-17,
+          -8.24733393030954787e-34, -6.21000193746321002e-50),
+  qd_real( 1.92392608380832408e+00,  9.68519807299388622e-17,
+           3.88621761502105403e-33, -2.06708158452351275e-49),
+  qd_real( 1.06799351796045494e+00,  1.00079423917481712e-16,
+           4.50799973727922532e-33,  3.32244191299896060e-49),
+  qd_real( 1.18571099379011780e+00,  4.57384251063394901e-17,
+           3.01543693202455792e-33, -7.84402258074966607e-50),
+  qd_real( 1.31640364585696479e+00,  4.56716518898325352e-17,
+           1.30322453411898912e-33, -3.71959327301991119e-50),
+  qd_real( 1.46150163733090288e+00,  3.74411339110712686e-17,
+          -1.01514382591990569e-33, -6.65275019027419932e-50),
+  qd_real( 1.62259276829213372e+00, -9.08121524282142960e-17,
+           4.97951422669933551e-34, -3.84867662628174884e-50),
+  qd_real( 1.80143985094819836e+00,  3.76540799683425600e-17,
+          -2.44096252141126331e-33,  1.55854329517159302e-49),
+  qd_real( 1.00000000000000000e+00,  0.00000000000000000e+00,
+           0.00000000000000000e+00,  0.00000000000000000e+00),
+  qd_real( 1.11022302462515654e+00,  0.00000000000000000e+00,
+           0.00000000000000000e+00,  0.00000000000000000e+00),
+  qd_real( 1.23259516440783101e+00, -6.61430558456346015e-17,
+           0.00000000000000000e+00,  0.00000000000000000e+00),
+  qd_real( 1.36845553156720423e+00, -6.00010864512619500e-17,
+           3.85185988877447171e-34,  0.00000000000000000e+00),
+  qd_real( 1.51929083932156783e+00, -3.23919172915614779e-17,
+          -1.86878142756787536e-33,  0.00000000000000000e+00),
+  qd_real( 1.68675167091688372e+00, -4.48842337597107148e-19,
+          -3.45701272006860904e-35,  1.07930575058341845e-51),
+  qd_real( 1.87267054187687942e+00, -9.33744505624520831e-17,
+           3.87611163563032489e-33, -2.94309137936750903e-49),
+  qd_real( 1.03954097656448985e+00,  7.26431913320132834e-17,
+           1.87430491078931719e-33,  1.30820657248096933e-49),
+  qd_real( 1.15412232722321706e+00, -8.67605537879032653e-17,
+          -5.77596188877943375e-33, -2.65425549770581443e-50),
+  qd_real( 1.28133318091718462e+00, -3.04258103763642668e-17,
+           7.84890659843235701e-34, -5.24621137461364298e-50),
+  qd_real( 1.42256559967044960e+00, -9.28708827875618983e-18,
+           5.29684447154688336e-34,  8.55315612745009509e-51),
+  qd_real( 1.57936508279382615e+00, -1.17646597073882048e-17,
+          -5.26691006243501840e-35,  2.05868778584226447e-51),
+  qd_real( 1.75344747920672250e+00, -7.17175452993887946e-17,
+          -1.89570176119971890e-33,  1.33016022810013069e-49),
+  qd_real( 1.94671776388624362e+00,  3.53074841427246620e-17,
+          -1.76779509185130013e-34, -8.05633103877798543e-51),
+  qd_real( 1.08064544195665335e+00,  3.29066963364738892e-17,
+          -2.05467164538851328e-33,  7.30309265341088935e-50),
+  qd_real( 1.19975745111650478e+00, -1.67319539506116229e-17,
+           3.59848286967221783e-34, -1.41644602972321034e-50),
+  qd_real( 1.33199834619513435e+00, -4.01299931617166676e-17,
+          -4.17209276217973701e-34, -1.12971338726586715e-50),
+  qd_real( 1.47881523270846849e+00, -9.68958351707343044e-17,
+           2.81380764658503310e-33,  6.88786393290051839e-50),
+  qd_real( 1.64181472051935051e+00, -1.25278237818076860e-17,
+          -3.11353874369987813e-34,  7.37371718227928647e-51),
+  qd_real( 1.82278050488909926e+00,  1.10727440234177409e-16,
+           3.90062779715301741e-33,  1.99887590242759898e-49),
+  qd_real( 1.01184644268287283e+00,  9.60495675450749395e-17,
+          -4.46838238971104911e-33, -2.37962415903532112e-50),
+  qd_real( 1.12337521805158436e+00, -8.60715799879739736e-17,
+           3.33380530681453017e-33,  1.94757830635085820e-49),
+  qd_real( 1.24719703237417456e+00,  7.83195235446798152e-17,
+          -3.24098123559594949e-33, -1.76369566841490236e-49)
+};
+
+static const int pow10_expn[pow10_jmax - pow10_jmin + 1] = {
+  -1223,-1170,-1117,-1064,-1010, -957, -904, -851, -798, -745,
+   -691, -638, -585, -532, -479, -426, -373, -319, -266, -213,
+   -160, -107,  -54,    0,   53,  106,  159,  212,  265,  318,
+    372,  425,  478,  531,  584,  637,  690,  744,  797,  850,
+    903,  956, 1009, 1063, 1116, 1169
+};
+
+qd_real mul_pwr10(const qd_real &a, int k) {
+  if (k < 16 * pow10_jmin || k >= 16 * (pow10_jmax + 1)) {
+    /* Beyond the table; any nonzero a over- or underflows long
+       before |k| reaches 1000. */
+    if (k > 1000) k = 1000;
+    if (k < -1000) k = -1000;
+    return mul_pwr10(mul_pwr10(a, k / 2), k - k / 2);
+  }
+
+  int j = (k >= 0) ? k / 16 : -((15 - k) / 16);
+  int i = k - 16 * j;
+  j -= pow10_jmin;
+
+  /* Apply the power of two first when scaling up, so that a tiny a is
+     not multiplied in the subnormal range, and last when scaling down,
+     unless a is so large that the mantissa factors, up to 2^75, would
+     overflow first. */
+  int e = pow10_expn[j];
+  if (e > 0 || std::ilogb(a[0]) > 900)
+    return (ldexp(a, e) * pow10_block[j]) * exact_pwr10[i];
+  return ldexp((a * pow10_block[j]) * exact_pwr10[i], e);
+}
+
+dd_real mul_pwr10(const dd_real &a, int k) {
+  if (k < 16 * pow10_jmin || k >= 16 * (pow10_jmax + 1)) {
+    if (k > 1000) k = 1000;
+    if (k < -1000) k = -1000;
+    return mul_pwr10(mul_pwr10(a, k / 2), k - k / 2);
+  }
+
+  int j = (k >= 0) ? k / 16 : -((15 - k) / 16);
+  int i = k - 16 * j;
+  j -= pow10_jmin;
+  dd_real m(pow10_block[j][0], pow10_block[j][1]);
+  int e = pow10_expn[j];
+  if (e > 0 || std::ilogb(a.x[0]) > 900)
+    return (ldexp(a, e) * m) * exact_pwr10[i];
+  return ldexp((a * m) * exact_pwr10[i], e);
+}
+
+const char *scan_decimal(const char *p, const char *end, 
+                         decimal_chunks &d, int max_chunks) {
+  uint64_t c = 0;   /* chunk being read */
+  int nc = 0;       /* digits in c */
+  int nd = 0;       /* significant digits kept */
+  int zeros = 0;    /* zeros held back */
+  bool point = false;
+  double scale = 1.0;
+
+  d.nchunks = 0;
+  d.expn = 0;
+  d.negative = false;
+
+  while (p < end && *p == ' ') p++;
+  if (p < end && (*p == '-' || *p == '+')) {
+    d.negative = (*p == '-');
+    p++;
+  }
+
+  const char *digits = p;
+  for (; p < end; p++) {
+    char ch = *p;
+    if (ch == '.') {
+      if (point)
+        break;
+      point = true;
+      continue;
+    }
+    if (ch < '0' || ch > '9')
+      break;
+
+    if (ch == '0') {
+      /* Leading zeros are dropped.  Other zeros are held back until
+         a nonzero digit follows, so that trailing zeros do not
+         change the chunks and the value read depends only on the
+         significant digits.                                      */
+      if (nd == 0) {
+        if (point) d.expn--;
+      } else {
+        zeros++;
+        if (!point) d.expn++;
+      }
+      continue;
+    }
+
+    if (d.nchunks == max_chunks) {
+      /* beyond the working precision */
+      if (!point) d.expn++;
+      continue;
+    }
+
+    for (;;) {
+      int digit = (zeros > 0) ? 0 : (ch - '0');
+      c = c * 10 + static_cast<uint64_t>(digit);
+      scale *= 10.0;
+      nd++;
+      d.expn--;
+      if (++nc == 19) {
+        d.chunk[d.nchunks++] = c;
+        d.last_scale = scale;
+        c = 0;
+        nc = 0;
+        scale = 1.0;
+      }
+      if (zeros == 0)
+        break;
+      zeros--;
+      if (d.nchunks == max_chunks) {
+        /* ch is beyond the working precision */
+        zeros = 0;
+        break;
+      }
+    }
+    if (!point) d.expn++;
+  }
+
+  /* Need at least one digit. */
+  if (p == digits || (p == digits + 1 && point))
+    return 0;
+
+  if (nc > 0) {
+    d.chunk[d.nchunks++] = c;
+    d.last_scale = scale;
+  }
+
+  /* Exponent.  It is part of the number only if digits follow. */
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool neg = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      neg = (*q == '-');
+      q++;
+    }
+    if (q < end && *q >= '0' && *q <= '9') {
+      int e = 0;
+      for (; q < end && *q >= '0' && *q <= '9'; q++) {
+        if (e < 100000)
+          e = e * 10 + (*q - '0');
+      }
+      d.expn += neg ? -e : e;
+      p = q;
+    }
+  }
+
+  return p;
+}
+
+bool ends_with_exponent(const char *s, const char *p) {
+  const char *q = p;
+  while (q > s && q[-1] >= '0' && q[-1] <= '9')
+    q--;
+  if (q == p)
+    return false;
+  if (q > s && (q[-1] == '-' || q[-1] == '+'))
+    q--;
+  return q > s && (q[-1] == 'e' || q[-1] == 'E');
+}
+
+int round_digits(char *s, int len, int n, int &expn) {
+  if (n >= len)
+    return len;
+  if (n < 0)
+    return 0;
+  if (n == 0) {
+    if (s[0] < '5')
+      return 0;
+    s[0] = '1';
+    expn++;
+    return 1;
+  }
+
+  if (s[n] >= '5') {
+    int i = n - 1;
+    while (i >= 0 && s[i] == '9')
+      s[i--] = '0';
+    if (i >= 0) {
+      s[i]++;
+    } else {
+      /* 99...9 rounds up to 100...0 */
+      s[0] = '1';
+      expn++;
+    }
+  }
+  return n;
+}
+
+/* Writes one limb in the form [-]0x1.hhhp+d. */
+static char *write_hex_limb(char *p, double x, bool uppercase) {
+  static const char lower[] = "0123456789abcdef";
+  static const char upper[] = "0123456789ABCDEF";
+  const char *digits = uppercase ? upper : lower;
+  uint64_t u;
+  std::memcpy(&u, &x, sizeof(u));
+
+  if (u >> 63)
+    *p++ = '-';
+  *p++ = '0';
+  *p++ = uppercase ? 'X' : 'x';
+
+  int e = static_cast<int>((u >> 52) & 0x7ff);
+  uint64_t m = u & ((static_cast<uint64_t>(1) << 52) - 1);
+  if (e == 0 && m == 0) {
+    *p++ = '0';
+  } else {
+    if (e == 0) {
+      /* Subnormal; normalize so that the leading digit is 1. */
+      e = 1;
+      while (!(m >> 52)) {
+        m <<= 1;
+        e--;
+      }
+      m &= (static_cast<uint64_t>(1) << 52) - 1;
+    }
+    e -= 1023;
+    *p++ = '1';
+    if (m != 0) {
+      *p++ = '.';
+      for (int shift = 48; m != 0; shift -= 4) {
+        *p++ = digits[(m >> shift) & 0xf];
+        m &= (static_cast<uint64_t>(1) << shift) - 1;
+      }
+    }
+  }
+
+  *p++ = uppercase ? 'P' : 'p';
+  *p++ = (e < 0) ? '-' : '+';
+  e = std::abs(e);
+  char t[8];
+  int k = 0;
+  do {
+    t[k++] = static_cast<char>('0' + e % 10);
+    e /= 10;
+  } while (e != 0);
+  while (k > 0)
+    *p++ = t[--k];
+  return p;
+}
+
+char *write_hex(char *first, char *last, const double *x, int n,
+                bool uppercase) {
+  char t[max_hex_chars];
+  char *p = write_hex_limb(t, x[0], uppercase);
+  for (int i = 1; i < n && x[i] != 0.0; i++) {
+    if (!std::signbit(x[i]))
+      *p++ = '+';
+    p = write_hex_limb(p, x[i], uppercase);
+  }
+
+  if (last - first < p - t)
+    return 0;
+  std::memcpy(first, t, p - t);
+  return first + (p - t);
+}
+
+static inline int hex_digit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* Scans one limb [+-]0xh.hhh[p[+-]d] from [p, end). */
+static const char *scan_hex_limb(const char *p, const char *end, double &x) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    p++;
+  }
+  if (end - p < 2 || p[0] != '0' || (p[1] != 'x' && p[1] != 'X'))
+    return 0;
+  p += 2;
+
+  /* Keep 61 bits of the significand; the bits past them only matter
+     through the lowest bit (round to odd), so the conversion to
+     double below rounds correctly. */
+  uint64_t m = 0;
+  bool sticky = false, point = false, any = false;
+  long e = 0;
+  for (; p < end; p++) {
+    int d;
+    if (*p == '.' && !point) {
+      point = true;
+      continue;
+    }
+    if ((d = hex_digit(*p)) < 0)
+      break;
+    any = true;
+    if (m < (static_cast<uint64_t>(1) << 57)) {
+      m = (m << 4) | d;
+      if (point) e -= 4;
+    } else {
+      sticky |= (d != 0);
+      if (!point) e += 4;
+    }
+  }
+  if (!any)
+    return 0;
+
+  if (p < end && (*p == 'p' || *p == 'P')) {
+    const char *q = p + 1;
+    bool neg = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      neg = (*q == '-');
+      q++;
+    }
+    if (q < end && *q >= '0' && *q <= '9') {
+      long k = 0;
+      for (; q < end && *q >= '0' && *q <= '9'; q++)
+        if (k < 100000) k = k * 10 + (*q - '0');
+      e += neg ? -k : k;
+      p = q;
+    }
+  }
+
+  if (sticky)
+    m |= 1;
+  if (e < -100000) e = -100000;
+  if (e > 100000) e = 100000;
+  x = std::ldexp(static_cast<double>(m), static_cast<int>(e));
+  if (negative)
+    x = -x;
+  return p;
+}
+
+const char *scan_hex(const char *p, const char *end, double *x,
+                     int max_limbs, int &n) {
+  n = 0;
+  while (p < end && *p == ' ') p++;
+  p = scan_hex_limb(p, end, x[0]);
+  if (p == 0)
+    return 0;
+  n = 1;
+
+  /* Further limbs carry their own sign. */
+  while (n < max_limbs && p < end && (*p == '+' || *p == '-')) {
+    const char *q = scan_hex_limb(p, end, x[n]);
+    if (q == 0)
+      break;
+    p = q;
+    n++;
+  }
+  return p;
+}
+
+#if QD_HAVE_CXX17
+std::to_chars_result write_digits(char *first, char *last, bool negative,
+                                  const char *s, int n, int expn,
+                                  bool scientific, int precision) {
+  char *p = first;
+  int i, frac;
+
+  if (n == 0)
+    expn = 0;
+
+  /* Number of characters, to check the space once. */
+  int len = negative ? 1 : 0;
+  if (scientific) {
+    frac = (precision < 0) ? n - 1 : precision;
+    len += 1 + (frac > 0 ? frac + 1 : 0) + 2 + (std::abs(expn) >= 100 ? 3 : 2);
+  } else {
+    frac = (precision < 0) ? std::max(0, n - 1 - expn) : precision;
+    len += std::max(expn + 1, 1) + (frac > 0 ? frac + 1 : 0);
+  }
+  if (last - first < len)
+    return {last, std::errc::value_too_large};
+
+  if (negative)
+    *p++ = '-';
+
+  if (scientific) {
+    *p++ = (n > 0) ? s[0] : '0';
+    if (frac > 0) {
+      *p++ = '.';
+      for (i = 1; i <= frac; i++)
+        *p++ = (i < n) ? s[i] : '0';
+    }
+    *p++ = 'e';
+    *p++ = (expn < 0) ? '-' : '+';
+    int e = std::abs(expn);
+    if (e >= 100) {
+      *p++ = static_cast<char>('0' + e / 100);
+      e %= 100;
+    }
+    *p++ = static_cast<char>('0' + e / 10);
+    *p++ = static_cast<char>('0' + e % 10);
+  } else {
+    if (expn < 0) {
+      *p++ = '0';
+    } else {
+      for (i = 0; i <= expn; i++)
+        *p++ = (i < n) ? s[i] : '0';
+    }
+    if (frac > 0) {
+      *p++ = '.';
+      for (i = expn + 1; i <= expn + frac; i++)
+        *p++ = (i >= 0 && i < n) ? s[i] : '0';
+    }
+  }
+
+  return {p, std::errc()};
+}
+#endif
@@ -1,4 +1,210 @@
 #include <string>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <stdint.h>
+#include <qd/qd_config.h>
+#if QD_HAVE_CXX17
+#include <charconv>
+#include <string_view>
+#endif
+
+struct dd_real;
+struct qd_real;
 
 void append_expn(std::string &str, int expn);
 
+/* 10^0, ..., 10^22, which are exact in double precision. */
+extern const double exact_pwr10[23];
+
+/* Multiplies a by 10^k using a precomputed table of powers of ten.
+   The result has a relative error of a few eps, independent of k. */
+dd_real mul_pwr10(const dd_real &a, int k);
+qd_real mul_pwr10(const qd_real &a, int k);
+
+/* The significant digits of a decimal number, gathered in chunks of
+   up to 19 digits.  Its value is
+
+     (-1)^negative * (chunk[0] chunk[1] ... chunk[nchunks-1]) * 10^expn,
+
+   where the chunks are concatenated as digit strings.  last_scale is
+   10 to the number of digits in the last chunk.                   */
+struct decimal_chunks {
+  static const int max_chunks = 4;
+  uint64_t chunk[max_chunks];
+  int nchunks;
+  double last_scale;
+  int expn;
+  bool negative;
+};
+
+/* Scans an optionally signed decimal number with optional fraction and
+   exponent from [p, end), keeping at most max_chunks chunks of digits.
+   Leading spaces are skipped.  Returns a pointer past the last
+   character of the number, or 0 if there is no number at p.       */
+const char *scan_decimal(const char *p, const char *end, 
+                         decimal_chunks &d, int max_chunks);
+
+/* True if the number [s, p) ends with a decimal exponent: e or E, an
+   optional sign and digits.  The readers of QD 2.3 ignored any text
+   after one, and read still does.                                 */
+bool ends_with_exponent(const char *s, const char *p);
+
+/* Largest number of digits produced by decimal_digits (four blocks
+   of 19 digits). */
+const int max_decimal_digits = 76;
+
+/* Writes the leading decimal digits of the nonzero finite number |a|
+   to s, without rounding, and sets expn to its decimal exponent, so
+   that |a| = s[0].s[1]s[2]... * 10^expn.  The digits are produced in
+   blocks of 19 from 64-bit integers.  Returns the number of digits,
+   38 for dd_real and 76 for qd_real.                              */
+int decimal_digits(const dd_real &a, char *s, int &expn);
+int decimal_digits(const qd_real &a, char *s, int &expn);
+
+/* Rounds the len digits in s to n digits (half up), adjusting expn
+   if the carry produces a new leading digit.  Returns the number of
+   digits left, which is min(n, len), 1 if n == 0 and the value
+   rounds up to 10^(expn+1), or 0 if the value rounds to zero.     */
+int round_digits(char *s, int len, int n, int &expn);
+
+/* Longest hexadecimal form of four limbs, as -0x1.fffffffffffffp-1074
+   (24 characters) each. */
+const int max_hex_chars = 96;
+
+/* Writes x[0] + ... + x[n-1] to [first, last) as hexadecimal
+   floating-point limbs in the form of printf's %a, each limb after
+   the first starting with its sign, as in 0x1.8p+0-0x1p-60.  Zero
+   limbs after the first are left out.  Returns a pointer past the
+   last character written, or 0 if the output does not fit.        */
+char *write_hex(char *first, char *last, const double *x, int n,
+                bool uppercase);
+
+/* Scans up to max_limbs hexadecimal limbs as written by write_hex
+   from [p, end) into x and sets n to their number.  Leading spaces
+   are skipped.  Returns a pointer past the last character used, or 0
+   if there is no hexadecimal number at p.                         */
+const char *scan_hex(const char *p, const char *end, double *x,
+                     int max_limbs, int &n);
+
+#if QD_HAVE_CXX17
+/* Writes the number (-1)^negative * s[0].s[1]...s[n-1] * 10^expn to
+   [first, last) in scientific or fixed notation, with precision digits
+   after the point, or just the digits in s if precision < 0.  Digits
+   past n are zeros; n == 0 means the value is zero.               */
+std::to_chars_result write_digits(char *first, char *last, bool negative,
+                                  const char *s, int n, int expn,
+                                  bool scientific, int precision);
+
+/* Shared implementation of to_chars for dd_real and qd_real.  A
+   negative precision asks for the fewest digits that read back to a;
+   fmt == 0 also chooses the shorter of fixed and scientific
+   notation.  Hexadecimal output is exact and ignores precision.   */
+template <class T>
+std::to_chars_result to_chars_decimal(char *first, char *last, 
+                                      const T &a, int fmt, int precision) {
+  const int scientific = static_cast<int>(std::chars_format::scientific);
+  const int fixed = static_cast<int>(std::chars_format::fixed);
+  const int general = static_cast<int>(std::chars_format::general);
+  double hi = to_double(a);
+  char s[max_decimal_digits];
+  char t[max_decimal_digits + 16];
+  int n, len, expn = 0;
+
+  const int hex = static_cast<int>(std::chars_format::hex);
+  if (fmt != 0 && fmt != scientific && fmt != fixed && fmt != general &&
+      fmt != hex)
+    return {last, std::errc::invalid_argument};
+
+  if (std::isnan(hi) || std::isinf(hi)) {
+    const char *str = std::isnan(hi) ? "nan" : (hi < 0.0 ? "-inf" : "inf");
+    size_t k = std::strlen(str);
+    if (last - first < static_cast<std::ptrdiff_t>(k))
+      return {last, std::errc::value_too_large};
+    std::memcpy(first, str, k);
+    return {first + k, std::errc()};
+  }
+
+  if (fmt == hex) {
+    char *p = write_hex(first, last, a.x, sizeof(a.x) / sizeof(a.x[0]),
+                        false);
+    if (p == 0)
+      return {last, std::errc::value_too_large};
+    return {p, std::errc()};
+  }
+
+  bool negative = std::signbit(hi);
+  if (hi == 0.0) {
+    s[0] = '0';
+    len = 1;
+  } else {
+    len = decimal_digits(a, s, expn);
+  }
+
+  if (precision >= 0) {
+    if (fmt == fixed) {
+      n = round_digits(s, len, expn + 1 + precision, expn);
+      return write_digits(first, last, negative, s, n, expn, false, precision);
+    }
+    if (fmt == general) {
+      int p = (precision == 0) ? 1 : precision;
+      n = round_digits(s, len, p, expn);
+      while (n > 1 && s[n-1] == '0') n--;
+      bool sci = (expn < -4 || expn >= p);
+      return write_digits(first, last, negative, s, n, expn, sci, -1);
+    }
+    n = round_digits(s, len, precision + 1, expn);
+    return write_digits(first, last, negative, s, n, expn, true, precision);
+  }
+
+  /* Shortest within eps.  Binary search for the fewest significant
+     digits that read back to a to within T::_eps relative error;
+     parsing is not correctly rounded, so exact equality of the
+     limbs is too strict.  Computed values usually need close to
+     T::_ndigits digits, so that is probed first.                */
+  n = len;
+  if (hi != 0.0) {
+    char u[max_decimal_digits];
+    int lo = 1, hi_n = std::min(len, T::_ndigits + 4);
+    int mid = T::_ndigits - 1;
+
+    n = hi_n;
+    while (lo <= hi_n) {
+      int e = expn;
+      std::memcpy(u, s, len);
+      int m = round_digits(u, len, mid, e);
+      std::to_chars_result r = write_digits(t, t + sizeof(t), negative,
+                                            u, m, e, true, -1);
+      T b;
+      if (T::parse(std::string_view(t, r.ptr - t), b) != 0 &&
+          std::abs(to_double(b - a)) <= T::_eps * std::abs(hi)) {
+        n = mid;
+        hi_n = mid - 1;
+      } else {
+        lo = mid + 1;
+      }
+      mid = (lo + hi_n) / 2;
+    }
+    n = round_digits(s, len, n, expn);
+  }
+  while (n > 1 && s[n-1] == '0') n--;
+
+  bool sci;
+  if (fmt == scientific) {
+    sci = true;
+  } else if (fmt == fixed) {
+    sci = false;
+  } else if (fmt == general) {
+    sci = (expn < -4 || expn >= n);
+  } else {
+    /* Shorter of the two, counting the point and exponent. */
+    int ae = std::abs(expn);
+    int sci_len = n + (n > 1) + 2 + (ae >= 100 ? 3 : 2);
+    int fix_len = (expn >= 0) ? std::max(n, expn + 1) + (n > expn + 1)
+                              : n + 1 - expn;
+    sci = (sci_len < fix_len);
+  }
+  return write_digits(first, last, negative, s, n, expn, sci, -1);
+}
+#endif
@@ -67,7 +67,30 @@ int test_1() {
   return 0;
 }
 
+/* Test 2.  Hexadecimal output reads back exactly. */
+int test_2() {
+  double a[4], b[4];
+  char s[128];
+  int i;
+
+  puts("Test 2.  (Hexadecimal round trip)");
+
+  c_qd_pi(a);
+  c_qd_selfdiv_d(7.0, a);
+  c_qd_swrite_hex(a, s, sizeof(s));
+  c_qd_read(s, b);
+  printf("  %s\n", s);
+
+  for (i = 0; i < 4; i++)
+    if (a[i] != b[i])
+      return 1;
+  return 0;
+}
+
 int main(void) {
+  int r;
   fpu_fix_start(NULL);
-  return test_1();
+  r = test_1();
+  r |= test_2();
+  return r;
 }
@@ -0,0 +1,231 @@
+/*
+ * tests/io_test.cpp
+ *
+ * Tests for the bulk input and output routines in qd_io.h.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <qd/qd_io.h>
+#include <qd/fpu.h>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::strcmp;
+
+bool flag_verbose = false;
+
+static const char *tmp_file = "io_test.tmp";
+
+bool print_result(bool result) {
+  if (result)
+    cout << "Test passed." << endl;
+  else
+    cout << "Test FAILED." << endl;
+  return result;
+}
+
+/* Some numbers that use all limbs. */
+template <class T>
+std::vector<T> test_data(size_t n) {
+  std::vector<T> a(n);
+  for (size_t i = 0; i < n; i++)
+    a[i] = T::_pi * static_cast<double>(i + 1) / 7.0 - 3.0;
+  return a;
+}
+
+/* Test 1.  Binary arrays in the native layout map in place. */
+bool test1() {
+  cout << endl;
+  cout << "Test 1.  (Binary arrays, array of structures)." << endl;
+
+  std::vector<qd_real> a = test_data<qd_real>(10000);
+  if (qd_write_array(tmp_file, &a[0], a.size()) != 0)
+    return false;
+
+  qd_mapped_array m;
+  if (m.open(tmp_file) != 0)
+    return false;
+
+  const qd_real *p = m.qd_data();
+  bool pass = (p != 0 && m.size() == a.size() && m.dd_data() == 0 &&
+               m.limb(0) == 0);
+  for (size_t i = 0; pass && i < a.size(); i++)
+    pass = (p[i] == a[i]);
+
+  /* Loading into dd_real keeps the two leading limbs. */
+  std::vector<dd_real> b(m.size());
+  pass &= (m.load(&b[0]) == 0);
+  for (size_t i = 0; pass && i < a.size(); i++)
+    pass = (b[i].x[0] == a[i][0] && b[i].x[1] == a[i][1]);
+
+  m.close();
+  std::remove(tmp_file);
+  return pass;
+}
+
+/* Test 2.  Structure of arrays layout. */
+bool test2() {
+  cout << endl;
+  cout << "Test 2.  (Binary arrays, structure of arrays)." << endl;
+
+  std::vector<dd_real> a = test_data<dd_real>(5000);
+  if (qd_write_array(tmp_file, &a[0], a.size(), qd_array_soa) != 0)
+    return false;
+
+  qd_mapped_array m;
+  if (m.open(tmp_file) != 0)
+    return false;
+
+  const double *hi = m.limb(0), *lo = m.limb(1);
+  bool pass = (hi != 0 && lo != 0 && m.limb(2) == 0 && m.dd_data() == 0);
+  for (size_t i = 0; pass && i < a.size(); i++)
+    pass = (hi[i] == a[i].x[0] && lo[i] == a[i].x[1]);
+
+  /* Loading into qd_real zero fills the missing limbs. */
+  std::vector<qd_real> b(m.size());
+  pass &= (m.load(&b[0]) == 0);
+  for (size_t i = 0; pass && i < a.size(); i++)
+    pass = (b[i] == qd_real(a[i].x[0], a[i].x[1], 0.0, 0.0));
+
+  m.close();
+  std::remove(tmp_file);
+  return pass;
+}
+
+/* Test 3.  Invalid and truncated files are rejected. */
+bool test3() {
+  cout << endl;
+  cout << "Test 3.  (Binary arrays, invalid files)." << endl;
+
+  qd_mapped_array m;
+  bool pass = (m.open("io_test.missing") != 0 && !m.is_open());
+
+  std::vector<qd_real> a = test_data<qd_real>(100);
+  qd_write_array(tmp_file, &a[0], a.size());
+
+  /* Drop the last element. */
+  std::vector<char> buf(sizeof(qd_array_header) + 99 * sizeof(qd_real));
+  std::FILE *f = std::fopen(tmp_file, "rb");
+  pass &= (f != 0 && std::fread(&buf[0], 1, buf.size(), f) == buf.size());
+  if (f) std::fclose(f);
+  f = std::fopen(tmp_file, "wb");
+  pass &= (f != 0 && std::fwrite(&buf[0], 1, buf.size(), f) == buf.size());
+  if (f) std::fclose(f);
+  pass &= (m.open(tmp_file) != 0);
+
+  /* Corrupt the magic number. */
+  buf[0] = 'X';
+  f = std::fopen(tmp_file, "wb");
+  pass &= (f != 0 && std::fwrite(&buf[0], 1, buf.size(), f) == buf.size());
+  if (f) std::fclose(f);
+  pass &= (m.open(tmp_file) != 0);
+
+  std::remove(tmp_file);
+  return pass;
+}
+
+/* Test 4.  Text files are read in parallel. */
+bool test4() {
+  cout << endl;
+  cout << "Test 4.  (Text files)." << endl;
+
+  /* Enough numbers that the file is split between threads. */
+  std::vector<qd_real> a = test_data<qd_real>(20000);
+  std::FILE *f = std::fopen(tmp_file, "w");
+  if (f == 0)
+    return false;
+  for (size_t i = 0; i < a.size(); i++)
+    std::fprintf(f, (i % 3 == 2) ? "%s\n" : "%s ",
+                 a[i].to_string(qd_real::_ndigits).c_str());
+  std::fclose(f);
+
+  std::vector<qd_real> b;
+  bool pass = (qd_read_text(tmp_file, b, 0, 4) == 0 && b.size() == a.size());
+  for (size_t i = 0; pass && i < a.size(); i++) {
+    qd_real c;
+    qd_real::read(a[i].to_string(qd_real::_ndigits).c_str(), c);
+    pass = (b[i] == c);
+  }
+  std::remove(tmp_file);
+
+  /* Errors are reported by line and column. */
+  const char text[] = "1.5 2.5\n\t-3e2 x4\n\n0.25 1e 7\n";
+  std::vector<dd_real> d;
+  std::vector<qd_text_error> err;
+  pass &= (qd_parse_text(text, sizeof(text) - 1, d, &err) == -1);
+  pass &= (d.size() == 7 && d[2] == -300.0 && d[4] == 0.25 && d[6] == 7.0);
+  pass &= (err.size() == 2 && isnan(d[3]) && isnan(d[5]));
+  if (err.size() == 2) {
+    pass &= (err[0].index == 3 && err[0].line == 2 && err[0].column == 7);
+    pass &= (err[1].index == 5 && err[1].line == 4 && err[1].column == 6);
+  }
+  if (flag_verbose) {
+    for (size_t i = 0; i < err.size(); i++)
+      cout << "  invalid number " << err[i].index << " at line "
+           << err[i].line << ", column " << err[i].column << endl;
+  }
+
+  pass &= (qd_read_text("io_test.missing", b) == -1);
+  return pass;
+}
+
+/* Test 5.  Text files are written in parallel. */
+bool test5() {
+  cout << endl;
+  cout << "Test 5.  (Writing text files)." << endl;
+
+  std::vector<qd_real> a = test_data<qd_real>(20000), b;
+  qd_text_format f;
+  f.nthreads = 4;
+  bool pass = (qd_write_text(tmp_file, &a[0], a.size(), f) == 0);
+  pass &= (qd_read_text(tmp_file, b) == 0 && b.size() == a.size());
+  for (size_t i = 0; pass && i < a.size(); i++)
+    pass = (abs(b[i] - a[i]) <= qd_real::_eps * abs(a[i]));
+  std::remove(tmp_file);
+
+  /* Columns with a fixed number of digits. */
+  dd_real x[2] = { 1.5, -2.0 };
+  dd_real y[2] = { dd_real(1.0) / 3.0, 1000.0 };
+  const dd_real *cols[2] = { x, y };
+  std::FILE *file = std::tmpfile();
+  if (file == 0)
+    return false;
+  pass &= (qd_write_text(file, cols, 2, 2,
+                         qd_text_format(3, qd_text_fixed, ',')) == 0);
+  char buf[64] = "";
+  std::rewind(file);
+  size_t len = std::fread(buf, 1, sizeof(buf) - 1, file);
+  buf[len] = '\0';
+  std::fclose(file);
+  if (flag_verbose)
+    cout << buf;
+  pass &= (strcmp(buf, "1.500,0.333\n-2.000,1000.000\n") == 0);
+  return pass;
+}
+
+int main(int argc, char *argv[]) {
+  bool pass = true;
+  unsigned int old_cw;
+  fpu_fix_start(&old_cw);
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "-verbose") == 0)
+      flag_verbose = true;
+    else
+      cerr << "Unknown flag `" << argv[i] << "'." << endl;
+  }
+
+  pass &= print_result(test1());
+  pass &= print_result(test2());
+  pass &= print_result(test3());
+  pass &= print_result(test4());
+  pass &= print_result(test5());
+
+  fpu_fix_end(&old_cw);
+  return (pass ? 0 : 1);
+}
@@ -0,0 +1,555 @@
+/*
+ * tests/mandel_test.cpp
+ *
+ * Tests for the Mandelbrot renderer in mandelbrot.h.
+ */
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <qd/mandelbrot.h>
+#include <qd/fpu.h>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::strcmp;
+
+bool flag_verbose = false;
+
+bool print_result(bool result) {
+  if (result)
+    cout << "Test passed." << endl;
+  else
+    cout << "Test FAILED." << endl;
+  return result;
+}
+
+/* Smooth iteration count of c, iterating z directly in T. */
+template <class T>
+float direct_count(const T &cr, const T &ci, int max_iter, double bailout) {
+  T x = 0.0, y = 0.0;
+  double b2 = bailout * bailout;
+  for (int n = 0; n <= max_iter; n++) {
+    double r2 = to_double(sqr(x) + sqr(y));
+    if (r2 > b2)
+      return static_cast<float>(n + 1 -
+          std::log2(0.5 * std::log(r2) / std::log(bailout)));
+    T xy = x * y;
+    x = sqr(x) - sqr(y) + cr;
+    y = mul_pwr2(xy, 2.0) + ci;
+  }
+  return qd_mandel_interior;
+}
+
+double direct_count(double cr, double ci, int max_iter, double bailout) {
+  double x = 0.0, y = 0.0, b2 = bailout * bailout;
+  for (int n = 0; n <= max_iter; n++) {
+    double r2 = x * x + y * y;
+    if (r2 > b2)
+      return n + 1 - std::log2(0.5 * std::log(r2) / std::log(bailout));
+    double t = x * x - y * y + cr;
+    y = 2.0 * x * y + ci;
+    x = t;
+  }
+  return qd_mandel_interior;
+}
+
+bool same_count(double a, double b) {
+  return std::fabs(a - b) < 1e-3 * std::fmax(1.0, std::fabs(b));
+}
+
+/* Compares the pixels (x, y) with x, y multiples of step with the
+   counts obtained by iterating c in T.                            */
+template <class T>
+int count_mismatches(const qd_mandel_view &v, const std::vector<float> &counts,
+                     int step, double bailout) {
+  double pixel = 2.0 * v.radius / v.width;
+  int bad = 0;
+  for (int y = 0; y < v.height; y += step)
+    for (int x = 0; x < v.width; x += step) {
+      T cr = T(v.re) + (x + 0.5 - 0.5 * v.width) * pixel;
+      T ci = T(v.im) + (0.5 * v.height - y - 0.5) * pixel;
+      float ref = direct_count(cr, ci, v.max_iter, bailout);
+      float got = counts[y * v.width + x];
+      if (!same_count(got, ref)) {
+        if (flag_verbose)
+          cout << "  pixel (" << x << ", " << y << "): " << got
+               << " expected " << ref << endl;
+        bad++;
+      }
+    }
+  return bad;
+}
+
+/* Test 1.  At shallow zoom perturbation agrees with plain double. */
+bool test1() {
+  cout << endl;
+  cout << "Test 1.  (Perturbation at shallow zoom)." << endl;
+
+  qd_mandel_view v(-0.5, 0.0, 1.5, 120, 90, 500);
+  std::vector<float> counts;
+  qd_mandel_stats stats;
+  if (qd_mandel_render(v, counts, qd_mandel_options(), &stats) != 0)
+    return false;
+
+  double pixel = 2.0 * v.radius / v.width;
+  int bad = 0;
+  for (int y = 0; y < v.height; y++)
+    for (int x = 0; x < v.width; x++) {
+      double ref = direct_count((x + 0.5 - 0.5 * v.width) * pixel - 0.5,
+                                (0.5 * v.height - y - 0.5) * pixel,
+                                v.max_iter, 256.0);
+      bad += !same_count(counts[y * v.width + x], ref);
+    }
+  if (flag_verbose)
+    cout << "  " << bad << " of " << counts.size() << " pixels differ" << endl;
+
+  /* Chaotic pixels near the boundary may round differently. */
+  bool pass = bad * 200 < static_cast<int>(counts.size()) &&
+              stats.iterations > 0 && stats.reference_length == v.max_iter;
+
+  /* An exterior center: pixels that outlive the reference continue
+     in double without glitch detection or series.                  */
+  qd_mandel_view w(0.26, 0.0, 0.02, 64, 48, 1000);
+  qd_mandel_options opt;
+  opt.glitch_tolerance = 0.0;
+  opt.series_terms = 0;
+  qd_mandel_stats ws;
+  qd_mandel_render(w, counts, opt, &ws);
+  pixel = 2.0 * w.radius / w.width;
+  int outlived = 0;
+  bad = 0;
+  for (int y = 0; y < w.height; y++)
+    for (int x = 0; x < w.width; x++) {
+      double ref = direct_count((x + 0.5 - 0.5 * w.width) * pixel + 0.26,
+                                (0.5 * w.height - y - 0.5) * pixel,
+                                w.max_iter, 256.0);
+      bad += !same_count(counts[y * w.width + x], ref);
+      outlived += (ref < 0.0 || ref > ws.reference_length + 1);
+    }
+  if (flag_verbose)
+    cout << "  exterior center: " << bad << " of " << counts.size()
+         << " pixels differ, " << outlived << " outlive the reference"
+         << endl;
+  return pass && outlived > 0 && ws.reference_length < w.max_iter &&
+         bad * 200 < static_cast<int>(counts.size());
+}
+
+/* Test 2.  Deep zoom: pixels 3e-22 apart, far below double precision,
+   agree with iterating each pixel in qd_real.                      */
+bool test2() {
+  cout << endl;
+  cout << "Test 2.  (Deep zoom against qd_real)." << endl;
+
+  qd_mandel_view v(qd_real("-0.743643887037158704752191506114774"),
+                   qd_real("0.131825904205311970493132056385139"),
+                   1e-20, 64, 48, 16000);
+  std::vector<float> counts;
+  qd_mandel_stats stats;
+  if (qd_mandel_render(v, counts, qd_mandel_options(), &stats) != 0)
+    return false;
+
+  int bad = count_mismatches<qd_real>(v, counts, 8, 256.0);
+  if (flag_verbose)
+    cout << "  " << stats.iterations << " iterations, "
+         << stats.iterations_per_second() << " per second, reference "
+         << stats.reference_seconds << " s" << endl;
+
+  /* Neighbouring pixels differ, so the image is not degenerate. */
+  return bad == 0 && counts[0] != counts[counts.size() - 1];
+}
+
+/* Test 3.  Invalid views are rejected. */
+bool test3() {
+  cout << endl;
+  cout << "Test 3.  (Invalid views)." << endl;
+
+  std::vector<float> counts;
+  return qd_mandel_render(qd_mandel_view(0.0, 0.0, 0.0), counts) == -1 &&
+         qd_mandel_render(qd_mandel_view(0.0, 0.0, 1.0, 0, 10), counts) == -1 &&
+         qd_mandel_render(qd_mandel_view(), counts,
+                          qd_mandel_options(256.0, 0, 8, 1e-12, 1e-3, 0))
+             == -1;
+}
+
+/* Test 4.  The series approximation skips iterations without changing
+   the image, and its polynomial matches iterating the deltas.       */
+bool test4() {
+  cout << endl;
+  cout << "Test 4.  (Series approximation)." << endl;
+
+  qd_mandel_view v(qd_real("-0.743643887037158704752191506114774"),
+                   qd_real("0.131825904205311970493132056385139"),
+                   1e-20, 64, 48, 16000);
+  std::vector<float> with, without;
+  qd_mandel_stats s1, s2;
+  qd_mandel_options opt;
+  if (qd_mandel_render(v, with, opt, &s1) != 0)
+    return false;
+  opt.series_terms = 0;
+  if (qd_mandel_render(v, without, opt, &s2) != 0)
+    return false;
+
+  int bad = 0;
+  for (size_t i = 0; i < with.size(); i++)
+    bad += !same_count(with[i], without[i]);
+  if (flag_verbose)
+    cout << "  skipped " << s1.series_skip << " of "
+         << s1.reference_length << " iterations, " << s1.iterations
+         << " against " << s2.iterations << ", " << bad
+         << " pixels differ" << endl;
+
+  /* dz(skip) of one point against iterating it, in qd_real. */
+  qd_mandel_orbit orbit;
+  orbit.compute(v.re, v.im, v.max_iter, 256.0);
+  qd_mandel_series series;
+  double radius = 1e-20;
+  series.compute(orbit, radius, 8, 1e-12);
+  qd_real cr = v.re + 0.3 * radius, ci = v.im - 0.4 * radius;
+  qd_real x = 0.0, y = 0.0;
+  for (int n = 0; n < series.skip; n++) {
+    qd_real xy = x * y;
+    x = sqr(x) - sqr(y) + cr;
+    y = mul_pwr2(xy, 2.0) + ci;
+  }
+  double dzr, dzi;
+  series.evaluate(0.3, -0.4, dzr, dzi);
+  qd_real er = x - qd_real(orbit.zr[series.skip]);
+  qd_real ei = y - qd_real(orbit.zi[series.skip]);
+  /* Z(skip) was rounded to double in the orbit: compare in qd. */
+  double err = std::hypot(to_double(er - dzr), to_double(ei - dzi));
+  double mag = std::hypot(dzr, dzi);
+  if (flag_verbose)
+    cout << "  |dz(" << series.skip << ")| = " << mag
+         << ", relative error " << err / mag << endl;
+
+  return s1.series_skip > 1000 && s2.series_skip == 0 &&
+         s1.iterations < s2.iterations &&
+         bad * 100 < static_cast<int>(with.size()) &&
+         err < 1e-9 * mag;
+}
+
+/* Test 5.  A view whose single reference leaves many pixels glitched:
+   they are detected and rendered again against new references.      */
+bool test5() {
+  cout << endl;
+  cout << "Test 5.  (Glitch correction)." << endl;
+
+  qd_mandel_view v(qd_real("-0.74364388703715870475219"),
+                   qd_real("0.13182590420531197049313"),
+                   1e-15, 64, 48, 20000);
+  std::vector<float> counts;
+  qd_mandel_stats stats;
+  if (qd_mandel_render(v, counts, qd_mandel_options(), &stats) != 0)
+    return false;
+  int bad = count_mismatches<qd_real>(v, counts, 8, 256.0);
+
+  qd_mandel_options opt;
+  opt.glitch_tolerance = 0.0;
+  std::vector<float> plain;
+  qd_mandel_render(v, plain, opt);
+  if (flag_verbose) {
+    int wrong = count_mismatches<qd_real>(v, plain, 8, 256.0);
+    cout << "  " << stats.glitched << " pixels glitched, "
+         << stats.references << " references; " << wrong
+         << " pixels wrong without correction" << endl;
+  }
+
+  return bad == 0 && stats.glitched > 0 && stats.references > 1 &&
+         stats.references <= opt.max_references;
+}
+
+/* Test 6.  Progressive passes and small tiles give the same image,
+   and so do the direct dd_real and qd_real kernels.                */
+bool test6() {
+  cout << endl;
+  cout << "Test 6.  (Tiles, passes and kernels)." << endl;
+
+  qd_mandel_view v(-0.5, 0.0, 1.5, 120, 90, 500);
+  std::vector<float> base;
+  if (qd_mandel_render(v, base) != 0)
+    return false;
+
+  bool pass = true;
+  const char *names[] = { "4 passes, 7x7 tiles", "direct dd_real",
+                          "direct qd_real" };
+  for (int k = 0; k < 3; k++) {
+    qd_mandel_options opt;
+    if (k == 0) {
+      opt.passes = 4;
+      opt.tile_size = 7;
+    } else {
+      opt.kernel = (k == 1) ? qd_mandel_direct_dd : qd_mandel_direct_qd;
+    }
+    std::vector<float> counts;
+    if (qd_mandel_render(v, counts, opt) != 0)
+      return false;
+    int bad = 0;
+    for (size_t i = 0; i < counts.size(); i++)
+      bad += !same_count(counts[i], base[i]);
+    if (flag_verbose)
+      cout << "  " << names[k] << ": " << bad << " pixels differ" << endl;
+    pass &= (bad * 200 < static_cast<int>(counts.size()));
+  }
+
+  qd_mandel_options opt;
+  opt.passes = 0;
+  std::vector<float> counts;
+  return pass && qd_mandel_render(v, counts, opt) == -1;
+}
+
+int passes_seen = 0;
+
+void count_pass(int) { passes_seen++; }
+
+/* Test 7.  The background renderer refines pass by pass, restarts on
+   a new view and can be cancelled.                                  */
+bool test7() {
+  cout << endl;
+  cout << "Test 7.  (Background renderer)." << endl;
+
+  qd_mandel_options opt;
+  opt.passes = 3;
+  qd_mandel_renderer r(opt, count_pass);
+  std::vector<float> counts;
+
+  /* A slow view, replaced at once by a quick one. */
+  qd_mandel_view slow(-0.5, 0.0, 1.5, 400, 300, 1000000);
+  qd_mandel_view quick(-0.5, 0.0, 1.5, 120, 90, 500);
+  if (r.start(slow) != 0 || r.start(quick) != 0)
+    return false;
+  bool completed = r.wait();
+  int pass = r.snapshot(counts);
+
+  std::vector<float> ref;
+  qd_mandel_render(quick, ref, opt);
+  bool same = (counts == ref);
+  if (flag_verbose)
+    cout << "  completed " << completed << " after " << pass
+         << " passes, " << passes_seen << " callbacks, image "
+         << (same ? "matches" : "differs") << endl;
+  if (!completed || pass != 3 || !same || passes_seen < 3 ||
+      r.stats().iterations <= 0)
+    return false;
+
+  /* Cancelling the slow view stops it early. */
+  r.start(slow);
+  r.cancel();
+  completed = r.wait();
+  return !completed && r.start(qd_mandel_view(0.0, 0.0, -1.0)) == -1;
+}
+
+/* Test 8.  Frames of a zoom and a pan reuse the cached orbit, and an
+   orbit spilled to disk comes back unchanged.                       */
+bool test8() {
+  cout << endl;
+  cout << "Test 8.  (Orbit cache)." << endl;
+
+  qd_real re("-0.743643887037158704752191506114774");
+  qd_real im("0.131825904205311970493132056385139");
+  qd_mandel_orbit_cache cache;
+  qd_mandel_options opt;
+  opt.orbit_cache = &cache;
+  std::vector<float> counts, plain;
+  qd_mandel_stats s1, s2, s3;
+
+  /* Zoom: the second frame is the first reference's own center. */
+  qd_mandel_render(qd_mandel_view(re, im, 1e-18, 64, 48, 16000), counts,
+                   opt, &s1);
+  qd_mandel_view zoom(re, im, 1e-20, 64, 48, 16000);
+  qd_mandel_render(zoom, counts, opt, &s2);
+  qd_mandel_render(zoom, plain);
+  bool pass = !s1.reference_cached && s2.reference_cached &&
+              counts == plain && cache.size() == 1;
+
+  /* Pan by half the view, with fewer iterations. */
+  qd_mandel_view pan(re + 0.5e-20, im - 0.25e-20, 1e-20, 64, 48, 12000);
+  qd_mandel_render(pan, counts, opt, &s3);
+  int bad = count_mismatches<qd_real>(pan, counts, 8, 256.0);
+  pass &= s3.reference_cached && bad == 0 && cache.size() == 1;
+  if (flag_verbose)
+    cout << "  panned frame: " << bad << " pixels differ from qd_real, "
+         << s3.references << " references" << endl;
+
+  /* A far away center evicts the first orbit to disk. */
+  qd_mandel_orbit_cache small(1, ".");
+  bool hit;
+  std::shared_ptr<const qd_mandel_orbit> a =
+      small.get(qd_mandel_view(re, im, 1e-20, 64, 48, 2000), 256.0, &hit);
+  small.get(qd_mandel_view(-0.5, 0.0, 1e-3, 64, 48, 2000), 256.0);
+  pass &= !hit && small.spilled() == 1 && small.size() == 2;
+  std::shared_ptr<const qd_mandel_orbit> b =
+      small.get(qd_mandel_view(re, im, 1e-20, 64, 48, 2000), 256.0, &hit);
+  pass &= hit && b != a && b->zr == a->zr && b->zi == a->zi &&
+          b->zr_lo == a->zr_lo && b->zi_lo == a->zi_lo;
+  if (flag_verbose)
+    cout << "  " << small.spilled() << " of " << small.size()
+         << " orbits on disk, " << small.memory() << " bytes in memory"
+         << endl;
+
+  /* Threads asking for the same new view at once share one orbit. */
+  std::vector<std::shared_ptr<const qd_mandel_orbit> > got(4);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < got.size(); i++)
+    threads.push_back(std::thread([&, i]() {
+      got[i] = cache.get(qd_mandel_view(-1.25, 0.0, 1e-3, 64, 48, 4000),
+                         256.0);
+    }));
+  for (size_t i = 0; i < threads.size(); i++)
+    threads[i].join();
+  pass &= cache.size() == 2;
+  for (size_t i = 1; i < got.size(); i++)
+    pass &= got[i] == got[0];
+  return pass;
+}
+
+/* Test 9.  The periodicity check stops interior pixels early, and
+   changes only pixels that lie within about its tolerance of the set;
+   distance estimates are positive exactly outside, and antialiasing
+   supersamples only near the boundary.                             */
+bool test9() {
+  cout << endl;
+  cout << "Test 9.  (Periodicity and distance estimation)." << endl;
+
+  qd_mandel_view v(-0.5, 0.0, 1.5, 120, 90, 2000);
+  qd_mandel_options off, on;
+  on.periodicity_tolerance = 1e-8;
+  std::vector<float> counts, plain, distance, plain_distance;
+  qd_mandel_stats s1, s2;
+  qd_mandel_render(v, plain, plain_distance, off, &s1);
+  if (qd_mandel_render(v, counts, distance, on, &s2) != 0)
+    return false;
+  bool pass = s1.periodic == 0 && s2.periodic > 0 &&
+              s2.iterations < 0.5 * s1.iterations;
+
+  /* Direct kernels use the same check, and skip dz/dc without it. */
+  qd_mandel_options dd = on;
+  dd.kernel = qd_mandel_direct_dd;
+  std::vector<float> direct, untracked;
+  qd_mandel_render(v, direct, dd);
+  dd.periodicity_tolerance = 0.0;
+  qd_mandel_render(v, untracked, dd);
+
+  int changed = 0;
+  size_t exterior = 0;
+  for (size_t i = 0; i < counts.size(); i++) {
+    pass &= (counts[i] < 0.0f) ? distance[i] == 0.0f : distance[i] > 0.0f;
+    pass &= (direct[i] < 0.0f) == (counts[i] < 0.0f);
+    pass &= (direct[i] < 0.0f) || direct[i] == untracked[i];
+    if (counts[i] != plain[i]) {
+      pass &= counts[i] < 0.0f && plain_distance[i] < 1e-6f;
+      changed++;
+    }
+    exterior += (counts[i] >= 0.0f);
+  }
+  if (flag_verbose)
+    cout << "  " << s2.periodic << " pixels stopped early, " << changed
+         << " on the boundary, " << s2.iterations << " iterations against "
+         << s1.iterations << endl;
+
+  qd_mandel_options aa;
+  aa.antialias = 4;
+  qd_mandel_stats s3;
+  qd_mandel_render(v, counts, aa, &s3);
+  pass &= s3.supersampled > 0 &&
+          static_cast<size_t>(s3.supersampled) < exterior;
+  if (flag_verbose)
+    cout << "  " << s3.supersampled << " pixels supersampled in "
+         << s3.seconds << " s" << endl;
+
+  std::vector<float> none;
+  aa.antialias = 0;
+  pass &= qd_mandel_render(v, none, aa) == -1;
+  aa.antialias = 17;
+  pass &= qd_mandel_render(v, none, aa) == -1;
+  return pass;
+}
+
+/* Test 10.  Newton's method finds nuclei to qd_real precision, and a
+   deep one serves as the reference of the views around it.        */
+bool test10() {
+  cout << endl;
+  cout << "Test 10.  (Nucleus finder)." << endl;
+
+  /* The period 3 nucleus on the real axis is the real root of
+     c^3 + 2 c^2 + c + 1, z(3) at c.                              */
+  qd_mandel_nucleus n;
+  bool pass = qd_mandel_find_nucleus(-1.7, 0.0, 3, n) == 0;
+  qd_real c = n.re;
+  pass &= n.period == 3 && n.im == 0.0 &&
+          std::fabs(to_double(((c + 2.0) * c + 1.0) * c + 1.0)) < 1e-60;
+
+  /* Period 4 also holds at c = -1, of least period 2. */
+  pass &= qd_mandel_find_nucleus(-1.1, 0.1, 4, n) == 0 && n.period == 2 &&
+          std::fabs(to_double(n.re + 1.0)) < 1e-60 &&
+          std::fabs(to_double(n.im)) < 1e-60 && n.size == 1.0;
+
+  /* A period 998 miniature set near the view of test 2. */
+  qd_real re("-0.743643887037158704752191506114774");
+  qd_real im("0.131825904205311970493132056385139");
+  qd_mandel_nucleus deep;
+  pass &= qd_mandel_find_nucleus(re + 2e-16, im - 1e-16, 998, deep) == 0 &&
+          deep.period == 998 && deep.size > 0.0 && deep.size < 1e-5;
+  qd_real zr = 0.0, zi = 0.0;
+  for (int k = 0; k < 998; k++) {
+    qd_real xy = zr * zi;
+    zr = sqr(zr) - sqr(zi) + deep.re;
+    zi = mul_pwr2(xy, 2.0) + deep.im;
+  }
+  double z = std::hypot(to_double(zr), to_double(zi));
+  if (flag_verbose)
+    cout << "  period " << deep.period << " after " << deep.steps
+         << " steps, atom domain size " << deep.size << ", |z(998)| = "
+         << z << endl;
+  pass &= z < 1e-45;
+
+  /* Its orbit never escapes, so it serves the whole view. */
+  qd_mandel_orbit_cache cache;
+  cache.add(deep.re, deep.im, 5000, 256.0);
+  qd_mandel_options opt;
+  opt.orbit_cache = &cache;
+  qd_mandel_view v(deep.re + 3e-16, deep.im, 1e-15, 64, 48, 5000);
+  std::vector<float> counts;
+  qd_mandel_stats stats;
+  qd_mandel_render(v, counts, opt, &stats);
+  int bad = count_mismatches<qd_real>(v, counts, 8, 256.0);
+  pass &= stats.reference_cached && stats.reference_length == 5000 &&
+          bad == 0;
+  if (flag_verbose)
+    cout << "  " << bad << " pixels differ from qd_real, "
+         << stats.references << " references" << endl;
+
+  pass &= qd_mandel_find_nucleus(0.0, 0.0, 0, n) == -1 && errno == EINVAL;
+  return pass;
+}
+
+int main(int argc, char *argv[]) {
+  bool pass = true;
+  unsigned int old_cw;
+  fpu_fix_start(&old_cw);
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "-verbose") == 0)
+      flag_verbose = true;
+    else
+      cerr << "Unknown flag `" << argv[i] << "'." << endl;
+  }
+
+  pass &= print_result(test1());
+  pass &= print_result(test2());
+  pass &= print_result(test3());
+  pass &= print_result(test4());
+  pass &= print_result(test5());
+  pass &= print_result(test6());
+  pass &= print_result(test7());
+  pass &= print_result(test8());
+  pass &= print_result(test9());
+  pass &= print_result(test10());
+
+  fpu_fix_end(&old_cw);
+  return (pass ? 0 : 1);
+}
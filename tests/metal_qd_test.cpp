@@ -8,13 +8,24 @@
   qvq = 1.000000000000000000000000000025
   vq = 0x1p+0 0x1p-95 0x0p+0 0x0p+0
   d = 1 0x1p+0
-*/
+  1/3 = 0.333333333333333333333333333332
+  math: ok
+  df: ok
+  qdx: ok
+  kernel: 33153 threads ... ok
 
-#import <simd/simd.h>
+  Apple's <simd/simd.h> is used where available; elsewhere metal_qd.h
+  provides simd::float4.  The kernel test runs on all cores through
+  metal_cpu.h.
+*/
 
 #include "metal_qd.h"
+#include "metal_df.h"
+#include "metal_qdx.h"
+#include "metal_cpu.h"
 
-#import <iostream>
+#include <iostream>
+#include <vector>
 
 using namespace std;
 
@@ -26,6 +37,145 @@ using namespace std;
 #error "Must define QDT_double or QDT_float"
 #endif
 
+// Relative error of x against the reference r, in bits.
+double err_bits(const qd_real &x, const qd_real &r) {
+  qd_real d = x - r;
+  return d.is_zero() ? -200.0 : log2(fabs(d[0] / r[0]));
+}
+
+// Division, sqrt and the transcendentals of metal_qd_math.h against
+// correctly rounded values and against each other.
+bool test_math() {
+  struct { const char *name; qd_real x, ref; } t[] = {
+    {"1/3", qd_real(1.0f) / qd_real(3.0f),
+     qd_real(3.333333433e-01f, -9.934107759e-09f, 2.960594821e-16f, -8.823260130e-24f)},
+    {"sqrt(2)", sqrt(qd_real(2.0f)),
+     qd_real(1.414213538e+00f, 2.420323497e-08f, -7.628067438e-16f, -4.073211892e-24f)},
+    {"exp(1.5)", exp(qd_real(1.5f)),
+     qd_real(4.481688976e+00f, 9.405022183e-08f, 1.192996037e-15f, -2.187742426e-23f)},
+    {"exp(-20.25)", exp(qd_real(-20.25f)),
+     qd_real(1.605228062e-09f, -6.399639560e-18f, 1.702187175e-25f, -4.223612549e-33f)},
+    {"log(10)", log(qd_real(10.0f)),
+     qd_real(2.302585125e+00f, -3.197543563e-08f, -1.105254012e-15f, -3.031914314e-23f)},
+    {"sin(1)", sin(qd_real(1.0f)),
+     qd_real(8.414709568e-01f, 2.800552856e-08f, -2.202677548e-16f, -5.037277227e-24f)},
+    {"cos(1)", cos(qd_real(1.0f)),
+     qd_real(5.403022766e-01f, 2.925681208e-08f, -4.916987613e-16f, 5.317192686e-24f)},
+    {"sin(100)", sin(qd_real(100.0f)),
+     qd_real(-5.063656569e-01f, 1.574296249e-08f, 8.851274600e-16f, 1.268265877e-23f)},
+    {"cos(100)", cos(qd_real(100.0f)),
+     qd_real(8.623188734e-01f, -1.117772652e-09f, 4.334809891e-17f, -3.257334375e-25f)},
+    {"log(1e30)", log(qd_real(1e30f)),
+     qd_real(6.907755280e+01f, 9.458680061e-09f, 3.157894999e-16f, -1.659422951e-24f)},
+    {"log(2e38)", log(qd_real(2e38f)),
+     qd_real(8.819138336e+01f, -2.679454155e-06f, -7.715707820e-16f, -2.574822589e-23f)},
+    {"log(1e-30)", log(qd_real(1e-30f)),
+     qd_real(-6.907755280e+01f, 8.759862169e-09f, 4.064312632e-16f, 3.571696727e-24f)},
+    {"sqrt(1e30)", sqrt(qd_real(1e30f)),
+     qd_real(9.999999870e+14f, 2.053263000e+07f, -9.183649421e-01f, 6.759496962e-09f)},
+    {"sqrt(3e38)", sqrt(qd_real(3e38f)),
+     qd_real(1.732050772e+19f, 3.752505836e+11f, 1.504946289e+04f, 3.229653230e-04f)},
+  };
+  bool ok = true;
+  for (auto &c : t)
+    if (err_bits(c.x, c.ref) > -90.0) {
+      printf("%s: error 2^%.1f\n", c.name, err_bits(c.x, c.ref));
+      ok = false;
+    }
+
+  // sin^2 + cos^2 = 1, log(exp(a)) = a and sqrt(a)^2 = a over [-20, 88],
+  // where exp(a) reaches FLT_MAX / 2
+  for (int i = 1; i < 3996; i++) {
+    qd_real a = qd_real((float) i) / 37.0f - 20.0f, s, c;
+    sincos(a, s, c);
+    qd_real e = exp(a), r = sqrt(e);
+    double one = log2(fabs((sqr(s) + sqr(c) - 1.0f)[0]) + 1e-40);
+    double inv = log2(fabs((log(e) - a)[0]) / fmax(1.0, fabs(a[0])) + 1e-40);
+    if (one > -90.0 || inv > -90.0 || err_bits(sqr(r), e) > -90.0) {
+      printf("a = %.9g: error 2^%.1f 2^%.1f 2^%.1f\n", a[0], one, inv, err_bits(sqr(r), e));
+      ok = false;
+    }
+  }
+
+  ok &= exp(qd_real(-90.0f)).is_zero() && isinf(exp(qd_real(90.0f))[0]) &&
+        isnan(sqrt(qd_real(-1.0f))[0]) && isnan(log(qd_real(-1.0f))[0]);
+  qd_real nan_ = qd_real(NAN), inf_ = qd_real(INFINITY);
+  ok &= isnan(exp(nan_)[0]) && isnan(log(nan_)[0]) &&
+        isinf(log(inf_)[0]) && isnan(sin(inf_)[0]) &&
+        isnan(cos(-inf_)[0]) && isnan(sin(nan_)[0]);
+  return ok;
+}
+
+// df_real against double arithmetic, and the array functions against
+// the scalar operators.
+bool test_df() {
+  const int n = 1000;
+  vector<float> ah(n), al(n), bh(n), bl(n), ch(n), cl(n);
+  bool ok = true;
+  for (int i = 0; i < n; i++) {
+    double a = 1.0 + i / 7.0, b = 0.25 + i / 11.0;
+    df_real x = a, y = b;
+    ah[i] = x[0]; al[i] = x[1]; bh[i] = y[0]; bl[i] = y[1];
+    a = (double) x[0] + x[1];
+    b = (double) y[0] + y[1];
+
+    double r[] = {a + b, a - b, a * b, a / b, sqrt(a)};
+    df_real z[] = {x + y, x - y, x * y, x / y, sqrt(x)};
+    for (int k = 0; k < 5; k++) {
+      double e = fabs(((double) z[k][0] + z[k][1]) - r[k]) / fabs(r[k]);
+      if (!(e < ldexp(1.0, -44))) {
+        printf("df op %d at %d: error %g\n", k, i, e);
+        ok = false;
+      }
+    }
+  }
+
+  qd_cpu::df_mul_add(n, &ah[0], &al[0], &bh[0], &bl[0], &ah[0], &al[0], &ch[0], &cl[0]);
+  for (int i = 0; i < n; i++) {
+    df_real z = df_real(ah[i], al[i]) * df_real(bh[i], bl[i]) + df_real(ah[i], al[i]);
+    ok &= (z[0] == ch[i] && z[1] == cl[i]);
+  }
+  qd_cpu::df_div(n, &ah[0], &al[0], &bh[0], &bl[0], &ch[0], &cl[0]);
+  for (int i = 0; i < n; i++) {
+    df_real z = df_real(ah[i], al[i]) / df_real(bh[i], bl[i]);
+    ok &= (z[0] == ch[i] && z[1] == cl[i]);
+  }
+
+  qd_real q = to_qd_real(df_real(2.0f) / 3.0f);
+  ok &= fabs(to_double(q - qd_real(2.0f) / 3.0f)) < ldexp(1.0, -45) &&
+        df_real(to_float4(df_real(1.0f) / 3.0f)) == df_real(1.0f) / 3.0f &&
+        sqrt(df_real(0.0f)).is_zero() && isnan(sqrt(df_real(-1.0f))[0]);
+  return ok;
+}
+
+// qdx_real keeps full precision far below float's range, where the
+// limbs of qd_real underflow.
+bool test_qdx() {
+  bool ok = true;
+
+  // (7/9)^2000 is about 5e-219; dividing it back out should give 1.
+  qdx_real r = qdx_real(7.0f) / qdx_real(9.0f), x = 1.0f;
+  for (int i = 0; i < 2000; i++)
+    x *= r;
+  double mag = to_double(x);
+  ok &= mag > 1e-219 && mag < 1e-218;
+  for (int i = 0; i < 2000; i++)
+    x /= r;
+  qdx_real d = x - qdx_real(1.0f);
+  ok &= d.is_zero() || d.e + log2(fabs(d.m[0])) < -85.0;
+
+  // sums and square roots at 1e-300
+  qdx_real a = ldexp(qdx_real(qd_real(1.0f) / 3.0f), -1000), b = a * 3.0f;
+  qdx_real t = b - ldexp(qdx_real(1.0f), -1000);
+  ok &= t.is_zero() || t.e + log2(fabs(t.m[0])) < -1000 - 90;
+  qdx_real s = sqrt(sqr(a)) - a;
+  ok &= s.is_zero() || s.e + log2(fabs(s.m[0])) < a.e - 90;
+  ok &= fabs(to_double(a) / ldexp(1.0 / 3.0, -1000) - 1.0) < 1e-13;
+  ok &= a < b && b > a && a == a && a + a > a && -a < a;
+  ok &= (ldexp(qdx_real(1.0f), -200) + qdx_real(1.0f)) == qdx_real(1.0f);
+  return ok;
+}
+
 // A hack to print simple QD numbers.
 // Actual code to correctly print QD value is significantly more complex.
 // See to_string and to_digits in qd_real.cpp
@@ -69,5 +219,49 @@ int main() {
 
   printf("d = %g %a\n",d,d);   // d = 1 0x1p+0
 
-  return 0;
+  cout << "1/3 = "; print_qd(qd_real(1.0f) / 3.0f); cout << endl;
+  bool math_ok = test_math();
+  printf("math: %s\n", math_ok ? "ok" : "FAILED");
+  bool df_ok = test_df();
+  printf("df: %s\n", df_ok ? "ok" : "FAILED");
+  bool qdx_ok = test_qdx();
+  printf("qdx: %s\n", qdx_ok ? "ok" : "FAILED");
+
+  // Run a kernel over a 2D grid whose size is not a multiple of the
+  // threadgroup size, and compare with a serial loop.
+  const unsigned w = 257, h = 129;
+  std::vector<simd::float4> out(w * h), ref(w * h);
+  std::vector<int> visits(w * h, 0);
+  auto kernel = [&](const qd_cpu::thread_info &t) {
+    unsigned i = t.thread_position_in_grid.y * w + t.thread_position_in_grid.x;
+    qd_real c = q;
+    c *= (float) (i + 1);
+    qd_real z = c;
+    for (int k = 0; k < 8; k++)
+      z = sqr(z) * exp2(-20.f) + c;
+    out[i] = to_float4(z);
+    visits[i]++;
+  };
+
+  qd_cpu::thread_pool pool;
+  double secs = qd_cpu::dispatch_threads(pool, qd_cpu::uint3(w, h), qd_cpu::uint3(16, 8), kernel);
+
+  bool ok = true;
+  for (unsigned y = 0; y < h; y++)
+    for (unsigned x = 0; x < w; x++) {
+      qd_cpu::thread_info t;
+      t.thread_position_in_grid = qd_cpu::uint3(x, y);
+      unsigned i = y * w + x;
+      simd::float4 a = out[i];
+      visits[i]--;
+      kernel(t);
+      ref[i] = out[i];
+      ok &= (visits[i] == 1 && a.x == ref[i].x && a.y == ref[i].y &&
+             a.z == ref[i].z && a.w == ref[i].w);
+    }
+
+  printf("kernel: %u threads on %u cores in %.3g s ... %s\n",
+         w * h, pool.size(), secs, ok ? "ok" : "FAILED");
+
+  return ok && math_ok && df_ok && qdx_ok ? 0 : 1;
 }
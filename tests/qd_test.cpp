@@ -18,6 +18,13 @@
 #include <iomanip>
 #include <algorithm>
 #include <qd/qd_real.h>
+#if defined(__has_include)
+#if __has_include(<fmt/format.h>)
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+#endif
+#endif
+#include <qd/qd_format.h>
 #include <qd/fpu.h>
 
 using std::cout;
@@ -54,6 +61,13 @@ public:
   bool test6();
   bool test7();
   bool test8();
+  bool test9();
+  bool test10();
+  bool test11();
+  bool test12();
+  bool test13();
+  bool test14();
+  bool test15();
   bool testall();
 };
 
@@ -425,6 +439,349 @@ bool TestSuite<T>::test8() {
   return (delta < 4.0 * T::_eps);
 }
 
+/* Test 9.  Precision-tunable exp / log / sin / cos. */
+template <class T>
+bool TestSuite<T>::test9() {
+  cout << endl;
+  cout << "Test 9.  (Precision-tunable transcendentals)." << endl;
+
+  /* Compare the reduced precision results against the full precision
+     ones at a quarter, half and three quarters of the full precision. */
+  const int digits = std::numeric_limits<T>::digits;
+  T x = T::_pi / 7.0 + 3.0;
+  T full_exp = exp(x), full_log = log(x);
+  T full_sin = sin(x), full_cos = cos(x);
+  bool pass = true;
+
+  for (int i = 1; i <= 3; i++) {
+    int bits = i * digits / 4;
+    double tol = 4.0 * std::ldexp(1.0, -bits);
+    double e_exp = abs(to_double((exp(x, bits) - full_exp) / full_exp));
+    double e_log = abs(to_double(log(x, bits) - full_log));
+    double e_sin = abs(to_double(sin(x, bits) - full_sin));
+    double e_cos = abs(to_double(cos(x, bits) - full_cos));
+    double err = std::max(std::max(e_exp, e_log), std::max(e_sin, e_cos));
+
+    if (flag_verbose) {
+      cout.precision(double_digits);
+      cout << std::setw(4) << bits << " bits: error = " << err
+           << " (tolerance " << tol << ")" << endl;
+    }
+
+    pass &= (err < tol);
+  }
+
+  /* Asking for more than the full precision gives the full result. */
+  pass &= (exp(x, 4 * digits) == full_exp && sin(x, 4 * digits) == full_sin);
+
+  return pass;
+}
+
+/* Test 10.  pow and nroot. */
+template <class T>
+bool TestSuite<T>::test10() {
+  cout << endl;
+  cout << "Test 10.  (pow and nroot)." << endl;
+
+  /* The integer, half-integer and general paths of pow are checked
+     against products, square roots and exp(b * log(a)); nroot is
+     checked by raising the result back to the n-th power.          */
+  T x = T::_pi / 7.0 + 3.0;
+  T y = T::_e / 3.0;
+
+  double e_int = abs(to_double((pow(x, T(-3.0)) * x * sqr(x) - 1.0)));
+  double e_half = abs(to_double((pow(x, T(2.5)) - sqr(x) * sqrt(x)) / 
+                                pow(x, T(2.5))));
+  double e_gen = abs(to_double((pow(x, y) - exp(y * log(x))) / pow(x, y)));
+  double e_root = 0.0;
+  for (int n = 3; n <= 17; n += 7)
+    e_root = std::max(e_root, abs(to_double((npwr(nroot(x, n), n) - x) / x)));
+
+  double err = std::max(std::max(e_int, e_half), std::max(e_gen, e_root));
+
+  if (flag_verbose) {
+    cout.precision(double_digits);
+    cout << " error = " << err << " = " << (err / T::_eps) << " eps" << endl;
+  }
+
+  return (err < 32.0 * T::_eps);
+}
+
+/* Test 11.  erf, erfc, tgamma and lgamma. */
+template <class T>
+bool TestSuite<T>::test11() {
+  cout << endl;
+  cout << "Test 11.  (Error and gamma functions)." << endl;
+
+  /* Values computed with 75 digit arithmetic. */
+  T erf1 = T("0.842700792949714869341220635082609259296066997966302908459937897834717254096");
+  T erfc10 = T("2.08848758376254475700078629495778861156081811932116372701221371393817469583e-45");
+  T lgamma10_5 = T("13.9406252194037636331612378879718494797994528048474955812462859023236712454");
+  T gamma171_5 = T("9.48336756682479933625340546920495158937563910974316253961413953077740993600e307");
+  T sqrt_pi = sqrt(T::_pi);
+
+  double e_erf = std::max(abs(to_double((erf(T(1.0)) - erf1) / erf1)),
+                          abs(to_double((erfc(T(10.0)) - erfc10) / erfc10)));
+  for (double x = -2.7; x < 12.0; x += 1.1)
+    e_erf = std::max(e_erf, abs(to_double(erf(T(x)) + erfc(T(x)) - 1.0)));
+
+  double e_gamma = abs(to_double((tgamma(T(0.5)) - sqrt_pi) / sqrt_pi));
+  e_gamma = std::max(e_gamma, abs(to_double(
+      (tgamma(T(-1.5)) * 3.0 - 4.0 * sqrt_pi) / (4.0 * sqrt_pi))));
+  e_gamma = std::max(e_gamma, 
+      abs(to_double((lgamma(T(10.5)) - lgamma10_5) / lgamma10_5)));
+  bool exact = (tgamma(T(6.0)) == 120.0 && lgamma(T(2.0)) == 0.0);
+
+  /* Near the top of the double range, where exp(lgamma(a)) carries
+     the absolute error of lgamma, about 709 eps, as relative error. */
+  double e_top = abs(to_double((tgamma(T(171.5)) - gamma171_5) / gamma171_5));
+
+  if (flag_verbose) {
+    cout.precision(double_digits);
+    cout << "  erf error = " << e_erf << " = " << (e_erf / T::_eps) 
+         << " eps" << endl;
+    cout << "gamma error = " << e_gamma << " = " << (e_gamma / T::_eps) 
+         << " eps" << endl;
+    cout << "  Gamma(171.5) error = " << e_top << " = " << (e_top / T::_eps)
+         << " eps" << endl;
+  }
+
+  return (exact && e_erf < 8.0 * T::_eps && e_gamma < 64.0 * T::_eps &&
+          e_top < 1024.0 * T::_eps);
+}
+
+/* Test 12.  Decimal conversion. */
+template <class T>
+bool TestSuite<T>::test12() {
+  cout << endl;
+  cout << "Test 12.  (Decimal conversion)." << endl;
+
+  /* Write numbers across the exponent range with two guard digits
+     and read them back.                                         */
+  double err = 0.0;
+  for (int e = -280; e <= 300; e += 9) {
+    T x = T::_pi * std::pow(10.0, e) / 7.0;
+    T y(x.to_string(T::_ndigits + 2, 0, std::ios_base::scientific).c_str());
+    err = std::max(err, abs(to_double((y - x) / x)));
+  }
+  /* Near DBL_MAX, where the scaling by 10^-308 must not overflow. */
+  static const double top[] = { 1.7976931348623157e308, 1e308, 3e307 };
+  for (int i = 0; i < 3; i++) {
+    T x = T(top[i]) * (1.0 - T::_eps);
+    T y(x.to_string(T::_ndigits + 2, 0, std::ios_base::scientific).c_str());
+    err = std::max(err, abs(to_double((y - x) / x)));
+  }
+
+  /* More digits than the working precision. */
+  T pi("3.14159265358979323846264338327950288419716939937510582097494459230781640628620899862803482534211706798");
+  err = std::max(err, abs(to_double((pi - T::_pi) / T::_pi)));
+
+  /* Fixed notation keeps every digit of exact powers of ten, up to
+     the working precision.                                      */
+  bool parsed = (T(0.1).to_string(5, 0, std::ios_base::fixed) == "0.10000");
+  T ten = 1.0;
+  for (int e = 0; e + 4 <= T::_ndigits; e++, ten *= 10.0) {
+    std::string s = "1" + std::string(e, '0') + ".000";
+    parsed &= (ten.to_string(3, 0, std::ios_base::fixed) == s);
+  }
+
+  /* As in QD 2.3, read ignores text after an exponent. */
+  T w;
+  parsed &= (w.read(" -1.5e3", w) == 0 && w == -1500.0);
+  parsed &= (w.read("2.5e-1abc", w) == 0 && w == 0.25);
+  parsed &= (w.read("2x", w) == -1 && w.read("2ex", w) == -1 &&
+             w == 0.25);
+
+#if QD_HAVE_CXX17
+  const char *s = " -0.0025e+3, 1";
+  T z;
+  const char *p = T::parse(s, z);
+  parsed &= (p == s + 11 && z == -2.5 && T::parse(".e1", z) == 0);
+
+  /* to_chars: exact layouts, and the shortest form reads back to
+     within eps (not necessarily to the same value). */
+  char buf[128];
+  std::to_chars_result r = to_chars(buf, buf + sizeof(buf), T("0.1"));
+  parsed &= (std::string(buf, r.ptr) == "0.1");
+  r = to_chars(buf, buf + sizeof(buf), T(-1234.56), 
+               std::chars_format::scientific, 3);
+  parsed &= (std::string(buf, r.ptr) == "-1.235e+03");
+  r = to_chars(buf, buf + sizeof(buf), T(2.0) / 3.0, 
+               std::chars_format::fixed, 3);
+  parsed &= (std::string(buf, r.ptr) == "0.667");
+  r = to_chars(buf, buf + 4, T::_pi);
+  parsed &= (r.ec == std::errc::value_too_large);
+
+  T x = T::_pi / 7.0;
+  r = to_chars(buf, buf + sizeof(buf), x);
+  T::parse(std::string_view(buf, r.ptr - buf), z);
+  err = std::max(err, abs(to_double((z - x) / x)));
+#endif
+
+  if (flag_verbose) {
+    cout.precision(double_digits);
+    cout << " error = " << err << " = " << (err / T::_eps) << " eps" << endl;
+  }
+
+  return (parsed && err < 4.0 * T::_eps);
+}
+
+/* Test 13.  Hexadecimal conversion is exact. */
+template <class T>
+bool TestSuite<T>::test13() {
+  cout << endl;
+  cout << "Test 13.  (Hexadecimal conversion)." << endl;
+
+  const int n = sizeof(T::_pi.x) / sizeof(double);
+  const std::ios_base::fmtflags hex = 
+    std::ios_base::fixed | std::ios_base::scientific;
+  bool pass = true;
+  for (int e = -300; e <= 300; e += 7) {
+    T x = T::_pi * std::pow(10.0, e) / -7.0;
+    if (e > 0) x = -x;
+    std::string s = x.to_string(0, 0, hex);
+    T y;
+    y.read(s.c_str(), y);
+    for (int i = 0; i < n; i++)
+      pass &= (y.x[i] == x.x[i]);
+    if (flag_verbose && e == 1)
+      cout << " " << s << endl;
+  }
+
+  /* Subnormal leading limb, and limbs given with their signs. */
+  T z(std::ldexp(3.0, -1070));
+  T w(z.to_string(0, 0, hex).c_str());
+  pass &= (w == z);
+  w = T("0x1.8p+0-0x1p-60");
+  pass &= (w == T(1.5) - std::ldexp(1.0, -60));
+  pass &= (T(1.5).to_string(0, 0, hex) == "0x1.8p+0");
+  pass &= (T(-0.75).to_string(0, 0, hex, false, true) == "-0X1.8P-1");
+
+#if QD_HAVE_CXX17
+  char buf[128];
+  T x = T::_pi / 7.0;
+  std::to_chars_result r = to_chars(buf, buf + sizeof(buf), x, 
+                                    std::chars_format::hex);
+  T y;
+  pass &= (T::parse(std::string_view(buf, r.ptr - buf), y) == r.ptr);
+  for (int i = 0; i < n; i++)
+    pass &= (y.x[i] == x.x[i]);
+#endif
+
+  return pass;
+}
+
+/* Test 14.  std::format. */
+template <class T>
+bool TestSuite<T>::test14() {
+  cout << endl;
+  cout << "Test 14.  (std::format and fmt)." << endl;
+
+  bool pass = true;
+#if defined(FMT_VERSION) && QD_HAVE_CXX17
+  {
+    T x = T(-1234.5678);
+    pass &= (fmt::format("{}", T::_pi) == T::_pi.to_string());
+    pass &= (fmt::format("{:.3f}", x) == "-1234.568");
+    pass &= (fmt::format("{:+12.3E}", T::_pi) == "  +3.142E+00");
+    pass &= (fmt::format("{: .2e}", T::_pi) == " 3.14e+00");
+    pass &= (fmt::format("{:*^14.2f}", x) == "***-1234.57***");
+    pass &= (fmt::format("{:<10.1f}|", x) == "-1234.6   |");
+    pass &= (fmt::format("{:>10.1f}", x) == "   -1234.6");
+    pass &= (fmt::format("{:010.2f}", x) == "-001234.57");
+    pass &= (fmt::format("{:.4g}", x) == "-1235");
+    pass &= (fmt::format("{:a}", T(1.5)) == "0x1.8p+0");
+    pass &= (fmt::format("{:A}", T(-1.5)) == "-0X1.8P+0");
+    pass &= (fmt::format("{}", T::_nan) == "nan");
+    pass &= (fmt::format("{:+}", T::_inf) == "+inf");
+    pass &= (fmt::format("{:F}", -T::_inf) == "-INF");
+    pass &= (fmt::format("{:06f}", T::_inf) == "   inf");
+    if (flag_verbose)
+      cout << fmt::format(" {:.20g}", T::_pi) << endl;
+  }
+#endif
+#if defined(__cpp_lib_format)
+  T x = T(-1234.5678);
+  pass &= (std::format("{}", T::_pi) == T::_pi.to_string());
+  pass &= (std::format("{:.3f}", x) == "-1234.568");
+  pass &= (std::format("{:+12.3E}", T::_pi) == "  +3.142E+00");
+  pass &= (std::format("{:*^14.2f}", x) == "***-1234.57***");
+  pass &= (std::format("{:010.2f}", x) == "-001234.57");
+  pass &= (std::format("{:a}", T(1.5)) == "0x1.8p+0");
+  if (flag_verbose)
+    cout << std::format(" {:.20g}", T::_pi) << endl;
+#elif !defined(FMT_VERSION)
+  if (flag_verbose)
+    cout << " Neither std::format nor fmt is available." << endl;
+#endif
+  return pass;
+}
+
+/* Test 15.  exp, log, sin and cos across their range, checked
+   against qd_real, and non-finite arguments.                    */
+template <class T>
+bool TestSuite<T>::test15() {
+  cout << endl;
+  cout << "Test 15.  (Transcendentals across the range)." << endl;
+
+  double e_exp = 0.0, e_log = 0.0, e_trig = 0.0;
+  for (double x = -700.0; x < 700.0; x += 13.7) {
+    T a = T(x) + T::_pi / 1000.0;
+    qd_real r = exp(qd_real(a));
+    e_exp = std::max(e_exp, abs(to_double((qd_real(exp(a)) - r) / r)));
+  }
+  for (int e = -1000; e <= 1000; e += 37) {
+    T a = ldexp(T::_e / 2.0, e);
+    qd_real r = log(qd_real(a));
+    e_log = std::max(e_log, abs(to_double(qd_real(log(a)) - r)) /
+                            std::max(1.0, abs(to_double(r))));
+  }
+  /* The reduction modulo pi/2 loses about log2|x| bits. */
+  for (double x = -100.0; x < 100.0; x += 0.37) {
+    T a = T(x) + T::_pi / 1000.0;
+    T s, c;
+    sincos(a, s, c);
+    double scale = std::max(1.0, std::abs(x));
+    double e = std::max(abs(to_double(qd_real(sin(a)) - sin(qd_real(a)))),
+                        abs(to_double(qd_real(cos(a)) - cos(qd_real(a)))));
+    e = std::max(e, std::max(abs(to_double(s - sin(a))),
+                             abs(to_double(c - cos(a)))));
+    e_trig = std::max(e_trig, e / scale);
+  }
+  /* Large arguments are first reduced modulo 2 pi.  (The comparison
+     is written so that NaN fails it.) */
+  bool large = true;
+  static const double big[] = { 1e5, -1e10, 1e17, -1e20 };
+  for (int i = 0; i < 4; i++) {
+    T a = big[i];
+    double e = std::max(abs(to_double(qd_real(sin(a)) - sin(qd_real(a)))),
+                        abs(to_double(qd_real(cos(a)) - cos(qd_real(a)))));
+    large &= (e / std::abs(big[i]) < 4.0 * T::_eps);
+  }
+
+  /* Non-finite arguments give NaN (or the limit) and do not crash. */
+  T s, c;
+  sincos(T::_inf, s, c);
+  bool special = isnan(log(T::_nan)) && isnan(log(T::_inf)) &&
+                 isnan(sin(T::_nan)) && isnan(sin(-T::_inf)) &&
+                 isnan(cos(T::_inf)) && isnan(s) && isnan(c) &&
+                 isnan(exp(T::_nan)) && isinf(exp(T::_inf)) &&
+                 isinf(tgamma(T::_inf)) && isinf(lgamma(-T::_inf));
+
+  if (flag_verbose) {
+    cout.precision(double_digits);
+    cout << "  exp error = " << e_exp << " = " << (e_exp / T::_eps)
+         << " eps" << endl;
+    cout << "  log error = " << e_log << " = " << (e_log / T::_eps)
+         << " eps" << endl;
+    cout << "  sin/cos error = " << e_trig << " = " << (e_trig / T::_eps)
+         << " eps" << endl;
+  }
+
+  return (special && large && e_exp < 8.0 * T::_eps && e_log < 4.0 * T::_eps &&
+          e_trig < 4.0 * T::_eps);
+}
+
 template <class T>
 bool TestSuite<T>::testall() {
   bool pass = true;
@@ -436,6 +793,13 @@ bool TestSuite<T>::testall() {
   pass &= print_result(test6());
   pass &= print_result(test7());
   pass &= print_result(test8());
+  pass &= print_result(test9());
+  pass &= print_result(test10());
+  pass &= print_result(test11());
+  pass &= print_result(test12());
+  pass &= print_result(test13());
+  pass &= print_result(test14());
+  pass &= print_result(test15());
   return pass;
 }
 